@@ -18,6 +18,63 @@ const char PROGMEM _Base64AlphabetTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 		"abcdefghijklmnopqrstuvwxyz"
 		"0123456789+/";
 
+// value of each character, 0xFF for characters which are not part of the alphabet (also '=')
+// (in flash like the alphabet, pgm_read_byte() saves 256 bytes of RAM for one extra load per character)
+static const uint8_t PROGMEM _Base64DecodeTable[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   62, 0xFF, 0xFF, 0xFF,   63,
+	  52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+	  15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+	  41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// characters of a group are combined in one word (first character in the lowest byte),
+// an invalid character sets the highest bit of its byte
+static const uint32_t INVALID_MASK = 0x80808080;
+
+/*
+Combine four sextets s0..s3 (one per byte) to the 24 bits s0 s1 s2 s3:
+first pairs in both halves of the word at once, then the two halves
+*/
+static inline uint32_t packSextets(uint32_t sextets) {
+	uint32_t pairs = ((sextets & 0x003F003F) << 6) | ((sextets >> 8) & 0x003F003F);
+	return ((pairs & 0xFFFF) << 12) | (pairs >> 16);
+}
+
+/*
+Decode complete groups of 4 characters, stops in front of the first group with
+an invalid character. Returns the number of decoded groups.
+*/
+static int decodeGroups(unsigned char * output, const unsigned char * input, int groups) {
+	int n;
+	for(n = 0; n < groups; n++) {
+		uint32_t sextets = pgm_read_byte(&_Base64DecodeTable[input[0]]) | (uint32_t)pgm_read_byte(&_Base64DecodeTable[input[1]]) << 8
+				| (uint32_t)pgm_read_byte(&_Base64DecodeTable[input[2]]) << 16 | (uint32_t)pgm_read_byte(&_Base64DecodeTable[input[3]]) << 24;
+		if(sextets & INVALID_MASK) {
+			break;
+		}
+		uint32_t bits = packSextets(sextets);
+		// the group is read completely before writing, so output may be equal to input
+		output[0] = bits >> 16;
+		output[1] = bits >> 8;
+		output[2] = bits;
+		input += 4;
+		output += 3;
+	}
+	return n;
+}
+
 int Base64Class::encode(char *output, char *input, int inputLength) {
 	int i = 0, j = 0;
 	int encodedLength = 0;
@@ -57,47 +114,11 @@ int Base64Class::encode(char *output, char *input, int inputLength) {
 }
 
 int Base64Class::decode(char * output, char * input, int inputLength) {
-	int i = 0, j = 0;
-	int decodedLength = 0;
-	unsigned char A3[3];
-	unsigned char A4[4];
-
-
-	while (inputLength--) {
-		if(*input == '=') {
-			break;
-		}
-
-		A4[i++] = *(input++);
-		if (i == 4) {
-			for (i = 0; i <4; i++) {
-				A4[i] = lookupTable(A4[i]);
-			}
-
-			fromA4ToA3(A3,A4);
-
-			for (i = 0; i < 3; i++) {
-				output[decodedLength++] = A3[i];
-			}
-			i = 0;
-		}
-	}
-
-	if (i) {
-		for (j = i; j < 4; j++) {
-			A4[j] = '\0';
-		}
-
-		for (j = 0; j <4; j++) {
-			A4[j] = lookupTable(A4[j]);
-		}
-
-		fromA4ToA3(A3,A4);
-
-		for (j = 0; j < i - 1; j++) {
-			output[decodedLength++] = A3[j];
-		}
-	}
+	Base64Decoder decoder;
+	// the decoded data is always shorter than the text
+	decoder.begin(output, inputLength);
+	decoder.write(input, inputLength);
+	int decodedLength = decoder.end();
 	output[decodedLength] = '\0';
 	return decodedLength;
 }
@@ -110,7 +131,7 @@ int Base64Class::encodedLength(int plainLength) {
 int Base64Class::decodedLength(char * input, int inputLength) {
 	int i = 0;
 	int numEq = 0;
-	for(i = inputLength - 1; input[i] == '='; i--) {
+	for(i = inputLength - 1; i >= 0 && input[i] == '='; i--) {
 		numEq++;
 	}
 
@@ -125,19 +146,83 @@ inline void Base64Class::fromA3ToA4(unsigned char * A4, unsigned char * A3) {
 	A4[3] = (A3[2] & 0x3f);
 }
 
-inline void Base64Class::fromA4ToA3(unsigned char * A3, unsigned char * A4) {
-	A3[0] = (A4[0] << 2) + ((A4[1] & 0x30) >> 4);
-	A3[1] = ((A4[1] & 0xf) << 4) + ((A4[2] & 0x3c) >> 2);
-	A3[2] = ((A4[2] & 0x3) << 6) + A4[3];
+Base64Class Base64;
+
+void Base64Decoder::begin(char * output, int outputSize) {
+	_output = (unsigned char *)output;
+	_outputSize = outputSize;
+	_length = 0;
+	_bits = 0;
+	_count = 0;
+	_finished = false;
+}
+
+/*
+Decode the next piece of the text. Returns false if the end of the data ('=' or invalid
+character) was reached or the output buffer is full, the remaining input is ignored then.
+*/
+bool Base64Decoder::write(const char * input, int inputLength) {
+	const unsigned char * in = (const unsigned char *)input;
+	int i = 0;
+	if(_finished) {
+		return false;
+	}
+	// complete the group of the previous piece
+	while(_count > 0 && i < inputLength) {
+		if(!addChar(in[i++])) {
+			return false;
+		}
+	}
+	// complete groups directly from the input (as far as they fit into the output)
+	int groups = (inputLength - i) / 4;
+	if(groups > (_outputSize - _length) / 3) {
+		groups = (_outputSize - _length) / 3;
+	}
+	int decoded = decodeGroups(_output + _length, in + i, groups);
+	i += decoded * 4;
+	_length += decoded * 3;
+	// rest of the piece, the invalid character of a group or the group which does not fit any more
+	while(i < inputLength) {
+		if(!addChar(in[i++])) {
+			return false;
+		}
+	}
+	return !_finished;
 }
 
-inline unsigned char Base64Class::lookupTable(char c) {
-	if(c >='A' && c <='Z') return c - 'A';
-	if(c >='a' && c <='z') return c - 71;
-	if(c >='0' && c <='9') return c + 4;
-	if(c == '+') return 62;
-	if(c == '/') return 63;
-	return -1;
+/*
+Write the incomplete last group (text without padding or with '=') and
+return the total number of decoded bytes.
+*/
+int Base64Decoder::end() {
+	// 2 characters -> 1 byte, 3 characters -> 2 bytes
+	for(int j = 0; j < _count - 1 && _length < _outputSize; j++) {
+		_output[_length++] = _bits >> (_count * 6 - 8 * (j + 1));
+	}
+	_bits = 0;
+	_count = 0;
+	_finished = true;
+	return _length;
 }
 
-Base64Class Base64;
+inline bool Base64Decoder::addChar(unsigned char c) {
+	uint8_t value = pgm_read_byte(&_Base64DecodeTable[c]);
+	if(value & 0x80) {
+		_finished = true;
+		return false;
+	}
+	_bits = (_bits << 6) | value;
+	if(++_count == 4) {
+		if(_length + 3 > _outputSize) {
+			_count = 0;
+			_finished = true;
+			return false;
+		}
+		_output[_length++] = _bits >> 16;
+		_output[_length++] = _bits >> 8;
+		_output[_length++] = _bits;
+		_bits = 0;
+		_count = 0;
+	}
+	return true;
+}
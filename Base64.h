@@ -9,6 +9,8 @@ This library is distributed in the hope that it will be useful, but WITHOUT ANY
 #ifndef _BASE64_H
 #define _BASE64_H
 
+#include <stdint.h>
+
 class Base64Class{
   public:
     int encode(char *output, char *input, int inputLength);
@@ -18,9 +20,29 @@ class Base64Class{
 
   private:
     inline void fromA3ToA4(unsigned char * A4, unsigned char * A3);
-    inline void fromA4ToA3(unsigned char * A3, unsigned char * A4);
-    inline unsigned char lookupTable(char c);
 };
 extern Base64Class Base64;
 
+/*
+Streaming decoder: decodes the text in pieces of any length directly into the output buffer.
+Decoding stops at '=' or at the first character which is not part of the alphabet.
+The output may be the buffer of the text itself (in place), as the output never overtakes the input.
+*/
+class Base64Decoder{
+  public:
+    void begin(char * output, int outputSize);
+    bool write(const char * input, int inputLength);
+    int end();
+
+  private:
+    unsigned char * _output;
+    int _outputSize;
+    int _length;
+    uint32_t _bits;     // sextets of the incomplete group
+    uint8_t _count;     // number of characters in _bits
+    bool _finished;
+
+    bool addChar(unsigned char c);
+};
+
 #endif // _BASE64_H
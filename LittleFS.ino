@@ -28,8 +28,9 @@
 // Die Funktion "setupFS();" muss im Setup aufgerufen werden.
 /**************************************************************************************/
 
-#include <list>
-#include <tuple>
+#include <algorithm>
+#include <memory>
+#include <new>
 
 const char WARNING[] PROGMEM = R"(<h2>Der Sketch wurde mit "FS:none" kompilliert!)";
 const char HELPER[] PROGMEM = R"(<form method="POST" action="/upload" enctype="multipart/form-data">
@@ -45,55 +46,79 @@ void setupFS() {
   });
 }
 
+struct FileRecord {                                                                    // Eintrag der Dateiliste (LittleFS: Namen max. 31 Zeichen)
+  char folder[32];
+  char name[32];
+  size_t size;
+};
+
 bool handleList() {                                                                    // Senden aller Daten an den Client
   FSInfo fs_info;  LittleFS.info(fs_info);                                             // Füllt FSInfo Struktur mit Informationen über das Dateisystem
+  uint16_t count {0};
   Dir dir = LittleFS.openDir("/");
-  using namespace std;
-  using records = tuple<String, String, int>;
-  list<records> dirList;
-  while (dir.next()) {                                                                 // Ordner und Dateien zur Liste hinzufügen
+  while (dir.next()) {                                                                 // Einträge zählen, leere Ordner ergeben einen Eintrag
+    uint16_t files {0};
+    if (dir.isDirectory()) {
+      Dir fold = LittleFS.openDir(dir.fileName());
+      while (fold.next()) files++;
+    }
+    count += files ? files : 1;
+  }
+  std::unique_ptr<FileRecord[]> dirList(new (std::nothrow) FileRecord[count]);          // eine Allokation für die ganze Liste
+  if (!dirList) {
+    server.send(500, "text/plain", "Out of memory");
+    return true;
+  }
+  uint16_t n {0};
+  dir = LittleFS.openDir("/");
+  while (dir.next() && n < count) {                                                    // Ordner und Dateien zur Liste hinzufügen
     if (dir.isDirectory()) {
       uint8_t ran {0};
       Dir fold = LittleFS.openDir(dir.fileName());
-      while (fold.next())  {
+      while (fold.next() && n < count) {
         ran++;
-        dirList.emplace_back(dir.fileName(), fold.fileName(), fold.fileSize());
+        strlcpy(dirList[n].folder, dir.fileName().c_str(), sizeof(dirList[n].folder));
+        strlcpy(dirList[n].name, fold.fileName().c_str(), sizeof(dirList[n].name));
+        dirList[n++].size = fold.fileSize();
+      }
+      if (!ran && n < count) {
+        strlcpy(dirList[n].folder, dir.fileName().c_str(), sizeof(dirList[n].folder));
+        dirList[n].name[0] = '\0';
+        dirList[n++].size = 0;
       }
-      if (!ran) dirList.emplace_back(dir.fileName(), "", 0);
     }
     else {
-      dirList.emplace_back("", dir.fileName(), dir.fileSize());
+      dirList[n].folder[0] = '\0';
+      strlcpy(dirList[n].name, dir.fileName().c_str(), sizeof(dirList[n].name));
+      dirList[n++].size = dir.fileSize();
     }
   }
-  dirList.sort([](const records & f, const records & l) {                              // Dateien sortieren
-    if (server.arg(0) == "1") {
-      return get<2>(f) > get<2>(l);
-    } else {
-      for (uint8_t i = 0; i < 31; i++) {
-        if (tolower(get<1>(f)[i]) < tolower(get<1>(l)[i])) return true;
-        else if (tolower(get<1>(f)[i]) > tolower(get<1>(l)[i])) return false;
-      }
-      return false;
-    }
-  });
-  dirList.sort([](const records & f, const records & l) {                              // Ordner sortieren
-    if (get<0>(f)[0] != 0x00 || get<0>(l)[0] != 0x00) {
-      for (uint8_t i = 0; i < 31; i++) {
-          if (tolower(get<0>(f)[i]) < tolower(get<0>(l)[i])) return true;
-          else if (tolower(get<0>(f)[i]) > tolower(get<0>(l)[i])) return false;
-      }
-    }
-    return false;
+  const bool bySize = server.arg("sort") == "1";
+  std::sort(&dirList[0], &dirList[n], [bySize](const FileRecord & f, const FileRecord & l) {   // nach Ordner, dann nach Name oder Größe sortieren
+    int folder = strcasecmp(f.folder, l.folder);
+    if (folder != 0) return folder < 0;
+    if (bySize && f.size != l.size) return f.size > l.size;
+    return strcasecmp(f.name, l.name) < 0;
   });
-  String temp = "[";
-  for (auto& t : dirList) {
-    if (temp != "[") temp += ',';
-    temp += "{\"folder\":\"" + get<0>(t) + "\",\"name\":\"" + get<1>(t) + "\",\"size\":\"" + formatBytes(get<2>(t)) + "\"}";
+  char buffer[JSONWRITER_BUFFER_SIZE];                                                 // Antwort wird in Blöcken gesendet
+  char size[16];
+  JsonWriter json(buffer, sizeof(buffer), sendJSONChunk);
+  beginJSONResponse();
+  json.beginArray();
+  for (uint16_t i = 0; i < n; i++) {
+    json.beginObject();
+    json.add("folder", dirList[i].folder);
+    json.add("name", dirList[i].name);
+    json.add("size", formatBytes(dirList[i].size, size, sizeof(size)));
+    json.endObject();
   }
-  temp += ",{\"usedBytes\":\"" + formatBytes(fs_info.usedBytes) +                      // Berechnet den verwendeten Speicherplatz
-          "\",\"totalBytes\":\"" + formatBytes(fs_info.totalBytes) +                   // Zeigt die Größe des Speichers
-          "\",\"freeBytes\":\"" + (fs_info.totalBytes - fs_info.usedBytes) + "\"}]";   // Berechnet den freien Speicherplatz
-  server.send(200, "application/json", temp);
+  json.beginObject();
+  json.add("usedBytes", formatBytes(fs_info.usedBytes, size, sizeof(size)));           // Berechnet den verwendeten Speicherplatz
+  json.add("totalBytes", formatBytes(fs_info.totalBytes, size, sizeof(size)));         // Zeigt die Größe des Speichers
+  json.addFormatted("freeBytes", "%u", (unsigned)(fs_info.totalBytes - fs_info.usedBytes));   // Berechnet den freien Speicherplatz
+  json.endObject();
+  json.endArray();
+  endJSONResponse(json);
   return true;
 }
 
@@ -155,6 +180,9 @@ void sendResponce() {
   server.send(303, "message/http");
 }
 
-const String formatBytes(size_t const& bytes) {                                        // lesbare Anzeige der Speichergrößen
-  return bytes < 1024 ? static_cast<String>(bytes) + " Byte" : bytes < 1048576 ? static_cast<String>(bytes / 1024.0) + " KB" : static_cast<String>(bytes / 1048576.0) + " MB";
+const char *formatBytes(size_t bytes, char *text, size_t size) {                       // lesbare Anzeige der Speichergrößen
+  if (bytes < 1024) snprintf(text, size, "%u Byte", (unsigned)bytes);
+  else if (bytes < 1048576) snprintf(text, size, "%.2f KB", bytes / 1024.0);
+  else snprintf(text, size, "%.2f MB", bytes / 1048576.0);
+  return text;
 }
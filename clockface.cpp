@@ -0,0 +1,103 @@
+#include "clockface.h"
+
+// language packs, only needed at compile time (-> not stored in RAM or flash)
+
+static constexpr LanguageGrammar grammarGerman = {
+    "ESPISTAFUNFVIERTELZEHNZWANZIGUVORTECHNICNACHHALBMELFUNFXCONTROLLEREINSEAWZWEIDREITUMVIERSECHSQYACHTSIEBENZWOLFZEHNEUNJUHR",
+    "ES IST", nullptr,
+    {"", "FUNF NACH", "ZEHN NACH", "VIERTEL NACH", "ZEHN VOR HALB", "FUNF VOR HALB",
+     "HALB", "FUNF NACH HALB", "ZEHN NACH HALB", "VIERTEL VOR", "ZEHN VOR", "FUNF VOR"}, "", nullptr,
+    {"ZWOLF", "EINS", "ZWEI", "DREI", "VIER", "FUNF", "SECHS", "SIEBEN", "ACHT", "NEUN", "ZEHN", "ELF"}, "HALB",
+    "UHR", "EIN", 4
+};
+
+static constexpr LanguageGrammar grammarEnglish = {
+    "ITPISKTENNPQUARTERHALFTWENTYUFIVEMINUTESNATOPASTMEAONEFTWONTHREELRFOUREAWFIVEOSIXZUSEVENEIGHTELEVENUNINETWELVETENAWOCLOCK",
+    "IT IS", nullptr,
+    {"", "FIVE MINUTES PAST", "TEN MINUTES PAST", "QUARTER PAST", "TWENTY MINUTES PAST", "TWENTY FIVE MINUTES PAST",
+     "HALF PAST", "TWENTY FIVE MINUTES TO", "TWENTY MINUTES TO", "QUARTER TO", "TEN MINUTES TO", "FIVE MINUTES TO"}, "", nullptr,
+    {"TWELVE", "ONE", "TWO", "THREE", "FOUR", "FIVE", "SIX", "SEVEN", "EIGHT", "NINE", "TEN", "ELEVEN"}, "PAST",
+    "OCLOCK", nullptr, 7
+};
+
+// HINT: the special Italian letters (E' and L') are replaced with = and #
+// minutes "MENO ..." start at MENO, minutes "E ..." behind it (-> not the E of MENO, TRE, ...)
+static constexpr LanguageGrammar grammarItalian = {
+    "SONORLEBORE=R#UNASDUEZTREOTTONOVEDIECIUNDICIDODICISETTEQUATTROCSEICINQUEAMENOECUNOQUARTOVENTICINQUELVETENAWOCLDIECIPMEZZA",
+    "SONO LE", "= #",
+    {"", "E CINQUE", "E DIECI", "E UN QUARTO", "E VENTI", "E VENTICINQUE",
+     "E MEZZA", "MENO VENTICINQUE", "MENO VENTI", "MENO UN QUARTO", "MENO DIECI", "MENO CINQUE"}, "MENO", "MENO",
+    {"DODICI", "UNA", "DUE", "TRE", "QUATTRO", "CINQUE", "SEI", "SETTE", "OTTO", "NOVE", "DIECI", "UNDICI"}, "#",
+    "", nullptr, 7
+};
+
+// word masks of all languages (index = ClockLanguage), generated at compile time and stored in flash
+static constexpr ClockFaceTable clockFaceTables[NUM_LANGUAGES] PROGMEM = {
+    makeClockFaceTable(grammarGerman),
+    makeClockFaceTable(grammarEnglish),
+    makeClockFaceTable(grammarItalian)
+};
+static_assert(isClockFaceTableValid(clockFaceTables[lang_german]), "German: word of time sentence not found in clock layout");
+static_assert(isClockFaceTableValid(clockFaceTables[lang_english]), "English: word of time sentence not found in clock layout");
+static_assert(isClockFaceTableValid(clockFaceTables[lang_italian]), "Italian: word of time sentence not found in clock layout");
+
+// short names of the languages (index = ClockLanguage), used for /cmd?language=...
+static const char *languageNames[NUM_LANGUAGES] = {"de", "en", "it"};
+
+/**
+ * @brief Get the word mask which shows the given time
+ *
+ * @param language language pack (ClockLanguage)
+ * @param hours hours of the time value
+ * @param minutes minutes of the time value
+ * @return const WordMask* pointer to mask in flash (PROGMEM)
+ */
+const WordMask *getClockFaceMask(uint8_t language, uint8_t hours, uint8_t minutes){
+    if(language >= NUM_LANGUAGES){
+        language = lang_german;
+    }
+    return &clockFaceTables[language].masks[hours % 12][(minutes / 5) % 12];
+}
+
+/**
+ * @brief Get the short name of a language pack
+ *
+ * @param language language pack (ClockLanguage)
+ * @return const char* short name, e.g. "de"
+ */
+const char *getLanguageName(uint8_t language){
+    if(language >= NUM_LANGUAGES){
+        return "";
+    }
+    return languageNames[language];
+}
+
+/**
+ * @brief Find a language pack by its short name
+ *
+ * @param name short name, e.g. "en"
+ * @return int8_t language pack (ClockLanguage), -1 if not available
+ */
+int8_t findLanguage(const char *name){
+    for(uint8_t i = 0; i < NUM_LANGUAGES; i++){
+        if(strcmp(name, languageNames[i]) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Draw a word mask to the base layer of the ledmatrix, letters outside the mask are switched off
+ *
+ * @param matrix pointer to LEDMatrix object
+ * @param mask pointer to mask (in flash, PROGMEM)
+ * @param color 24bit color value of the letters
+ */
+void drawWordMask(LEDMatrix *matrix, const WordMask *mask, uint32_t color){
+    WordMask ramMask;
+    memcpy_P(&ramMask, mask, sizeof(WordMask));
+    for(uint8_t i = 0; i < CLOCKFACE_LETTERS; i++){
+        (*matrix).gridAddPixel(i % WIDTH, i / WIDTH, ramMask.isSet(i) ? color : 0);
+    }
+}
@@ -0,0 +1,211 @@
+/**
+ * @file clockface.h
+ * @brief Word bitmasks of the clock face, generated at compile time from language packs
+ * @version 0.2
+ * @date 2026-10-18
+ *
+ * A language pack (LanguageGrammar) consists of the letter layout (one string with WIDTH * HEIGHT letters,
+ * row by row) and the phrases for minutes and hours. At compile time the layout is searched for the words
+ * of each time sentence. The result is a table with one bitmask (one bit per letter) for each of the
+ * 12 x 12 five-minute time states, stored in flash. The layouts and phrases themselves are not needed at runtime.
+ * Showing the time is a table lookup, no Strings are built and no words are searched at runtime.
+ *
+ */
+
+#ifndef clockface_h
+#define clockface_h
+
+#include <Arduino.h>
+#include "ledmatrix.h"
+
+// number of letters on the clock face
+#define CLOCKFACE_LETTERS (WIDTH * HEIGHT)
+// number of 32bit words of one mask
+#define CLOCKFACE_MASK_WORDS ((CLOCKFACE_LETTERS + 31) / 32)
+// unused bit above the letters, set if a word of a sentence was not found in the layout
+#define CLOCKFACE_INVALID_BIT (CLOCKFACE_MASK_WORDS * 32 - 1)
+
+/**
+ * @brief One bit per letter of the clock face (index = y * WIDTH + x)
+ *
+ */
+struct WordMask {
+    uint32_t bits[CLOCKFACE_MASK_WORDS];
+
+    constexpr WordMask operator|(const WordMask &other) const {
+        WordMask result = {};
+        for(uint8_t i = 0; i < CLOCKFACE_MASK_WORDS; i++){
+            result.bits[i] = bits[i] | other.bits[i];
+        }
+        return result;
+    }
+
+    constexpr bool isSet(uint8_t index) const {
+        return (bits[index >> 5] >> (index & 31)) & 1;
+    }
+
+    constexpr bool isValid() const {
+        return !isSet(CLOCKFACE_INVALID_BIT);
+    }
+};
+
+// available language packs (frontplates)
+enum ClockLanguage {lang_german, lang_english, lang_italian, NUM_LANGUAGES};
+
+/**
+ * @brief Language pack: letter layout and grammar of the time sentences.
+ * A time sentence is: prefix + minute phrase + hour word (+ full hour suffix),
+ * each part is searched in the layout independently, beginning at its anchor.
+ *
+ */
+struct LanguageGrammar {
+    const char *layout;                 // letters of the clock face, row by row
+    const char *prefix;                 // e.g. "ES IST"
+    const char *prefixHourOne;          // prefix if hour one is shown (nullptr -> prefix)
+    const char *minutePhrases[12];      // index = minutes / 5, e.g. "FUNF NACH"
+    const char *minutesFrom;            // minute phrases are searched beginning at this word ("" -> start of layout)
+    const char *pastMinutesAfter;       // phrases before nextHourFrom are searched behind this word (nullptr -> minutesFrom)
+    const char *hourWords[12];          // index = hour (0 = 12)
+    const char *hoursAfter;             // hour words are searched behind this word ("" -> start of layout)
+    const char *fullHourSuffix;         // e.g. "UHR" ("" -> none)
+    const char *hourOneFullHour;        // hour word for one at full hour, e.g. "EIN" (nullptr -> hourWords[1])
+    uint8_t nextHourFrom;               // from this minute phrase on the next hour is shown
+};
+
+/**
+ * @brief Masks for all five-minute time states (hour 0-11, minutes / 5)
+ *
+ */
+struct ClockFaceTable {
+    WordMask masks[12][12];
+};
+
+/**
+ * @brief Find a word in the letter layout (compile time)
+ *
+ * @param layout letter layout of the clock face
+ * @param word word to search, terminated by '\0' or ' '
+ * @param from index in layout where the search starts
+ * @return int16_t index of the first letter of the word, -1 if not found
+ */
+static constexpr int16_t findWord(const char *layout, const char *word, int16_t from){
+    for(int16_t start = from; start < CLOCKFACE_LETTERS && layout[start] != '\0'; start++){
+        int16_t i = 0;
+        while(word[i] != '\0' && word[i] != ' ' && layout[start + i] == word[i]){
+            i++;
+        }
+        if(word[i] == '\0' || word[i] == ' '){
+            return start;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Generate the mask of a sentence (compile time). The words are searched one after the other,
+ * each word has to be placed behind the previous one.
+ *
+ * @param layout letter layout of the clock face
+ * @param sentence words separated by one space (may be empty)
+ * @param from index in layout where the search for the first word starts
+ * @return WordMask mask of all letters of the sentence, CLOCKFACE_INVALID_BIT is set if a word was not found
+ */
+static constexpr WordMask sentenceMask(const char *layout, const char *sentence, int16_t from){
+    WordMask mask = {};
+    const char *word = sentence;
+    while(*word != '\0'){
+        int16_t position = findWord(layout, word, from);
+        uint8_t length = 0;
+        while(word[length] != '\0' && word[length] != ' '){
+            length++;
+        }
+        if(position < 0){
+            mask.bits[CLOCKFACE_INVALID_BIT >> 5] |= (1UL << (CLOCKFACE_INVALID_BIT & 31));
+            return mask;
+        }
+        for(uint8_t i = 0; i < length; i++){
+            mask.bits[(position + i) >> 5] |= (1UL << ((position + i) & 31));
+        }
+        from = position + length;
+        word += length;
+        if(*word == ' '){
+            word++;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Check that all sentences of a table were found in the layout (compile time)
+ *
+ * @param table generated table
+ * @return true if all masks are valid
+ */
+static constexpr bool isClockFaceTableValid(const ClockFaceTable &table){
+    for(uint8_t h = 0; h < 12; h++){
+        for(uint8_t m = 0; m < 12; m++){
+            if(!table.masks[h][m].isValid()){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Find the position in the layout where the search for a part of the sentence starts (compile time)
+ *
+ * @param layout letter layout of the clock face
+ * @param word anchor word ("" -> start of layout)
+ * @param behind true -> position behind the word, false -> first letter of the word
+ * @return int16_t index in layout, CLOCKFACE_LETTERS if the word is missing (all following searches fail -> table is invalid)
+ */
+static constexpr int16_t findAnchor(const char *layout, const char *word, bool behind){
+    if(word[0] == '\0'){
+        return 0;
+    }
+    int16_t position = findWord(layout, word, 0);
+    if(position < 0){
+        return CLOCKFACE_LETTERS;
+    }
+    uint8_t length = 0;
+    while(behind && word[length] != '\0'){
+        length++;
+    }
+    return position + length;
+}
+
+/**
+ * @brief Generate the masks of all time states of a language pack (compile time)
+ *
+ * @param grammar language pack
+ * @return ClockFaceTable table with one mask per hour and five minutes
+ */
+static constexpr ClockFaceTable makeClockFaceTable(const LanguageGrammar &grammar){
+    ClockFaceTable table = {};
+    int16_t minutesStart = findAnchor(grammar.layout, grammar.minutesFrom, false);
+    int16_t pastMinutesStart = (grammar.pastMinutesAfter != nullptr) ? findAnchor(grammar.layout, grammar.pastMinutesAfter, true) : minutesStart;
+    int16_t hoursStart = findAnchor(grammar.layout, grammar.hoursAfter, true);
+    for(uint8_t h = 0; h < 12; h++){
+        for(uint8_t m = 0; m < 12; m++){
+            uint8_t hour = (m >= grammar.nextHourFrom) ? (h + 1) % 12 : h;
+            const char *prefix = (hour == 1 && grammar.prefixHourOne != nullptr) ? grammar.prefixHourOne : grammar.prefix;
+            const char *hourWord = (hour == 1 && m == 0 && grammar.hourOneFullHour != nullptr) ? grammar.hourOneFullHour : grammar.hourWords[hour];
+            WordMask mask = sentenceMask(grammar.layout, prefix, 0)
+                            | sentenceMask(grammar.layout, grammar.minutePhrases[m], (m < grammar.nextHourFrom) ? pastMinutesStart : minutesStart)
+                            | sentenceMask(grammar.layout, hourWord, hoursStart);
+            if(m == 0){
+                mask = mask | sentenceMask(grammar.layout, grammar.fullHourSuffix, hoursStart);
+            }
+            table.masks[h][m] = mask;
+        }
+    }
+    return table;
+}
+
+const WordMask *getClockFaceMask(uint8_t language, uint8_t hours, uint8_t minutes);
+const char *getLanguageName(uint8_t language);
+int8_t findLanguage(const char *name);
+void drawWordMask(LEDMatrix *matrix, const WordMask *mask, uint32_t color);
+
+#endif
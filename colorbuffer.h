@@ -0,0 +1,250 @@
+/**
+ * @file colorbuffer.h
+ * @brief Compact storage for the 24bit colors of the leds
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * PackedColorBuffer stores each color with 3 bytes (RGB888) instead of 4 bytes (uint32_t).
+ * PaletteColorBuffer stores a 4bit index per led into a palette of 16 colors,
+ * which is enough for modes with only a few colors (clock, games).
+ * SparseAlphaLayer stores a few colors with alpha for single leds (overlays, status indicators).
+ *
+ */
+
+#ifndef colorbuffer_h
+#define colorbuffer_h
+
+#include <stdint.h>
+#include <string.h>
+
+// number of colors in the palette of PaletteColorBuffer (4bit index)
+#define COLORBUFFER_PALETTE_SIZE 16
+
+/**
+ * @brief Buffer of N colors, each packed into 3 bytes (R, G, B)
+ *
+ */
+template<uint16_t N>
+class PackedColorBuffer{
+    public:
+        /**
+         * @brief Get color of one led
+         *
+         * @param index index of the led
+         * @return uint32_t 24bit color
+         */
+        uint32_t get(uint16_t index) const {
+            const uint8_t *p = &_data[index * 3];
+            return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+        }
+
+        /**
+         * @brief Set color of one led
+         *
+         * @param index index of the led
+         * @param color 24bit color
+         */
+        void set(uint16_t index, uint32_t color){
+            uint8_t *p = &_data[index * 3];
+            p[0] = color >> 16;
+            p[1] = color >> 8;
+            p[2] = color;
+        }
+
+    private:
+        uint8_t _data[N * 3] = {0};
+};
+
+/**
+ * @brief Buffer of N colors, each stored as 4bit index into a palette of 16 colors.
+ * Palette entries are allocated on first use and reused when no led refers to them anymore.
+ * Entry 0 is always black. If more than 16 colors are used at the same time,
+ * the nearest color of the palette is taken instead (counted as palette overflow).
+ *
+ */
+template<uint16_t N>
+class PaletteColorBuffer{
+    public:
+        /**
+         * @brief Get color of one led
+         *
+         * @param index index of the led
+         * @return uint32_t 24bit color
+         */
+        uint32_t get(uint16_t index) const {
+            return _palette[getEntry(index)];
+        }
+
+        /**
+         * @brief Set color of one led, allocates a new palette entry if the color is not in the palette yet
+         *
+         * @param index index of the led
+         * @param color 24bit color
+         */
+        void set(uint16_t index, uint32_t color){
+            int8_t entry = findEntry(color);
+            if(entry < 0){
+                // release entry of this led before searching for a free entry
+                setEntry(index, 0);
+                entry = allocateEntry(color);
+            }
+            setEntry(index, entry);
+        }
+
+        /**
+         * @brief Get number of colors which could not be stored exactly because the palette was full
+         *
+         * @return uint32_t number of palette overflows
+         */
+        uint32_t getPaletteOverflows() const { return _overflows; }
+
+    private:
+        uint8_t _indices[(N + 1) / 2] = {0};
+        uint32_t _palette[COLORBUFFER_PALETTE_SIZE] = {0};
+        // one bit per allocated palette entry (entry 0 = black is always allocated)
+        uint16_t _allocated = 1;
+        uint32_t _overflows = 0;
+
+        uint8_t getEntry(uint16_t index) const {
+            return (_indices[index >> 1] >> ((index & 1) * 4)) & 0x0f;
+        }
+
+        void setEntry(uint16_t index, uint8_t entry){
+            uint8_t shift = (index & 1) * 4;
+            _indices[index >> 1] = (_indices[index >> 1] & ~(0x0f << shift)) | (entry << shift);
+        }
+
+        int8_t findEntry(uint32_t color) const {
+            for(uint8_t i = 0; i < COLORBUFFER_PALETTE_SIZE; i++){
+                if(((_allocated >> i) & 1) && _palette[i] == color){
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * @brief Store color in a free palette entry. If all entries are allocated,
+         * entries which are not used by any led anymore are released first.
+         *
+         * @param color 24bit color
+         * @return uint8_t palette entry of the color (or of the nearest color if palette is full)
+         */
+        uint8_t allocateEntry(uint32_t color){
+            if(_allocated == 0xffff){
+                _allocated = 1;
+                for(uint16_t i = 0; i < N; i++){
+                    _allocated |= (1 << getEntry(i));
+                }
+            }
+            for(uint8_t i = 1; i < COLORBUFFER_PALETTE_SIZE; i++){
+                if(!((_allocated >> i) & 1)){
+                    _allocated |= (1 << i);
+                    _palette[i] = color;
+                    return i;
+                }
+            }
+            _overflows++;
+            return nearestEntry(color);
+        }
+
+        uint8_t nearestEntry(uint32_t color) const {
+            uint8_t best = 0;
+            uint16_t bestDistance = 0xffff;
+            for(uint8_t i = 0; i < COLORBUFFER_PALETTE_SIZE; i++){
+                uint32_t entry = _palette[i];
+                uint16_t distance = 0;
+                for(uint8_t shift = 0; shift < 24; shift += 8){
+                    int16_t diff = (int16_t)((color >> shift) & 0xff) - (int16_t)((entry >> shift) & 0xff);
+                    distance += (diff < 0) ? -diff : diff;
+                }
+                if(distance < bestDistance){
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            return best;
+        }
+};
+
+/**
+ * @brief Layer with a fixed number of pixels, each with color and alpha.
+ * Only the pixels which are set are stored, all other pixels are transparent.
+ *
+ */
+template<uint8_t CAPACITY>
+class SparseAlphaLayer{
+    public:
+        /**
+         * @brief Get color and alpha of one led
+         *
+         * @param index index of the led
+         * @param color color of the led (only set if the led is in the layer)
+         * @param alpha alpha of the led (0 = transparent, 255 = opaque)
+         * @return true if the led is in the layer
+         */
+        bool get(uint8_t index, uint32_t &color, uint8_t &alpha) const {
+            int8_t i = find(index);
+            if(i < 0){
+                return false;
+            }
+            const Entry &entry = _entries[i];
+            color = ((uint32_t)entry.color[0] << 16) | ((uint32_t)entry.color[1] << 8) | entry.color[2];
+            alpha = entry.alpha;
+            return true;
+        }
+
+        /**
+         * @brief Set color and alpha of one led, alpha 0 removes the led from the layer
+         *
+         * @param index index of the led
+         * @param color 24bit color
+         * @param alpha alpha of the led (0 = transparent, 255 = opaque)
+         * @return false if the layer is full
+         */
+        bool set(uint8_t index, uint32_t color, uint8_t alpha){
+            int8_t i = find(index);
+            if(alpha == 0){
+                if(i >= 0){
+                    _entries[i] = _entries[--_count];
+                }
+                return true;
+            }
+            if(i < 0){
+                if(_count >= CAPACITY){
+                    return false;
+                }
+                i = _count++;
+                _entries[i].index = index;
+            }
+            Entry &entry = _entries[i];
+            entry.alpha = alpha;
+            entry.color[0] = color >> 16;
+            entry.color[1] = color >> 8;
+            entry.color[2] = color;
+            return true;
+        }
+
+        uint8_t size() const { return _count; }
+        uint8_t indexAt(uint8_t i) const { return _entries[i].index; }
+
+    private:
+        struct Entry {
+            uint8_t index;
+            uint8_t alpha;
+            uint8_t color[3];
+        };
+        Entry _entries[CAPACITY];
+        uint8_t _count = 0;
+
+        int8_t find(uint8_t index) const {
+            for(uint8_t i = 0; i < _count; i++){
+                if(_entries[i].index == index){
+                    return i;
+                }
+            }
+            return -1;
+        }
+};
+
+#endif
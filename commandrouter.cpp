@@ -0,0 +1,243 @@
+#include "commandrouter.h"
+#include <string.h>
+
+/**
+ * @brief Construct a new CommandArgs object
+ *
+ * @param value value of the command (not copied, has to stay valid while parsing)
+ * @param execute false -> the handler only validates the arguments
+ */
+CommandArgs::CommandArgs(const char *value, bool execute){
+    _value = (value != nullptr) ? value : "";
+    _pos = _value;
+    _execute = execute;
+}
+
+/**
+ * @brief (private) Step over the separator behind a value
+ *
+ * @return true if the value is followed by a separator or the end of the string
+ */
+bool CommandArgs::skipSeparator(){
+    if(*_pos == COMMANDROUTER_SEPARATOR){
+        _pos++;
+        return true;
+    }
+    return *_pos == '\0';
+}
+
+/**
+ * @brief Check if all values were parsed
+ *
+ * @return true if nothing follows the last parsed value (also no separator)
+ */
+bool CommandArgs::atEnd() const{
+    return *_pos == '\0' && (_pos == _value || _pos[-1] != COMMANDROUTER_SEPARATOR);
+}
+
+/**
+ * @brief Parse the next value as decimal number (without sign, '-' is the separator)
+ *
+ * @param value parsed number, unchanged if not valid
+ * @param min smallest allowed value
+ * @param max largest allowed value
+ * @return true if a number in the range was found
+ */
+bool CommandArgs::nextInt(long &value, long min, long max){
+    const char *p = _pos;
+    if(*p < '0' || *p > '9'){
+        return false;
+    }
+    long number = 0;
+    while(*p >= '0' && *p <= '9'){
+        number = number * 10 + (*p++ - '0');
+        if(number > max){
+            return false;
+        }
+    }
+    if(number < min){
+        return false;
+    }
+    _pos = p;
+    if(!skipSeparator()){
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+/**
+ * @brief Parse the next value as switch ("1" or "0")
+ *
+ * @param value parsed value
+ * @return true if valid
+ */
+bool CommandArgs::nextBool(bool &value){
+    long number;
+    if(!nextInt(number, 0, 1)){
+        return false;
+    }
+    value = number == 1;
+    return true;
+}
+
+/**
+ * @brief Parse the next three values as color red-green-blue (0-255 each)
+ *
+ * @param red
+ * @param green
+ * @param blue
+ * @return true if valid, the color is only changed if all three values are valid
+ */
+bool CommandArgs::nextColor(uint8_t &red, uint8_t &green, uint8_t &blue){
+    long r, g, b;
+    if(!nextInt(r, 0, 255) || !nextInt(g, 0, 255) || !nextInt(b, 0, 255)){
+        return false;
+    }
+    red = r;
+    green = g;
+    blue = b;
+    return true;
+}
+
+/**
+ * @brief Parse the next two values as time of day hours-minutes
+ *
+ * @param hours 0-23
+ * @param minutes 0-59
+ * @return true if valid, the time is only changed if both values are valid
+ */
+bool CommandArgs::nextTime(int &hours, int &minutes){
+    long h, m;
+    if(!nextInt(h, 0, 23) || !nextInt(m, 0, 59)){
+        return false;
+    }
+    hours = h;
+    minutes = m;
+    return true;
+}
+
+/**
+ * @brief Parse the next value as one of the given names
+ *
+ * @param names allowed names
+ * @param count number of names
+ * @return int8_t index of the name, -1 if not found
+ */
+int8_t CommandArgs::nextEnum(const char *const names[], uint8_t count){
+    const char *end = _pos;
+    while(*end != '\0' && *end != COMMANDROUTER_SEPARATOR){
+        end++;
+    }
+    size_t length = end - _pos;
+    for(uint8_t i = 0; i < count; i++){
+        if(strncmp(names[i], _pos, length) == 0 && names[i][length] == '\0'){
+            _pos = end;
+            skipSeparator();
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Construct a new empty CommandRouter object
+ *
+ */
+CommandRouter::CommandRouter(){
+    memset(_slots, 0, sizeof(_slots));
+}
+
+/**
+ * @brief FNV-1a hash of a command name
+ *
+ * @param name
+ * @return uint32_t hash
+ */
+uint32_t CommandRouter::hash(const char *name){
+    uint32_t h = 2166136261UL;
+    while(*name != '\0'){
+        h = (h ^ (uint8_t)*name++) * 16777619UL;
+    }
+    return h;
+}
+
+/**
+ * @brief Register a command
+ *
+ * @param name name of the command (the string is not copied)
+ * @param handler function which parses the arguments and executes the command
+ * @return true if registered, false if the table is full or the name exists already
+ */
+bool CommandRouter::add(const char *name, CommandHandler handler){
+    uint32_t h = hash(name);
+    if(_numCommands >= COMMANDROUTER_MAX_COMMANDS || find(name, h) >= 0){
+        return false;
+    }
+    uint8_t slot = h & (COMMANDROUTER_TABLE_SIZE - 1);
+    while(_slots[slot] != 0){
+        slot = (slot + 1) & (COMMANDROUTER_TABLE_SIZE - 1);
+    }
+    _commands[_numCommands] = {name, h, handler};
+    _slots[slot] = ++_numCommands;
+    return true;
+}
+
+/**
+ * @brief Execute a command
+ *
+ * @param name name of the command
+ * @param value arguments of the command
+ * @return CommandResult cmd_unknown if no command with this name is registered,
+ * otherwise the result of the handler
+ */
+CommandResult CommandRouter::dispatch(const char *name, const char *value) const{
+    return run(name, value, true);
+}
+
+/**
+ * @brief Validate a command without executing it
+ *
+ * @param name name of the command
+ * @param value arguments of the command
+ * @return CommandResult cmd_ok if dispatch() would execute the command
+ */
+CommandResult CommandRouter::check(const char *name, const char *value) const{
+    return run(name, value, false);
+}
+
+/**
+ * @brief (private) Find the handler of a command and call it
+ *
+ * @param name name of the command
+ * @param value arguments of the command
+ * @param execute false -> only validate the arguments
+ * @return CommandResult
+ */
+CommandResult CommandRouter::run(const char *name, const char *value, bool execute) const{
+    int8_t index = find(name, hash(name));
+    if(index < 0){
+        return cmd_unknown;
+    }
+    CommandArgs args(value, execute);
+    return _commands[index].handler(args);
+}
+
+/**
+ * @brief (private) Find a command in the hash table (linear probing)
+ *
+ * @param name name of the command
+ * @param hash hash of the name
+ * @return int8_t index of the command, -1 if not registered
+ */
+int8_t CommandRouter::find(const char *name, uint32_t hash) const{
+    uint8_t slot = hash & (COMMANDROUTER_TABLE_SIZE - 1);
+    while(_slots[slot] != 0){
+        const Command &command = _commands[_slots[slot] - 1];
+        if(command.hash == hash && strcmp(command.name, name) == 0){
+            return _slots[slot] - 1;
+        }
+        slot = (slot + 1) & (COMMANDROUTER_TABLE_SIZE - 1);
+    }
+    return -1;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file commandrouter.h
+ * @brief Registry of the commands of the webserver (/cmd?name=value) with typed argument parsing
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * The command names are stored in a small open addressing hash table (FNV-1a hash of the name),
+ * a lookup needs one hash calculation and usually one string comparison.
+ *
+ * The handlers parse their arguments directly from the value of the request (CommandArgs),
+ * without creating Strings. Several values are separated by '-', e.g. "led=255-128-0".
+ *
+ * After the last value a handler has to check atEnd(), so that values with additional
+ * characters (e.g. "led=1-2-3-4" or a trailing separator) are rejected instead of executed.
+ *
+ * check() runs the handler only up to the validation of the arguments (CommandArgs::isCheckOnly()),
+ * so a list of commands can be validated completely before the first one is executed.
+ *
+ */
+
+#ifndef commandrouter_h
+#define commandrouter_h
+
+#include <stdint.h>
+
+#define COMMANDROUTER_MAX_COMMANDS 16
+// number of slots of the hash table, power of 2 and at least twice the max number of commands
+#define COMMANDROUTER_TABLE_SIZE 32
+// separator of several values in one argument
+#define COMMANDROUTER_SEPARATOR '-'
+
+enum CommandResult {cmd_ok, cmd_unknown, cmd_invalid};
+
+/**
+ * @brief Parser for the value of a command, reads the values one after the other in place
+ *
+ */
+class CommandArgs{
+
+    public:
+        CommandArgs(const char *value, bool execute = true);
+        const char *getString() const { return _value; }
+        bool isCheckOnly() const { return !_execute; }
+        bool atEnd() const;
+        bool nextInt(long &value, long min, long max);
+        bool nextBool(bool &value);
+        bool nextColor(uint8_t &red, uint8_t &green, uint8_t &blue);
+        bool nextTime(int &hours, int &minutes);
+        int8_t nextEnum(const char *const names[], uint8_t count);
+    private:
+        const char *_value;
+        const char *_pos;
+        bool _execute;
+
+        bool skipSeparator();
+};
+
+typedef CommandResult (*CommandHandler)(CommandArgs &args);
+
+class CommandRouter{
+
+    public:
+        CommandRouter();
+        bool add(const char *name, CommandHandler handler);
+        CommandResult dispatch(const char *name, const char *value) const;
+        CommandResult check(const char *name, const char *value) const;
+        uint8_t getNumCommands() const { return _numCommands; }
+        static uint32_t hash(const char *name);
+    private:
+        struct Command {
+            const char *name;
+            uint32_t hash;
+            CommandHandler handler;
+        };
+        Command _commands[COMMANDROUTER_MAX_COMMANDS];
+        uint8_t _numCommands = 0;
+        uint8_t _slots[COMMANDROUTER_TABLE_SIZE];   // index of the command + 1, 0 = empty slot
+
+        int8_t find(const char *name, uint32_t hash) const;
+        CommandResult run(const char *name, const char *value, bool execute) const;
+};
+
+#endif
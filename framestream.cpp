@@ -0,0 +1,91 @@
+#include "framestream.h"
+
+/**
+ * @brief Construct a new FrameStreamDecoder object
+ *
+ * @param numPixels number of leds of the display, data beyond is ignored
+ */
+FrameStreamDecoder::FrameStreamDecoder(uint16_t numPixels){
+    _numPixels = numPixels;
+}
+
+/**
+ * @brief Decode one received packet
+ *
+ * @param packet received UDP payload
+ * @param length length of the payload
+ * @param now current time in ms (for the sequence timeout)
+ * @param frame pixel data of the packet (points into packet)
+ * @return true if the packet contains pixel data or a push for this display
+ */
+bool FrameStreamDecoder::decode(const uint8_t *packet, uint16_t length, uint32_t now, FramePacket &frame){
+    if(length < FRAMESTREAM_HEADER || (packet[0] & DDP_FLAG_VERSION_MASK) != DDP_FLAG_VERSION_1){
+        _invalid++;
+        return false;
+    }
+    uint8_t flags = packet[0];
+    if(flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY | DDP_FLAG_STORAGE)){
+        // status/config queries and replies are not supported
+        return false;
+    }
+    uint8_t destination = packet[3];
+    if(destination != DDP_ID_DISPLAY && destination != DDP_ID_ALL){
+        return false;
+    }
+    uint8_t dataType = packet[2];
+    uint32_t offset = (uint32_t)packet[4] << 24 | (uint32_t)packet[5] << 16 | (uint32_t)packet[6] << 8 | packet[7];
+    uint16_t dataLength = (uint16_t)packet[8] << 8 | packet[9];
+    uint16_t headerLength = (flags & DDP_FLAG_TIMECODE) ? FRAMESTREAM_HEADER + FRAMESTREAM_TIMECODE : FRAMESTREAM_HEADER;
+
+    if((dataType != DDP_TYPE_UNDEFINED && dataType != DDP_TYPE_RGB && dataType != DDP_TYPE_RGB24)
+        || headerLength + dataLength > length || offset % 3 != 0 || dataLength % 3 != 0){
+        _invalid++;
+        return false;
+    }
+    if(!checkSequence(packet[1] & 0x0f, now)){
+        _dropped++;
+        return false;
+    }
+    _packets++;
+
+    uint32_t firstPixel = offset / 3;
+    uint32_t pixels = dataLength / 3;
+    if(firstPixel >= _numPixels){
+        pixels = 0;
+    }
+    else if(firstPixel + pixels > _numPixels){
+        pixels = _numPixels - firstPixel;
+    }
+    frame.data = packet + headerLength;
+    frame.firstPixel = pixels > 0 ? firstPixel : 0;
+    frame.pixels = pixels;
+    frame.push = flags & DDP_FLAG_PUSH;
+    if(frame.push){
+        _frames++;
+    }
+    return pixels > 0 || frame.push;
+}
+
+/**
+ * @brief (private) Check the sequence number of a packet and count lost packets
+ *
+ * @param sequence sequence number 1-15, 0 = not used by the sender
+ * @param now current time in ms
+ * @return true if the packet is newer than the last one
+ */
+bool FrameStreamDecoder::checkSequence(uint8_t sequence, uint32_t now){
+    bool restarted = _lastSequence == 0 || now - _lastPacketTime > FRAMESTREAM_SEQUENCE_TIMEOUT;
+    _lastPacketTime = now;
+    if(sequence == 0 || restarted){
+        _lastSequence = sequence;
+        return true;
+    }
+    // distance in the cycle 1..15, more than half a cycle ahead is considered as behind (reordered)
+    uint8_t distance = (sequence - _lastSequence + 15) % 15;
+    if(distance == 0 || distance > 7){
+        return false;
+    }
+    _lost += distance - 1;
+    _lastSequence = sequence;
+    return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file framestream.h
+ * @brief Decoder for LED frames streamed via UDP (DDP, Distributed Display Protocol)
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * Subset of DDP (http://www.3waylabs.com/ddp/) as sent by xLights, WLED or LedFx:
+ *   header: flags(1) sequence(1) dataType(1) destination(1) offset(4) length(2), all big endian
+ *           [timecode(4) if flag DDP_FLAG_TIMECODE]
+ *   data:   length bytes RGB (3 bytes per led), starting at byte offset of the frame
+ *
+ * A frame may be split into several packets, the last one has DDP_FLAG_PUSH set.
+ * The sequence number (1-15, 0 = not used) is used to drop duplicated and reordered packets.
+ * The led order is y * WIDTH + x, the minute indicators follow the grid.
+ *
+ * The decoder does not copy the pixel data, it returns a pointer into the packet.
+ *
+ */
+
+#ifndef framestream_h
+#define framestream_h
+
+#include <stdint.h>
+
+// default UDP port of DDP
+#define FRAMESTREAM_PORT 4048
+#define FRAMESTREAM_HEADER 10
+#define FRAMESTREAM_TIMECODE 4
+// max data bytes of one packet (480 RGB leds)
+#define FRAMESTREAM_MAX_DATA 1440
+#define FRAMESTREAM_MAX_PACKET (FRAMESTREAM_HEADER + FRAMESTREAM_TIMECODE + FRAMESTREAM_MAX_DATA)
+// after this time (ms) without packets any sequence number is accepted (sender restarted)
+#define FRAMESTREAM_SEQUENCE_TIMEOUT 1000
+
+#define DDP_FLAG_VERSION_MASK 0xC0
+#define DDP_FLAG_VERSION_1 0x40
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_FLAG_STORAGE 0x08
+#define DDP_FLAG_REPLY 0x04
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_PUSH 0x01
+
+// data types which are accepted as 8bit RGB (undefined, RGB as sent by some tools, RGB 8bit per channel)
+#define DDP_TYPE_UNDEFINED 0x00
+#define DDP_TYPE_RGB 0x01
+#define DDP_TYPE_RGB24 0x0B
+
+// destinations: default output device and all devices
+#define DDP_ID_DISPLAY 1
+#define DDP_ID_ALL 255
+
+/**
+ * @brief Pixel data of one decoded packet
+ *
+ */
+struct FramePacket {
+    const uint8_t *data;    // RGB bytes inside the packet
+    uint16_t firstPixel;    // index of the first led
+    uint16_t pixels;        // number of leds (clipped to the number of leds of the display)
+    bool push;              // frame complete -> show it
+};
+
+class FrameStreamDecoder{
+
+    public:
+        FrameStreamDecoder(uint16_t numPixels);
+        bool decode(const uint8_t *packet, uint16_t length, uint32_t now, FramePacket &frame);
+        uint32_t getPackets() const { return _packets; }
+        uint32_t getFrames() const { return _frames; }
+        uint32_t getLostPackets() const { return _lost; }
+        uint32_t getDroppedPackets() const { return _dropped; }
+        uint32_t getInvalidPackets() const { return _invalid; }
+    private:
+        uint16_t _numPixels;
+        uint8_t _lastSequence = 0;
+        uint32_t _lastPacketTime = 0;
+        uint32_t _packets = 0;          // accepted packets
+        uint32_t _frames = 0;           // packets with push flag
+        uint32_t _lost = 0;             // gaps in the sequence numbers
+        uint32_t _dropped = 0;          // duplicated or reordered packets
+        uint32_t _invalid = 0;          // malformed packets or unsupported data type
+
+        bool checkSequence(uint8_t sequence, uint32_t now);
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "jsonwriter.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+/**
+ * @brief Construct a new JsonWriter object
+ *
+ * @param buffer output buffer, sent when full
+ * @param size size of the buffer
+ * @param output function which sends the content of the buffer
+ */
+JsonWriter::JsonWriter(char *buffer, uint16_t size, JsonOutput output){
+    _buffer = buffer;
+    _size = size;
+    _output = output;
+}
+
+/**
+ * @brief Start an object
+ *
+ * @param name name of the object inside the enclosing object, nullptr inside an array or at top level
+ */
+void JsonWriter::beginObject(const char *name){
+    if(_depth >= JSONWRITER_MAX_DEPTH - 1){
+        // nested too deep, the writer fails
+        _failed = true;
+        return;
+    }
+    beginValue(name);
+    write('{');
+    _depth++;
+    _hasValues &= ~(1UL << _depth);
+}
+
+/**
+ * @brief End the current object
+ *
+ */
+void JsonWriter::endObject(){
+    if(_depth == 0){
+        // no open object or array, the writer fails
+        _failed = true;
+        return;
+    }
+    write('}');
+    _depth--;
+}
+
+/**
+ * @brief Start an array
+ *
+ * @param name name of the array inside the enclosing object, nullptr inside an array or at top level
+ */
+void JsonWriter::beginArray(const char *name){
+    if(_depth >= JSONWRITER_MAX_DEPTH - 1){
+        // nested too deep, the writer fails
+        _failed = true;
+        return;
+    }
+    beginValue(name);
+    write('[');
+    _depth++;
+    _hasValues &= ~(1UL << _depth);
+}
+
+/**
+ * @brief End the current array
+ *
+ */
+void JsonWriter::endArray(){
+    if(_depth == 0){
+        // no open object or array, the writer fails
+        _failed = true;
+        return;
+    }
+    write(']');
+    _depth--;
+}
+
+/**
+ * @brief Add a string value
+ *
+ * @param name name of the value, nullptr inside an array
+ * @param value string (escaped), nullptr is written as null
+ */
+void JsonWriter::add(const char *name, const char *value){
+    beginValue(name);
+    if(value == nullptr){
+        write("null");
+    }
+    else{
+        writeString(value);
+    }
+}
+
+/**
+ * @brief Add a number
+ *
+ * @param name name of the value, nullptr inside an array
+ * @param value
+ */
+void JsonWriter::addNumber(const char *name, long value){
+    char text[12];
+    snprintf(text, sizeof(text), "%ld", value);
+    beginValue(name);
+    write(text);
+}
+
+/**
+ * @brief Add an unsigned number
+ *
+ * @param name name of the value, nullptr inside an array
+ * @param value
+ */
+void JsonWriter::addUnsigned(const char *name, unsigned long value){
+    char text[12];
+    snprintf(text, sizeof(text), "%lu", value);
+    beginValue(name);
+    write(text);
+}
+
+/**
+ * @brief Add a string value formatted printf-style (truncated to JSONWRITER_FORMAT_SIZE - 1 characters)
+ *
+ * @param name name of the value, nullptr inside an array
+ * @param format printf format string
+ */
+void JsonWriter::addFormatted(const char *name, const char *format, ...){
+    char text[JSONWRITER_FORMAT_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    beginValue(name);
+    writeString(text);
+}
+
+/**
+ * @brief Send the content of the buffer
+ *
+ */
+void JsonWriter::flush(){
+    if(_pos > 0){
+        _output(_buffer, _pos);
+        _length += _pos;
+        _pos = 0;
+    }
+}
+
+/**
+ * @brief (private) Write the comma in front of the value and its name
+ *
+ * @param name name of the value, nullptr inside an array
+ */
+void JsonWriter::beginValue(const char *name){
+    if(_hasValues & (1UL << _depth)){
+        write(',');
+    }
+    _hasValues |= 1UL << _depth;
+    if(name != nullptr){
+        writeString(name);
+        write(':');
+    }
+}
+
+/**
+ * @brief (private) Write one character into the buffer, sends the buffer if it is full.
+ * Nothing is written after the writer failed.
+ *
+ * @param c
+ */
+void JsonWriter::write(char c){
+    if(_failed){
+        return;
+    }
+    if(_pos >= _size){
+        flush();
+    }
+    _buffer[_pos++] = c;
+}
+
+/**
+ * @brief (private) Write a text without escaping
+ *
+ * @param text
+ */
+void JsonWriter::write(const char *text){
+    while(*text != '\0'){
+        write(*text++);
+    }
+}
+
+/**
+ * @brief (private) Write a string in quotes, escapes quotes, backslashes and control characters
+ *
+ * @param text
+ */
+void JsonWriter::writeString(const char *text){
+    static const char hex[] = "0123456789abcdef";
+    write('"');
+    for(; *text != '\0'; text++){
+        uint8_t c = *text;
+        if(c == '"' || c == '\\'){
+            write('\\');
+            write(c);
+        }
+        else if(c < 0x20){
+            write("\\u00");
+            write(hex[c >> 4]);
+            write(hex[c & 0x0f]);
+        }
+        else{
+            write(c);
+        }
+    }
+    write('"');
+}
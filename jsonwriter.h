@@ -0,0 +1,62 @@
+/**
+ * @file jsonwriter.h
+ * @brief Streaming JSON writer with a fixed output buffer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * The JSON text is written into a buffer of the caller, each time the buffer is full it is passed
+ * to the output function (e.g. server.sendContent() of a chunked response). So the response is sent
+ * without building it completely in memory and without temporary Strings.
+ *
+ * Strings are escaped, commas between the values are inserted automatically.
+ * Nesting deeper than JSONWRITER_MAX_DEPTH - 1 levels or an end without begin lets the writer fail:
+ * nothing more is written and hasFailed() returns true.
+ *
+ */
+
+#ifndef jsonwriter_h
+#define jsonwriter_h
+
+#include <stdint.h>
+
+// default size of the output buffer (= size of the chunks)
+#define JSONWRITER_BUFFER_SIZE 256
+// max length of a value created with addFormatted()
+#define JSONWRITER_FORMAT_SIZE 48
+// max nesting depth of objects and arrays
+#define JSONWRITER_MAX_DEPTH 32
+
+typedef void (*JsonOutput)(const char *data, uint16_t length);
+
+class JsonWriter{
+
+    public:
+        JsonWriter(char *buffer, uint16_t size, JsonOutput output);
+        void beginObject(const char *name = nullptr);
+        void endObject();
+        void beginArray(const char *name = nullptr);
+        void endArray();
+        void add(const char *name, const char *value);
+        void addNumber(const char *name, long value);
+        void addUnsigned(const char *name, unsigned long value);
+        void addFormatted(const char *name, const char *format, ...) __attribute__((format(printf, 3, 4)));
+        void flush();
+        uint32_t getLength() const { return _length + _pos; }
+        bool hasFailed() const { return _failed; }
+    private:
+        char *_buffer;
+        uint16_t _size;
+        uint16_t _pos = 0;
+        JsonOutput _output;
+        uint32_t _length = 0;           // bytes passed to the output
+        uint32_t _hasValues = 0;        // bit per nesting level: a value was written -> next one needs a comma
+        uint8_t _depth = 0;
+        bool _failed = false;           // nesting too deep or unbalanced -> nothing more is written
+
+        void beginValue(const char *name);
+        void write(char c);
+        void write(const char *text);
+        void writeString(const char *text);
+};
+
+#endif
@@ -1,6 +1,46 @@
 #include "ledmatrix.h"
 #include "own_font.h"
 
+// gamma correction table: 8bit linear value -> gamma corrected value in 8.8 fixed point, 
+// generated at compile time and stored in flash
+struct GammaTable {
+    uint16_t values[256];
+};
+
+/**
+ * @brief Square root which can be evaluated at compile time (newton iteration)
+ * 
+ * @param x value >= 0
+ * @return double square root of x
+ */
+static constexpr double constexprSqrt(double x){
+    double result = (x > 1.0) ? x : 1.0;
+    for(uint8_t i = 0; i < 40; i++){
+        result = 0.5 * (result + x / result);
+    }
+    return result;
+}
+
+/**
+ * @brief Generate gamma correction table with gamma 2.25 (x^2 * x^0.25)
+ * 
+ * @return GammaTable table with 256 values in 8.8 fixed point
+ */
+static constexpr GammaTable makeGammaTable(){
+    GammaTable table = {};
+    for(uint16_t i = 0; i < 256; i++){
+        double x = i / 255.0;
+        double corrected = x * x * constexprSqrt(constexprSqrt(x));
+        table.values[i] = (uint16_t)(corrected * 255.0 * 256.0 + 0.5);
+    }
+    return table;
+}
+
+static constexpr GammaTable gammaTable PROGMEM = makeGammaTable();
+
+// thresholds for temporal dithering, every led runs through them frame by frame (with an offset)
+static const uint8_t ditherThresholds[8] = {0, 128, 64, 192, 32, 160, 96, 224};
+
 /**
  * @brief Construct a new LEDMatrix::LEDMatrix object
  * 
@@ -11,8 +51,21 @@
 LEDMatrix::LEDMatrix(Adafruit_NeoMatrix *mymatrix, uint8_t mybrightness, UDPLogger *mylogger){
     neomatrix = mymatrix;
     brightness = mybrightness;
+    limitedBrightness = mybrightness;
     logger = mylogger;
     currentLimit = DEFAULT_CURRENT_LIMIT;
+
+    // precalc mapping from (x, y) to strip index, every second row runs from right to left (zigzag)
+    for(uint8_t y = 0; y < HEIGHT; y++){
+      for(uint8_t x = 0; x < WIDTH; x++){
+        stripIndex[y * WIDTH + x] = y * WIDTH + ((y & 1) ? (WIDTH - 1 - x) : x);
+      }
+    }
+    // minute indicators are placed in the row below the matrix, starting from the right
+    for(uint8_t i = 0; i < NUM_INDICATORS; i++){
+      uint8_t x = WIDTH - (1 + i);
+      stripIndex[WIDTH * HEIGHT + i] = HEIGHT * WIDTH + ((HEIGHT & 1) ? (WIDTH - 1 - x) : x);
+    }
 }
 
 /**
@@ -66,22 +119,27 @@ uint32_t LEDMatrix::Wheel(uint8_t WheelPos)
 }
 
 /**
- * @brief Interpolates two colors24bit and returns an color of the result
+ * @brief Interpolates two colors24bit with an integer factor and returns an color of the result
+ * 
+ * Red and blue are blended together in one 32bit word (0x00RR00BB), green in a second one.
+ * Each channel has 8 bit headroom, so no channel can overflow into its neighbour.
+ * No floating point operations are needed (ESP8266 has no FPU).
  * 
  * @param color1 startcolor for interpolation
- * @param color2 endcolor for interpolatio
- * @param factor which color is wanted on the path from start to end color
+ * @param color2 endcolor for interpolation
+ * @param factor which color is wanted on the path from start to end color (Q8: 0 = color1, BLEND_FACTOR_ONE = color2)
  * @return uint32_t interpolated color
  */
-uint32_t LEDMatrix::interpolateColor24bit(uint32_t color1, uint32_t color2, float factor)
+uint32_t LEDMatrix::interpolateColor24bitFixed(uint32_t color1, uint32_t color2, uint16_t factor)
 {
-    uint8_t resultRed = color1 >> 16 & 0xff;
-    uint8_t resultGreen = color1 >> 8 & 0xff;
-    uint8_t resultBlue = color1 & 0xff;
-    resultRed = (uint8_t)(resultRed + (int16_t)(factor * ((int16_t)(color2 >> 16 & 0xff) - (int16_t)resultRed)));
-    resultGreen = (uint8_t)(resultGreen + (int16_t)(factor * ((int16_t)(color2 >> 8 & 0xff) - (int16_t)resultGreen)));
-    resultBlue = (uint8_t)(resultBlue + (int16_t)(factor * ((int16_t)(color2 & 0xff) - (int16_t)resultBlue)));
-    return Color24bit(resultRed, resultGreen, resultBlue);
+    if(factor >= BLEND_FACTOR_ONE){
+      return color2 & 0xffffff;
+    }
+    uint32_t inverseFactor = BLEND_FACTOR_ONE - factor;
+    // +0x80 per channel rounds to the nearest value
+    uint32_t resultRedBlue = ((color1 & 0xff00ff) * inverseFactor + (color2 & 0xff00ff) * factor + 0x800080) >> 8;
+    uint32_t resultGreen = ((color1 & 0x00ff00) * inverseFactor + (color2 & 0x00ff00) * factor + 0x008000) >> 8;
+    return (resultRedBlue & 0xff00ff) | (resultGreen & 0x00ff00);
 }
 
 /**
@@ -111,22 +169,15 @@ void LEDMatrix::setMinIndicator(uint8_t pattern, uint32_t color)
   //  2 -> 0010
   //  1 -> 0001
   //  0 -> 0000
-  if(pattern & 1){
-    targetindicators[0] = color;
-  }
-  if(pattern >> 1 & 1){
-    targetindicators[1] = color;
-  }
-  if(pattern >> 2 & 1){
-    targetindicators[2] = color;
-  }
-  if(pattern >> 3 & 1){
-    targetindicators[3] = color;
+  for(uint8_t i = 0; i < NUM_INDICATORS; i++){
+    if(pattern >> i & 1){
+      setLayerColor(layer_base, WIDTH * HEIGHT + i, color, 255);
+    }
   }
 }
 
 /**
- * @brief "Activates" a pixel in targetgrid with color
+ * @brief "Activates" a pixel in the base layer with color
  * 
  * @param x x-position of pixel
  * @param y y-position of pixel
@@ -136,7 +187,7 @@ void LEDMatrix::gridAddPixel(uint8_t x, uint8_t y, uint32_t color)
 {
   // limit ranges of x and y
   if(x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT){
-    targetgrid[y][x] = color;
+    setLayerColor(layer_base, y * WIDTH + x, color, 255);
   }
   else{
     //logger->logString("Index out of Range: " + String(x) + ", " + String(y));
@@ -144,22 +195,177 @@ void LEDMatrix::gridAddPixel(uint8_t x, uint8_t y, uint32_t color)
 }
 
 /**
- * @brief "Deactivates" all pixels in targetgrid
+ * @brief Set the colors of consecutive leds of the base layer from RGB bytes (e.g. directly from a received packet)
+ * 
+ * @param index index of the first led (y * WIDTH + x, minute indicators follow the grid)
+ * @param rgb red, green and blue byte of each led
+ * @param count number of leds, leds beyond NUM_LEDS are ignored
+ */
+void LEDMatrix::gridSetPixels(uint16_t index, const uint8_t *rgb, uint16_t count)
+{
+  for(uint16_t i = index; i < NUM_LEDS && i - index < count; i++, rgb += 3){
+    setLayerColor(layer_base, i, Color24bit(rgb[0], rgb[1], rgb[2]), 255);
+  }
+}
+
+/**
+ * @brief "Deactivates" all pixels in the base layer (overlay and status layer are kept)
  * 
  */
 void LEDMatrix::gridFlush(void)
 {
-    // set a zero to each pixel
-    for(uint8_t i=0; i<HEIGHT; i++){
-        for(uint8_t j=0; j<WIDTH; j++){
-            targetgrid[i][j] = 0;
-        }
+    // set a zero to each pixel and every minutes indicator led
+    for(uint8_t i = 0; i < NUM_LEDS; i++){
+        setLayerColor(layer_base, i, 0, 255);
     }
-    // set every minutes indicator led to 0
-    targetindicators[0] = 0;
-    targetindicators[1] = 0;
-    targetindicators[2] = 0;
-    targetindicators[3] = 0;
+}
+
+/**
+ * @brief Start a transition of one led from its current color to a new target color
+ * 
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ * @param target target color of the transition
+ * @param start start time of the transition (millis())
+ */
+void LEDMatrix::startTransition(uint8_t index, uint32_t target, uint32_t start)
+{
+    startColors.set(index, currentColors.get(index));
+    transitionTargets.set(index, target);
+    transitionStart[index] = start;
+    transitionDuration[index] = transitionTime;
+    transitionEasing[index] = transitionEase;
+}
+
+/**
+ * @brief "Activates" a pixel in the given layer with color and alpha
+ * 
+ * @param layer layer of the pixel (layer_base ignores alpha)
+ * @param x x-position of pixel
+ * @param y y-position of pixel
+ * @param color color of pixel
+ * @param alpha alpha of pixel (0 = transparent, 255 = opaque)
+ */
+void LEDMatrix::layerAddPixel(Layer layer, uint8_t x, uint8_t y, uint32_t color, uint8_t alpha)
+{
+  if(x < WIDTH && y < HEIGHT){
+    setLayerColor(layer, y * WIDTH + x, color, alpha);
+  }
+}
+
+/**
+ * @brief "Deactivates" a pixel in the given layer (base layer: set to black, other layers: transparent)
+ * 
+ * @param layer layer of the pixel
+ * @param x x-position of pixel
+ * @param y y-position of pixel
+ */
+void LEDMatrix::layerRemovePixel(Layer layer, uint8_t x, uint8_t y)
+{
+  if(x < WIDTH && y < HEIGHT){
+    setLayerColor(layer, y * WIDTH + x, 0, 0);
+  }
+}
+
+/**
+ * @brief "Deactivates" all pixels of the given layer, the other layers are kept
+ * 
+ * @param layer layer to be flushed
+ */
+void LEDMatrix::layerFlush(Layer layer)
+{
+  if(layer == layer_base){
+    gridFlush();
+    return;
+  }
+  SparseAlphaLayer<LAYER_MAX_PIXELS> &pixels = layers[layer - 1];
+  while(pixels.size() > 0){
+    setLayerColor(layer, pixels.indexAt(pixels.size() - 1), 0, 0);
+  }
+}
+
+/**
+ * @brief Set color of one led in one layer, marks the led dirty if the composited target color changes.
+ * The transition is started by the next frame (with the time of the first change since the last frame),
+ * so a led which is flushed and set to the same color again keeps its running transition.
+ * 
+ * @param layer layer of the led
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ * @param color new color
+ * @param alpha alpha of the color (ignored in base layer, 0 removes the led from overlay/status layer)
+ */
+void LEDMatrix::setLayerColor(Layer layer, uint8_t index, uint32_t color, uint8_t alpha)
+{
+    uint32_t oldTarget = getTargetColor(index);
+    if(layer == layer_base){
+      if(targetColors.get(index) == color){
+        return;
+      }
+      targetColors.set(index, color);
+    }
+    else if(!layers[layer - 1].set(index, color, alpha)){
+      // layer is full
+      return;
+    }
+    if(getTargetColor(index) != oldTarget){
+      if(!targetsChanged){
+        targetsChanged = true;
+        targetChangeTime = millis();
+      }
+      markDirty(index);
+    }
+}
+
+/**
+ * @brief Composite target color of one led from all layers (base -> overlay -> status)
+ * 
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ * @return uint32_t composited target color
+ */
+uint32_t LEDMatrix::getTargetColor(uint8_t index)
+{
+    uint32_t result = targetColors.get(index);
+    for(uint8_t i = 0; i < 2; i++){
+      uint32_t color;
+      uint8_t alpha;
+      if(layers[i].size() > 0 && layers[i].get(index, color, alpha)){
+        // alpha 0..255 -> blend factor 0..BLEND_FACTOR_ONE
+        result = interpolateColor24bitFixed(result, color, alpha + (alpha >> 7));
+      }
+    }
+    return result;
+}
+
+/**
+ * @brief Mark led as dirty, it will be blended and written to the strip in the next frames
+ * 
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ */
+void LEDMatrix::markDirty(uint8_t index)
+{
+    dirtyLEDs[index >> 5] |= (1UL << (index & 31));
+    converged = false;
+}
+
+/**
+ * @brief Check if led is marked as dirty
+ * 
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ * @return true if led has not reached its target color yet
+ */
+bool LEDMatrix::isDirty(uint8_t index)
+{
+    return (dirtyLEDs[index >> 5] >> (index & 31)) & 1;
+}
+
+/**
+ * @brief Force a rewrite of all leds in the next frame, 
+ * needed if the strip was modified directly (e.g. LED test) or the brightness changed
+ * 
+ */
+void LEDMatrix::forceRedraw()
+{
+    redrawAll = true;
+    converged = false;
 }
 
 /**
@@ -167,51 +373,182 @@ void LEDMatrix::gridFlush(void)
  * 
  */
 void LEDMatrix::drawOnMatrixInstant(){
-  drawOnMatrix(1.0);
+  drawOnMatrix(true);
+}
+
+/**
+ * @brief Write target pixels with time based transitions to leds
+ * 
+ */
+void LEDMatrix::drawOnMatrixSmooth(){
+  drawOnMatrix(false);
 }
 
 /**
- * @brief Write target pixels with low pass filter to leds
+ * @brief Set duration and easing of the transitions which are started by following changes of the target colors
  * 
- * @param factor factor between 0 and 1 (1.0 = hard, 0.1 = smooth)
+ * @param durationMs duration of one transition in ms (0 = no smoothing, max 255 * TRANSITION_TIME_UNIT)
+ * @param easing easing curve of the transition
  */
-void LEDMatrix::drawOnMatrixSmooth(float factor){
-  drawOnMatrix(factor);
+void LEDMatrix::setTransition(uint16_t durationMs, Easing easing){
+  transitionTime = min(durationMs / TRANSITION_TIME_UNIT, 255);
+  transitionEase = easing;
 }
 
 /**
- * @brief Draws the targetgrid to the ledmatrix
+ * @brief Write 24bit color of one led directly into the pixel buffer of the strip (GRB order), 
+ * bypasses the remapping and 16bit conversion of Adafruit_GFX drawPixel.
+ * Each channel is gamma corrected and scaled with 8 fractional bits, 
+ * the fractional part is rounded (or dithered over time).
  * 
- * @param factor factor between 0 and 1 (1.0 = hard, 0.1 = smooth)
+ * @param pixels pointer to pixel buffer of the strip
+ * @param index strip index of the led
+ * @param color 24bit color value
+ * @param threshold rounding threshold for the fractional part (128 = round to nearest)
  */
-void LEDMatrix::drawOnMatrix(float factor){
-  uint16_t totalCurrent = 0;
-  // loop over all leds in matrix
-  for(int s = 0; s < WIDTH; s++){
-    for(int z = 0; z < HEIGHT; z++){
-      // inplement momentum as smooth transistion function
-      uint32_t filteredColor = interpolateColor24bit(currentgrid[z][s], targetgrid[z][s], factor);
-      (*neomatrix).drawPixel(s, z, color24to16bit(filteredColor)); 
-      currentgrid[z][s] = filteredColor;
-      totalCurrent += calcEstimatedLEDCurrent(filteredColor);
-    } 
+void LEDMatrix::writeLED(uint8_t *pixels, uint8_t index, uint32_t color, uint8_t threshold)
+{
+    // same scaling as Adafruit_NeoPixel::setPixelColor (brightness 255 -> factor 256 -> unchanged)
+    uint16_t scale = (*neomatrix).getBrightness() + 1;
+    uint8_t *p = &pixels[index * 3];
+    p[0] = (((pgm_read_word(&gammaTable.values[color >> 8 & 0xff]) * scale) >> 8) + threshold) >> 8;   // green
+    p[1] = (((pgm_read_word(&gammaTable.values[color >> 16 & 0xff]) * scale) >> 8) + threshold) >> 8;  // red
+    p[2] = (((pgm_read_word(&gammaTable.values[color & 0xff]) * scale) >> 8) + threshold) >> 8;        // blue
+}
+
+/**
+ * @brief Calc color of one led on the way from start to target color. 
+ * The progress is calculated from millis(), so the speed of a transition does not depend on the frame rate.
+ * Clears the dirty bit when the transition is finished.
+ * 
+ * @param index index of the led (y * WIDTH + x, minute indicators follow the grid)
+ * @param target target color of the led
+ * @param now current time (millis())
+ * @param instant true -> finish transition immediately
+ * @return uint32_t new current color of the led
+ */
+uint32_t LEDMatrix::transitionPixel(uint8_t index, uint32_t target, uint32_t now, bool instant)
+{
+    if(target != transitionTargets.get(index)){
+      // target changed since the last frame -> fade from the current color to the new target
+      startTransition(index, target, targetChangeTime);
+    }
+    uint16_t duration = transitionDuration[index] * TRANSITION_TIME_UNIT;
+    uint32_t elapsed = now - transitionStart[index];
+    if(instant || elapsed >= duration || startColors.get(index) == target){
+      dirtyLEDs[index >> 5] &= ~(1UL << (index & 31));
+      return target;
+    }
+    uint16_t progress = ((uint32_t)elapsed << 8) / duration;
+    return easeColor24bit(startColors.get(index), target, progress, transitionEasing[index]);
+}
+
+/**
+ * @brief Interpolates two colors24bit along an easing curve
+ * 
+ * @param color1 startcolor of transition
+ * @param color2 endcolor of transition
+ * @param progress linear progress of transition (Q8: 0 = start, BLEND_FACTOR_ONE = end)
+ * @param easing easing curve:
+ *               ease_linear - constant speed, 
+ *               ease_inout - slow start and end (smoothstep), 
+ *               ease_crossfade - startcolor fades out in first half, endcolor fades in in second half
+ * @return uint32_t interpolated color
+ */
+uint32_t LEDMatrix::easeColor24bit(uint32_t color1, uint32_t color2, uint16_t progress, uint8_t easing)
+{
+    switch(easing){
+      case ease_inout:
+        // smoothstep: 3p^2 - 2p^3
+        progress = ((uint32_t)progress * progress * (3 * BLEND_FACTOR_ONE - 2 * progress)) >> 16;
+        return interpolateColor24bitFixed(color1, color2, progress);
+      case ease_crossfade:
+        if(progress < BLEND_FACTOR_ONE / 2){
+          return interpolateColor24bitFixed(color1, 0, progress * 2);
+        }
+        return interpolateColor24bitFixed(0, color2, (progress - BLEND_FACTOR_ONE / 2) * 2);
+      default:
+        return interpolateColor24bitFixed(color1, color2, progress);
+    }
+}
+
+/**
+ * @brief Draws the composited layers to the ledmatrix. 
+ * Only dirty leds are blended, if all leds reached their target color the frame is skipped completely.
+ * 
+ * @param instant true -> all transitions are finished immediately
+ */
+void LEDMatrix::drawOnMatrix(bool instant){
+  if(output != nullptr){
+    // start pending frame of background output driver
+    (*output).loop();
+  }
+
+  if(converged){
+    // nothing changed since last frame -> no need to blend or send data to leds
+    skippedFrames++;
+    return;
+  }
+
+  if(profiler != nullptr){
+    (*profiler).start(stage_blend);
+  }
+
+  // remember which leds change in this frame, dirty bits get cleared while blending
+  uint32_t changedLEDs[DIRTY_WORDS];
+  memcpy(changedLEDs, dirtyLEDs, sizeof(dirtyLEDs));
+  uint32_t now = millis();
+
+  // loop over all leds in matrix and minute indicator leds
+  for(uint8_t index = 0; index < NUM_LEDS; index++){
+    if(isDirty(index)){
+      uint32_t currentColor = currentColors.get(index);
+      uint32_t filteredColor = transitionPixel(index, getTargetColor(index), now, instant);
+      updateChannelSums(currentColor, filteredColor);
+      currentColors.set(index, filteredColor);
+    }
+  }
+  // all changed targets have their transition now
+  targetsChanged = false;
+
+  // adapt brightness to current limit, a brightness change needs all leds to be written again
+  bool limiterRecovering = updateCurrentLimiter();
+  if((*neomatrix).getBrightness() != limitedBrightness){
+    (*neomatrix).setBrightness(limitedBrightness);
+    redrawAll = true;
   }
 
-  // loop over all minute indicator leds
-  for(int i = 0; i < 4; i++){
-    uint32_t filteredColor = interpolateColor24bit(currentindicators[i], targetindicators[i], factor);
-    (*neomatrix).drawPixel(WIDTH - (1+i), HEIGHT, color24to16bit(filteredColor));
-    currentindicators[i] = filteredColor;
-    totalCurrent += calcEstimatedLEDCurrent(filteredColor);
+  // temporal dithering at low brightness -> every frame differs, all leds need to be written
+  bool ditherActive = dithering && limitedBrightness < DITHER_MAX_BRIGHTNESS;
+  if(ditherActive){
+    redrawAll = true;
+    ditherFrame++;
   }
 
-  // Check if totalCurrent reaches CURRENTLIMIT -> if yes reduce brightness
-  if(totalCurrent > currentLimit){
-    uint8_t newBrightness = brightness * float(currentLimit)/float(totalCurrent);
-    //logger->logString("CurrentLimit reached!!!: " + String(totalCurrent) + ", new: " + String(newBrightness));
-    (*neomatrix).setBrightness(newBrightness);
+  // write changed leds to the strip
+  uint8_t *pixels = (*neomatrix).getPixels();
+  for(uint8_t index = 0; index < NUM_LEDS; index++){
+    if(redrawAll || ((changedLEDs[index >> 5] >> (index & 31)) & 1)){
+      uint8_t stripIdx = stripIndex[index];
+      writeLED(pixels, stripIdx, currentColors.get(index), ditherActive ? ditherThresholds[(ditherFrame + stripIdx) & 7] : 128);
+    }
+  }
+  redrawAll = false;
+
+  if(profiler != nullptr){
+    (*profiler).stop(stage_blend);
+  }
+
+  showStrip();
+  renderedFrames++;
+
+  // check if all leds reached their target color (and brightness is stable, no dithering)
+  converged = !limiterRecovering && !ditherActive;
+  for(uint8_t i = 0; i < DIRTY_WORDS; i++){
+    if(dirtyLEDs[i] != 0){
+      converged = false;
+    }
   }
-  (*neomatrix).show();
 }
 
 /**
@@ -267,28 +604,77 @@ void LEDMatrix::printChar(uint8_t xpos, uint8_t ypos, char character, uint32_t c
  */
 void LEDMatrix::setBrightness(uint8_t mybrightness){
   brightness = mybrightness;
+  limitedBrightness = mybrightness;
   (*neomatrix).setBrightness(brightness);
+  // strip rescales its buffer lossy -> write all leds again from the current colors
+  forceRedraw();
 }
 
 /**
- * @brief Calc estimated current (mA) for one pixel with the given color and brightness
+ * @brief Gamma corrected value of a color channel as sent to the led (0-255)
  * 
- * @param color 24bit color value of the pixel for which the current should be calculated
- * @return the current in mA
+ * @param value linear value of the color channel
+ * @return uint8_t gamma corrected value
  */
-uint16_t LEDMatrix::calcEstimatedLEDCurrent(uint32_t color){
-  // extract rgb values
-  uint8_t red = color >> 16 & 0xff;
-  uint8_t green = color >> 8 & 0xff;
-  uint8_t blue = color & 0xff;
-  
-  // Linear estimation: 20mA for full brightness per LED 
-  // (calculation avoids float numbers)
-  uint32_t estimatedCurrent = (20 * red) + (20 * green) + (20 * blue);
-  estimatedCurrent /= 255;
-  estimatedCurrent = (estimatedCurrent * brightness)/255;
+static inline uint8_t gammaCorrected(uint8_t value){
+  return pgm_read_word(&gammaTable.values[value]) >> 8;
+}
 
-  return estimatedCurrent;
+/**
+ * @brief Update the running sums of all color channels when one led changes its color.
+ * The sums are built from the gamma corrected values, as these define the duty cycle of the leds.
+ * 
+ * @param oldColor previous 24bit color value of the led
+ * @param newColor new 24bit color value of the led
+ */
+void LEDMatrix::updateChannelSums(uint32_t oldColor, uint32_t newColor){
+  channelSums[0] = channelSums[0] - gammaCorrected(oldColor >> 16 & 0xff) + gammaCorrected(newColor >> 16 & 0xff);
+  channelSums[1] = channelSums[1] - gammaCorrected(oldColor >> 8 & 0xff) + gammaCorrected(newColor >> 8 & 0xff);
+  channelSums[2] = channelSums[2] - gammaCorrected(oldColor & 0xff) + gammaCorrected(newColor & 0xff);
+}
+
+/**
+ * @brief Estimate the total current (mA) of all leds from the channel sums 
+ * and adapt the brightness to the current limit.
+ * 
+ * If the limit is exceeded the brightness is reduced immediately. 
+ * It recovers stepwise as soon as the estimated current drops below the lower 
+ * threshold of the hysteresis (CURRENT_LIMIT_HYSTERESIS percent below the limit).
+ * 
+ * @return true if the brightness is still recovering (further frames needed)
+ */
+bool LEDMatrix::updateCurrentLimiter(){
+  // The current of a channel is proportional to its PWM duty cycle, i.e. the gamma corrected value 
+  // scaled by the brightness: LED_CURRENT_PER_CHANNEL mA at 255 and full brightness.
+  // (calculation avoids float numbers, fits in 32bit for all 125 leds at full white)
+  uint32_t channelTotal = channelSums[0] + channelSums[1] + channelSums[2];
+  uint32_t requestedCurrent = (channelTotal * LED_CURRENT_PER_CHANNEL / 255) * brightness / 255;
+  uint32_t recoveryLimit = (uint32_t)currentLimit * (100 - CURRENT_LIMIT_HYSTERESIS) / 100;
+
+  // highest brightness which keeps the current below the limit
+  uint8_t maxBrightness = brightness;
+  if(requestedCurrent > currentLimit){
+    maxBrightness = brightness * currentLimit / requestedCurrent;
+  }
+  // brightness up to which a limited matrix is allowed to recover
+  uint8_t recoveryBrightness = brightness;
+  if(requestedCurrent > recoveryLimit){
+    recoveryBrightness = brightness * recoveryLimit / requestedCurrent;
+  }
+
+  if(limitedBrightness > maxBrightness){
+    if(limitedBrightness == brightness){
+      limiterActivations++;
+    }
+    limitedBrightness = maxBrightness;
+  }
+  else if(limitedBrightness < recoveryBrightness){
+    limitedBrightness = min(limitedBrightness + LIMITER_RECOVERY_STEP, (int)recoveryBrightness);
+  }
+
+  estimatedCurrent = (brightness > 0) ? requestedCurrent * limitedBrightness / brightness : 0;
+
+  return limitedBrightness < recoveryBrightness;
 }
 
 /**
@@ -298,4 +684,115 @@ uint16_t LEDMatrix::calcEstimatedLEDCurrent(uint32_t color){
  */
 void LEDMatrix::setCurrentLimit(uint16_t mycurrentLimit){
   currentLimit = mycurrentLimit;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Enable temporal dithering at low brightness (< DITHER_MAX_BRIGHTNESS). 
+ * The fractional part of the gamma corrected values is distributed over 8 frames, 
+ * but frames are not skipped anymore -> use with short update period only.
+ * 
+ * @param on true -> dithering enabled
+ */
+void LEDMatrix::setDithering(bool on){
+  dithering = on;
+  forceRedraw();
+}
+
+/**
+ * @brief Set the output driver which sends the frames to the leds
+ * 
+ * @param myoutput pointer to output driver (nullptr -> blocking neomatrix->show())
+ */
+void LEDMatrix::setOutput(LEDOutput *myoutput){
+  output = myoutput;
+  if(output != nullptr){
+    (*output).begin();
+  }
+  forceRedraw();
+}
+
+/**
+ * @brief Set the profiler which measures the duration of blending (stage_blend) and sending (stage_show) of frames
+ * 
+ * @param myprofiler pointer to profiler (nullptr -> no measurement)
+ */
+void LEDMatrix::setProfiler(Profiler *myprofiler){
+  profiler = myprofiler;
+}
+
+/**
+ * @brief Send the pixel buffer of the strip to the leds via the selected output driver
+ * 
+ */
+void LEDMatrix::showStrip(){
+  if(profiler != nullptr){
+    (*profiler).start(stage_show);
+  }
+  if(output != nullptr){
+    (*output).show((*neomatrix).getPixels(), (*neomatrix).numPixels() * 3);
+  }
+  else{
+    (*neomatrix).show();
+  }
+  if(profiler != nullptr){
+    (*profiler).stop(stage_show);
+  }
+}
+
+/**
+ * @brief Get number of frames which were sent to the leds
+ * 
+ * @return uint32_t number of rendered frames
+ */
+uint32_t LEDMatrix::getRenderedFrames(){
+  return renderedFrames;
+}
+
+/**
+ * @brief Get number of frames which were skipped because nothing changed
+ * 
+ * @return uint32_t number of skipped frames
+ */
+uint32_t LEDMatrix::getSkippedFrames(){
+  return skippedFrames;
+}
+
+/**
+ * @brief Get the estimated current of all leds (with applied brightness)
+ * 
+ * @return uint16_t estimated current in mA
+ */
+uint16_t LEDMatrix::getEstimatedCurrent(){
+  return estimatedCurrent;
+}
+
+/**
+ * @brief Get the brightness which is currently applied to the leds (reduced by current limiter)
+ * 
+ * @return uint8_t applied brightness [0..255]
+ */
+uint8_t LEDMatrix::getLimitedBrightness(){
+  return limitedBrightness;
+}
+
+/**
+ * @brief Get how often the current limiter reduced the brightness
+ * 
+ * @return uint32_t number of current limiter activations
+ */
+uint32_t LEDMatrix::getLimiterActivations(){
+  return limiterActivations;
+}
+/**
+ * @brief Get how many target colors could not be stored exactly because the palette was full
+ * (always 0 if LEDMATRIX_PALETTE_TARGET is disabled)
+ * 
+ * @return uint32_t number of palette overflows
+ */
+uint32_t LEDMatrix::getPaletteOverflows(){
+#if LEDMATRIX_PALETTE_TARGET
+  return targetColors.getPaletteOverflows();
+#else
+  return 0;
+#endif
+}
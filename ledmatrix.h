@@ -5,6 +5,9 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_NeoMatrix.h>
 #include "udplogger.h"
+#include "ledoutput.h"
+#include "colorbuffer.h"
+#include "profiler.h"
 
 // width of the led matrix
 #define WIDTH 11
@@ -12,6 +15,43 @@
 #define HEIGHT 11
 
 #define DEFAULT_CURRENT_LIMIT 9999
+// estimated current (mA) of one color channel of one led at full brightness
+#define LED_CURRENT_PER_CHANNEL 20
+// brightness recovers only if the current is this many percent below the current limit
+#define CURRENT_LIMIT_HYSTERESIS 10
+// brightness steps per frame when recovering from current limit
+#define LIMITER_RECOVERY_STEP 2
+
+// number of minute indicator leds (additional row below the matrix)
+#define NUM_INDICATORS 4
+// number of leds (grid + indicators)
+#define NUM_LEDS (WIDTH * HEIGHT + NUM_INDICATORS)
+// number of 32bit words needed to store one dirty bit per led (grid + indicators)
+#define DIRTY_WORDS ((NUM_LEDS + 31) / 32)
+
+// 1 -> target colors are stored as 4bit palette indices (max. 16 different colors at the same time, saves RAM),
+// 0 -> target colors are stored as packed RGB888
+#ifndef LEDMATRIX_PALETTE_TARGET
+#define LEDMATRIX_PALETTE_TARGET 0
+#endif
+
+// maximum number of pixels in the overlay and status layer
+#define LAYER_MAX_PIXELS 16
+
+// resolution of transition durations (ms), max duration is 255 * TRANSITION_TIME_UNIT
+#define TRANSITION_TIME_UNIT 10
+
+// temporal dithering is only applied below this brightness
+#define DITHER_MAX_BRIGHTNESS 64
+
+// blend factor (Q8 fixed point) which represents 1.0 -> target color is taken over directly
+#define BLEND_FACTOR_ONE 256
+
+// layers of the matrix, composited from bottom (base) to top (status)
+enum Layer {layer_base, layer_overlay, layer_status};
+
+// easing curves for led transitions
+enum Easing {ease_linear, ease_inout, ease_crossfade};
 
 class LEDMatrix{
     public:
@@ -19,40 +59,123 @@ class LEDMatrix{
         static uint32_t Color24bit(uint8_t r, uint8_t g, uint8_t b);
         static uint16_t color24to16bit(uint32_t color24bit);
         static uint32_t Wheel(uint8_t WheelPos);
-        static uint32_t interpolateColor24bit(uint32_t color1, uint32_t color2, float factor);
+        static uint32_t interpolateColor24bitFixed(uint32_t color1, uint32_t color2, uint16_t factor);
         void setupMatrix();
         void setMinIndicator(uint8_t pattern, uint32_t color);
         void gridAddPixel(uint8_t x, uint8_t y, uint32_t color);
+        void gridSetPixels(uint16_t index, const uint8_t *rgb, uint16_t count);
         void gridFlush(void);
+        void layerAddPixel(Layer layer, uint8_t x, uint8_t y, uint32_t color, uint8_t alpha = 255);
+        void layerRemovePixel(Layer layer, uint8_t x, uint8_t y);
+        void layerFlush(Layer layer);
         void drawOnMatrixInstant();
-        void drawOnMatrixSmooth(float factor);
+        void drawOnMatrixSmooth();
+        void setTransition(uint16_t durationMs, Easing easing);
         void printNumber(uint8_t xpos, uint8_t ypos, uint8_t number, uint32_t color);
         void printChar(uint8_t xpos, uint8_t ypos, char character, uint32_t color);
         void setBrightness(uint8_t mybrightness);
         void setCurrentLimit(uint16_t mycurrentLimit);
+        void forceRedraw();
+        void setOutput(LEDOutput *myoutput);
+        void setProfiler(Profiler *myprofiler);
+        void setDithering(bool on);
+        void showStrip();
+        uint32_t getRenderedFrames();
+        uint32_t getSkippedFrames();
+        uint16_t getEstimatedCurrent();
+        uint8_t getLimitedBrightness();
+        uint32_t getLimiterActivations();
+        uint32_t getPaletteOverflows();
+        uint32_t getTargetColor(uint8_t index);
 
     private:
 
         Adafruit_NeoMatrix *neomatrix;
         UDPLogger *logger;
 
+        // optional output driver, if not set the strip is sent with neomatrix->show() (blocking)
+        LEDOutput *output = nullptr;
+        Profiler *profiler = nullptr;
+
         uint8_t brightness;
         uint16_t currentLimit;
 
-        // target representation of matrix as 2D array
-        uint32_t targetgrid[HEIGHT][WIDTH] = {0};
+        // brightness applied to the leds, reduced by the current limiter
+        uint8_t limitedBrightness;
+
+        // running sums of the gamma corrected red, green and blue values of all current leds
+        uint32_t channelSums[3] = {0, 0, 0};
+
+        // estimated current (mA) of last rendered frame
+        uint16_t estimatedCurrent = 0;
+
+        // number of times the current limiter had to reduce the brightness
+        uint32_t limiterActivations = 0;
+
+        // target colors of all leds in the base layer (index = y * WIDTH + x, minute indicators after grid)
+#if LEDMATRIX_PALETTE_TARGET
+        PaletteColorBuffer<NUM_LEDS> targetColors;
+#else
+        PackedColorBuffer<NUM_LEDS> targetColors;
+#endif
+
+        // overlay and status layer (only the pixels which are set, with alpha), drawn over the base layer
+        SparseAlphaLayer<LAYER_MAX_PIXELS> layers[2];
+
+        // current colors of all leds (index = y * WIDTH + x, minute indicators after grid)
+        PackedColorBuffer<NUM_LEDS> currentColors;
+
+        // color of each led at the start of its transition (index = y * WIDTH + x, minute indicators after grid)
+        PackedColorBuffer<NUM_LEDS> startColors;
+
+        // target color of the running (or last) transition of each led (index = y * WIDTH + x, minute indicators after grid)
+        PackedColorBuffer<NUM_LEDS> transitionTargets;
+
+        // start time (millis()), duration (in TRANSITION_TIME_UNIT) and easing of each led transition
+        // (32 bit, so a transition is finished correctly even if no frame was drawn for more than 65 s)
+        uint32_t transitionStart[NUM_LEDS] = {0};
+        uint8_t transitionDuration[NUM_LEDS] = {0};
+        uint8_t transitionEasing[NUM_LEDS] = {0};
+
+        // duration and easing for new transitions
+        uint8_t transitionTime = 0;
+        Easing transitionEase = ease_linear;
+
+        // true if a target color changed since the last frame, time of the first change (start of the new transitions)
+        bool targetsChanged = false;
+        uint32_t targetChangeTime = 0;
+
+        // strip index of each led, precomputed for layout NEO_MATRIX_TOP + NEO_MATRIX_LEFT + NEO_MATRIX_ROWS + NEO_MATRIX_ZIGZAG
+        // (index = y * WIDTH + x, minute indicators after grid)
+        uint8_t stripIndex[NUM_LEDS];
+
+        // one bit per led which is set while current and target color differ (index = y * WIDTH + x, indicators after grid)
+        uint32_t dirtyLEDs[DIRTY_WORDS] = {0};
+
+        // true if all leds reached their target color and the strip shows them -> nothing to draw
+        bool converged = false;
 
-        // current representation of matrix as 2D array
-        uint32_t currentgrid[HEIGHT][WIDTH] = {0};
+        // true if every led needs to be written to the strip in the next frame (not only the dirty ones)
+        bool redrawAll = true;
 
-        // target representation of minutes indicator leds
-        uint32_t targetindicators[4] = {0, 0, 0, 0};
+        // temporal dithering enabled, frame counter for dither thresholds
+        bool dithering = false;
+        uint8_t ditherFrame = 0;
 
-        // current representation of minutes indicator leds
-        uint32_t currentindicators[4] = {0, 0, 0, 0};
+        // statistics about drawn and skipped frames
+        uint32_t renderedFrames = 0;
+        uint32_t skippedFrames = 0;
 
-        void drawOnMatrix(float factor);
-        uint16_t calcEstimatedLEDCurrent(uint32_t color);
+        void drawOnMatrix(bool instant);
+        void startTransition(uint8_t index, uint32_t target, uint32_t start);
+        void markDirty(uint8_t index);
+        bool isDirty(uint8_t index);
+        void writeLED(uint8_t *pixels, uint8_t index, uint32_t color, uint8_t threshold);
+        void setLayerColor(Layer layer, uint8_t index, uint32_t color, uint8_t alpha);
+        uint32_t transitionPixel(uint8_t index, uint32_t target, uint32_t now, bool instant);
+        static uint32_t easeColor24bit(uint32_t color1, uint32_t color2, uint16_t progress, uint8_t easing);
+        void updateChannelSums(uint32_t oldColor, uint32_t newColor);
+        bool updateCurrentLimiter();
 
 
 };
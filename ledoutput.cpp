@@ -0,0 +1,139 @@
+#include "ledoutput.h"
+
+#ifdef ESP8266
+
+#include <Arduino.h>
+#include <ets_sys.h>
+#include <esp8266_peri.h>
+
+#define UART1_TX_PIN 2
+#define UART1_BAUD 3200000
+#define UART1_FIFO_SIZE 128
+// interrupt is triggered when less bytes than this threshold are in the TX FIFO
+#define UART1_FIFO_THRESHOLD 32
+
+// UART bytes for two NeoPixel bits (00, 01, 10, 11), sent LSB first and inverted:
+// start bit + 3 data bits form the first NeoPixel bit, 3 data bits + stop bit the second one
+static const uint8_t uart1Encoding[4] = {0b110111, 0b000111, 0b110100, 0b000100};
+
+/**
+ * @brief Setup UART1 for sending NeoPixel data and attach the interrupt handler
+ *
+ */
+void UART1Output::begin(){
+    pinMode(UART1_TX_PIN, SPECIAL);
+    USD(1) = ESP8266_CLOCK / UART1_BAUD;
+    // 6 data bits, 1 stop bit, no parity, TX inverted
+    USC0(1) = (1 << UCBN) | (1 << UCSBN) | (1 << UCTXI);
+    // reset TX FIFO
+    USC0(1) |= (1 << UCTXRST);
+    USC0(1) &= ~(1 << UCTXRST);
+    USC1(1) = (UART1_FIFO_THRESHOLD << UCFET);
+
+    ETS_UART_INTR_DISABLE();
+    // interrupt is shared with UART0 -> disable interrupts of UART0 (Serial is used for sending only)
+    USIE(0) = 0;
+    USIC(0) = 0xffff;
+    USIE(1) = 0;
+    USIC(1) = 0xffff;
+    ETS_UART_INTR_ATTACH(handleInterrupt, this);
+    ETS_UART_INTR_ENABLE();
+}
+
+/**
+ * @brief Hand over a new frame, returns immediately.
+ * The frame is sent as soon as the previous frame is finished.
+ *
+ * @param pixels frame data (GRB bytes)
+ * @param numBytes number of bytes of the frame
+ */
+void UART1Output::show(const uint8_t *pixels, uint16_t numBytes){
+    _frames.store(pixels, numBytes);
+    loop();
+}
+
+/**
+ * @brief Start the transmission of a pending frame if UART1 is idle, needs to be called regularly
+ *
+ */
+void UART1Output::loop(){
+    if(_transmitting || !_frames.isPending()){
+        return;
+    }
+    if(micros() - _lastByteMicros < UART1OUTPUT_LATCH_US){
+        return;
+    }
+    if(_frames.swap()){
+        startTransmission();
+    }
+}
+
+/**
+ * @brief Check if a frame is still being sent or waiting to be sent
+ *
+ * @return true if a frame is in progress
+ */
+bool UART1Output::isBusy(){
+    return _transmitting || _frames.isPending();
+}
+
+/**
+ * @brief (private) Fill the FIFO with the beginning of the front buffer and enable the FIFO empty interrupt
+ *
+ */
+void UART1Output::startTransmission(){
+    _txData = _frames.front();
+    _txLength = _frames.frontLength();
+    _position = 0;
+    _transmitting = true;
+    ETS_UART_INTR_DISABLE();
+    fillFIFO();
+    if(_transmitting){
+        USIC(1) = (1 << UIFE);
+        USIE(1) |= (1 << UIFE);
+    }
+    ETS_UART_INTR_ENABLE();
+}
+
+/**
+ * @brief (private) Interrupt handler of UART0/UART1, refills the TX FIFO of UART1
+ *
+ * @param arg pointer to UART1Output object
+ */
+void IRAM_ATTR UART1Output::handleInterrupt(void *arg){
+    UART1Output *self = (UART1Output *)arg;
+    uint32_t status = USIS(1);
+    if(status & (1 << UIFE)){
+        self->fillFIFO();
+    }
+    USIC(1) = status;
+    // interrupts of UART0 are not used -> just clear them
+    USIC(0) = USIS(0);
+}
+
+/**
+ * @brief (private) Encode bytes of the front buffer into the TX FIFO until it is full or the frame is finished
+ *
+ */
+void IRAM_ATTR UART1Output::fillFIFO(){
+    const uint8_t *pixels = _txData;
+    uint16_t length = _txLength;
+    uint16_t position = _position;
+    // each pixel byte needs 4 bytes in the FIFO
+    while(position < length && ((USS(1) >> USTXC) & 0xff) <= (UART1_FIFO_SIZE - 4)){
+        uint8_t value = pixels[position++];
+        USF(1) = uart1Encoding[(value >> 6) & 0x3];
+        USF(1) = uart1Encoding[(value >> 4) & 0x3];
+        USF(1) = uart1Encoding[(value >> 2) & 0x3];
+        USF(1) = uart1Encoding[value & 0x3];
+    }
+    _position = position;
+    if(position >= length){
+        // frame complete -> no more FIFO empty interrupts
+        USIE(1) &= ~(1 << UIFE);
+        _lastByteMicros = micros();
+        _transmitting = false;
+    }
+}
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file ledoutput.h
+ * @brief Output drivers to send a frame (GRB bytes) to the NeoPixel leds
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * The UART1 driver is only available on ESP8266.
+ *
+ */
+
+#ifndef ledoutput_h
+#define ledoutput_h
+
+#include <stdint.h>
+#include <string.h>
+
+// maximum size of one frame in bytes (11 x 12 leds, 3 bytes per led)
+#define LEDOUTPUT_MAX_FRAME_BYTES (11 * 12 * 3)
+
+/**
+ * @brief Interface of an output driver which sends frames to the leds
+ *
+ */
+class LEDOutput{
+    public:
+        virtual ~LEDOutput() {}
+        virtual void begin() = 0;
+        virtual void show(const uint8_t *pixels, uint16_t numBytes) = 0;
+        virtual void loop() = 0;
+        virtual bool isBusy() = 0;
+};
+
+/**
+ * @brief Two frame buffers: the back buffer is filled by the main loop,
+ * the front buffer is read by the transmitter (e.g. in an interrupt).
+ * Buffers are only swapped from the main loop while the transmitter is idle.
+ *
+ */
+class LEDFrameBuffers{
+    public:
+        /**
+         * @brief Copy a new frame into the back buffer and mark it as pending
+         *
+         * @param pixels frame data (GRB bytes)
+         * @param numBytes number of bytes of the frame
+         */
+        void store(const uint8_t *pixels, uint16_t numBytes){
+            if(numBytes > LEDOUTPUT_MAX_FRAME_BYTES){
+                numBytes = LEDOUTPUT_MAX_FRAME_BYTES;
+            }
+            memcpy(_buffers[_front ^ 1], pixels, numBytes);
+            _backLength = numBytes;
+            _pending = true;
+        }
+
+        /**
+         * @brief Swap back and front buffer if a frame is pending,
+         * must only be called while the transmitter is idle
+         *
+         * @return true if a new frame is available in the front buffer
+         */
+        bool swap(){
+            if(!_pending){
+                return false;
+            }
+            _front ^= 1;
+            _frontLength = _backLength;
+            _pending = false;
+            return true;
+        }
+
+        bool isPending() const { return _pending; }
+        const uint8_t *front() const { return _buffers[_front]; }
+        uint16_t frontLength() const { return _frontLength; }
+
+    private:
+        uint8_t _buffers[2][LEDOUTPUT_MAX_FRAME_BYTES];
+        uint8_t _front = 0;
+        uint16_t _frontLength = 0;
+        uint16_t _backLength = 0;
+        bool _pending = false;
+};
+
+#ifdef ESP8266
+
+// time (us) after the last byte was put into the FIFO until the next frame may start:
+// FIFO drain (128 bytes * 2.5 us) + latch/reset time of the leds (> 280 us)
+#define UART1OUTPUT_LATCH_US 700
+
+/**
+ * @brief Sends frames in the background via UART1 (GPIO2, TX inverted, 3.2 MBaud, 6N1).
+ * One UART byte (start + 6 data + stop bits) encodes two NeoPixel bits.
+ * The TX FIFO is refilled in the UART interrupt, so the main loop does not block
+ * while a frame is sent and interrupts stay enabled (WiFi keeps running).
+ *
+ * Note: the UART interrupt is shared with UART0, Serial can only be used for sending.
+ *
+ */
+class UART1Output : public LEDOutput{
+    public:
+        void begin();
+        void show(const uint8_t *pixels, uint16_t numBytes);
+        void loop();
+        bool isBusy();
+
+    private:
+        LEDFrameBuffers _frames;
+        const uint8_t *_txData = nullptr;
+        uint16_t _txLength = 0;
+        volatile bool _transmitting = false;
+        volatile uint16_t _position = 0;
+        volatile uint32_t _lastByteMicros = 0;
+
+        void startTransmission();
+        static void handleInterrupt(void *arg);
+        void fillFIFO();
+};
+
+#endif
+
+#endif
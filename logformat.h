@@ -0,0 +1,128 @@
+/**
+ * @file logformat.h
+ * @brief Binary log protocol of UDPLogger (UDPLOGGER_BINARY = 1)
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * Instead of the formatted text, the logger sends the id of the format string and the raw arguments.
+ * The format string itself is sent once in a format record (and again every UDPLOGGER_ANNOUNCE_PERIOD),
+ * the receiver keeps a table of the format strings per device and formats the messages itself.
+ *
+ * Datagram (all numbers little endian):
+ *   header: 'W' 'L' version(1) nameLength(1) name(nameLength) dropped(4)
+ *   records: sequence(2) level(1) length(1) payload(length)
+ *
+ * Payload, first byte is the LogRecordType:
+ *   record_message: type(1) timestamp ms(4) formatId(2) arguments
+ *   record_format:  type(1) formatId(2) format string (without '\0')
+ *
+ * Arguments in order of the conversion specifications of the format string:
+ *   integer (also '*' width/precision, char, pointer): 4 bytes, 8 bytes with ll
+ *   floating point: 4 bytes float
+ *   string: length(1) characters(length)
+ *
+ * The host receiver (receiver/log_receiver.cpp) uses the same definitions.
+ *
+ */
+
+#ifndef logformat_h
+#define logformat_h
+
+#include <stdint.h>
+
+#define LOGFORMAT_MAGIC_0 'W'
+#define LOGFORMAT_MAGIC_1 'L'
+#define LOGFORMAT_VERSION 1
+// bytes in front of the payload of a record (sequence, level, length)
+#define LOGFORMAT_RECORD_HEADER 4
+// bytes in front of the arguments of a message record (type, timestamp, format id)
+#define LOGFORMAT_MESSAGE_HEADER 7
+// bytes in front of the format string of a format record (type, format id)
+#define LOGFORMAT_FORMAT_HEADER 3
+
+enum LogRecordType {record_message, record_format};
+
+// type of the argument which belongs to a conversion specification
+enum LogArgType {arg_none, arg_int32, arg_int64, arg_float, arg_string};
+
+/**
+ * @brief One conversion specification of a format string, e.g. "%-5lu"
+ *
+ */
+struct LogFormatSpec {
+    uint8_t length;         // number of characters of the specification including '%'
+    LogArgType type;        // argument of the conversion
+    uint8_t starArgs;       // number of additional int arguments for '*' width and precision
+    char conversion;        // conversion character, e.g. 'u'
+    uint8_t longs;          // number of 'l' length modifiers
+};
+
+/**
+ * @brief Parse one conversion specification. readChar(i) returns the i-th character of the specification
+ * (allows reading the format string from flash on the device).
+ *
+ * @param readChar function object: char readChar(uint8_t index), index 0 is the '%'
+ * @return LogFormatSpec parsed specification, type arg_none for "%%" or an incomplete specification
+ */
+template<typename ReadChar>
+static inline LogFormatSpec parseLogFormatSpec(ReadChar readChar){
+    LogFormatSpec spec = {1, arg_none, 0, '\0', 0};
+    char c = readChar(spec.length);
+    // flags
+    while(c == '-' || c == '+' || c == ' ' || c == '#' || c == '0'){
+        c = readChar(++spec.length);
+    }
+    // width
+    if(c == '*'){
+        spec.starArgs++;
+        c = readChar(++spec.length);
+    }
+    while(c >= '0' && c <= '9'){
+        c = readChar(++spec.length);
+    }
+    // precision
+    if(c == '.'){
+        c = readChar(++spec.length);
+        if(c == '*'){
+            spec.starArgs++;
+            c = readChar(++spec.length);
+        }
+        while(c >= '0' && c <= '9'){
+            c = readChar(++spec.length);
+        }
+    }
+    // length modifier (int and long are 32bit on the device)
+    while(c == 'h' || c == 'l' || c == 'z' || c == 't' || c == 'j'){
+        if(c == 'l'){
+            spec.longs++;
+        }
+        c = readChar(++spec.length);
+    }
+    spec.conversion = c;
+    if(c == '\0'){
+        spec.starArgs = 0;
+        return spec;
+    }
+    spec.length++;
+    switch(c){
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec.type = (spec.longs >= 2) ? arg_int64 : arg_int32;
+            break;
+        case 'p':
+            spec.type = arg_int32;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            spec.type = arg_float;
+            break;
+        case 's':
+            spec.type = arg_string;
+            break;
+        default:
+            // '%%' or unknown conversion -> no argument
+            spec.starArgs = 0;
+            break;
+    }
+    return spec;
+}
+
+#endif
@@ -3,6 +3,7 @@ import struct
 import sys
 from datetime import datetime
 import queue
+import time
 
 # ip address of network interface
 MCAST_IF_IP = '192.168.0.3'
@@ -10,11 +11,21 @@ MCAST_IF_IP = '192.168.0.3'
 multicast_group = '230.120.10.2'
 server_address = ('', 8123)
 
+# sequence numbers of the log messages are 16bit
+SEQ_MODULO = 65536
+# number of messages which are held back to put out-of-order datagrams in the right order
+REORDER_WINDOW = 32
+# max time (s) a message is held back before missing messages are considered lost
+REORDER_TIMEOUT = 1.0
+# a sequence number behind the expected one after this time (s) without messages is a restart of the device
+RESTART_GAP = 3.0
+
 # Create the socket
 sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
 
 # Bind to the server address
 sock.bind(server_address)
+sock.settimeout(REORDER_TIMEOUT / 2)
 
 print("Start")
 
@@ -29,25 +40,29 @@ saveCounter = 0
 
 buffer = queue.Queue(20)
 
-# Receive/respond loop
-while True:
-    data, address = sock.recvfrom(1024)
-    data_str = data.decode("utf-8").strip()
-    print(address, ": ", data_str)
-    data_str = datetime.now().strftime('%b-%d-%Y_%H%M%S') + ": " + data_str
+# per device: next expected sequence number, held back messages {seq: (text, arrival time)}
+# and arrival time of the last message
+expectedSeq = {}
+pending = {}
+lastSeen = {}
+
+
+def handle_message(address, text):
+    global saveCounter
+    print(address, ": ", text)
+    data_str = datetime.now().strftime('%b-%d-%Y_%H%M%S') + ": " + text
     buffer.put(data_str)
     if buffer.full():
         buffer.get()
 
-
     if "NTP-Update not successful" in data_str or "Start program" in data_str:
         f = open("log.txt",'a')
-        while not buffer.empty():    
+        while not buffer.empty():
             f.write(buffer.get())
             f.write("\n")
         f.close()
         saveCounter = 20
-        
+
     if saveCounter > 0:
         f = open("log.txt",'a')
         f.write(data_str)
@@ -57,3 +72,67 @@ while True:
         f.close()
         saveCounter -= 1
 
+
+def release_pending(address):
+    # put out all held back messages which are next in order,
+    # if the window is full or a message waits too long the missing messages are considered lost
+    device_pending = pending[address]
+    while device_pending:
+        seq = expectedSeq[address]
+        oldest = min(arrival for _, arrival in device_pending.values())
+        if seq in device_pending:
+            handle_message(address, device_pending.pop(seq)[0])
+            expectedSeq[address] = (seq + 1) % SEQ_MODULO
+        elif len(device_pending) >= REORDER_WINDOW or time.time() - oldest > REORDER_TIMEOUT:
+            next_seq = min(device_pending, key=lambda s: (s - seq) % SEQ_MODULO)
+            lost = (next_seq - seq) % SEQ_MODULO
+            handle_message(address, "[receiver] %d message(s) lost (seq %d - %d)" % (lost, seq, (next_seq - 1) % SEQ_MODULO))
+            expectedSeq[address] = next_seq
+        else:
+            break
+
+
+def flush_pending(address):
+    # put out all held back messages in order, the missing messages are considered lost
+    while pending[address]:
+        seq = expectedSeq[address]
+        if seq in pending[address]:
+            handle_message(address, pending[address].pop(seq)[0])
+            expectedSeq[address] = (seq + 1) % SEQ_MODULO
+        else:
+            expectedSeq[address] = min(pending[address], key=lambda s: (s - seq) % SEQ_MODULO)
+
+
+# Receive/respond loop
+while True:
+    try:
+        data, address = sock.recvfrom(2048)
+    except socket.timeout:
+        for device in pending:
+            release_pending(device)
+        continue
+    device = address[0]
+    now = time.time()
+    # one datagram contains several messages, one per line: "<seq> <name>: <text>"
+    for line in data.decode("utf-8", errors="replace").splitlines():
+        seq_str, _, text = line.partition(" ")
+        if not seq_str.isdigit():
+            # message without sequence number (old firmware)
+            handle_message(device, line.strip())
+            continue
+        seq = int(seq_str)
+        if device not in expectedSeq:
+            # first message of device
+            expectedSeq[device] = seq
+            pending[device] = {}
+        behind = (expectedSeq[device] - seq) % SEQ_MODULO
+        if 0 < behind < SEQ_MODULO // 2:
+            if behind <= REORDER_WINDOW and now - lastSeen[device] < RESTART_GAP:
+                # older than expected -> duplicate or too late
+                continue
+            # far behind or after a pause -> restart of device, the held back messages are put out first
+            flush_pending(device)
+            expectedSeq[device] = seq
+        lastSeen[device] = now
+        pending[device][seq] = (text.strip(), now)
+        release_pending(device)
@@ -1,4 +1,5 @@
 #include "ntp_client_plus.h"
+#include <ESP8266WiFi.h>
 
 /**
  * @brief Construct a new NTPClientPlus::NTPClientPlus object
@@ -6,15 +7,24 @@
  * @param udp   UDP client
  * @param poolServerName    time server name
  * @param utcx  UTC offset (in 1h)
- * @param _swChange should summer/winter time be considered
+ * @param _swChange should summer/winter time be considered (EU rules), use setTimeZone() for other rules
  */
 NTPClientPlus::NTPClientPlus(UDP &udp, const char *poolServerName, int utcx, bool _swChange)
 {
     this->_udp = &udp;
-    this->_utcx = utcx;
-    this->_timeOffset = this->secondperhour * this->_utcx;
     this->_poolServerName = poolServerName;
-    this->_swChange = _swChange;
+    if (_swChange)
+    {
+        // EU: last sunday of march and october at 01:00 UTC (offsets of real zones are -12..+14 h)
+        utcx = constrain(utcx, -12, 14);
+        char tz[TZ_MAX_LENGTH];
+        snprintf(tz, sizeof(tz), "<%+03d>%d<%+03d>,M3.5.0/%d,M10.5.0/%d", utcx, -utcx, utcx + 1, 1 + utcx, 2 + utcx);
+        this->_timeZone.parse(tz);
+    }
+    else
+    {
+        this->_timeZone.setFixedOffset(this->secondperhour * utcx);
+    }
 }
 
 /**
@@ -30,66 +40,275 @@ void NTPClientPlus::setupNTPClient()
 }
 
 /**
- * @brief Get new update from NTP
+ * @brief Get new update from NTP with a single request (blocking, waits up to NTP_TIMEOUT for the answer).
+ * Use requestNTP() and pollNTP() in loop() instead.
  * 
- * @return 0     after successful update
- * @return -1    timeout after 1000 ms
- * @return 1     too much difference to previous received time (try again)
+ * @return NTP_UPDATE_SUCCESS (0)       after successful update
+ * @return NTP_UPDATE_TIMEOUT (-1)      timeout after NTP_TIMEOUT ms
+ * @return NTP_UPDATE_DIFFERENCE (1)    too much difference to previous received time (try again)
+ * @return NTP_UPDATE_INVALID (2)       NTP time is not valid
  */
 int NTPClientPlus::updateNTP()
 {
+    this->requestNTP(1);
 
-    // flush any existing packets
-    while (this->_udp->parsePacket() != 0)
-        this->_udp->flush();
+    int result;
+    while ((result = this->pollNTP()) == NTP_UPDATE_PENDING)
+    {
+        delay(10);
+    }
+    return result;
+}
 
+/**
+ * @brief Start an update, the answers are handled by pollNTP(). The update sends a burst of requests
+ * (NTP_BURST_INTERVAL apart) and uses the answer with the shortest round trip, as its offset is the least
+ * distorted by asymmetric network delays.
+ * 
+ * @param samples number of requests of the update
+ */
+void NTPClientPlus::requestNTP(uint8_t samples)
+{
+    this->_burstSize = samples > 0 ? samples : 1;
+    this->_samplesRequested = 0;
+    this->_samplesReceived = 0;
+    this->_updatePending = true;
+
+    // resolve the server once per update (blocking DNS lookup), all requests of the burst are sent to the address.
+    // If the lookup fails, the address of the previous update is used
+    IPAddress serverIP;
+    if (this->_poolServerName && WiFi.hostByName(this->_poolServerName, serverIP))
+    {
+        this->_poolServerIP = serverIP;
+    }
     this->sendNTPPacket();
+}
+
+/**
+ * @brief Check if an update was started and is not finished yet
+ * 
+ * @return true if pollNTP() has to be called
+ */
+bool NTPClientPlus::isUpdatePending() const
+{
+    return this->_updatePending;
+}
 
-    // Wait till data is there or timeout...
-    byte timeout = 0;
-    int cb = 0;
-    do
+/**
+ * @brief Check for the answers of the NTP server without waiting, call regularly after requestNTP().
+ * Answers which do not belong to the current request (late answers of an earlier request) are ignored.
+ * 
+ * @return NTP_UPDATE_PENDING (3)       update not finished yet (or no update started)
+ * @return NTP_UPDATE_SUCCESS (0)       after successful update
+ * @return NTP_UPDATE_TIMEOUT (-1)      no answer to any request of the update
+ * @return NTP_UPDATE_DIFFERENCE (1)    too much difference to previous received time (try again)
+ * @return NTP_UPDATE_INVALID (2)       NTP time is not valid
+ */
+int NTPClientPlus::pollNTP()
+{
+    if (!this->_updatePending)
     {
-        delay(10);
-        cb = this->_udp->parsePacket();
-        if (timeout > 100)
-            return -1; // timeout after 1000 ms
-        timeout++;
-    } while (cb == 0);
+        return NTP_UPDATE_PENDING;
+    }
 
-    this->_udp->read(this->_packetBuffer, NTP_PACKET_SIZE);
+    if (this->_answerPending)
+    {
+        while (this->_udp->parsePacket() != 0)
+        {
+            int size = this->_udp->read(this->_packetBuffer, NTP_PACKET_SIZE);
+            this->_udp->flush();
 
-    unsigned long highWord = word(this->_packetBuffer[40], this->_packetBuffer[41]);
-    unsigned long lowWord = word(this->_packetBuffer[42], this->_packetBuffer[43]);
-    // combine the four bytes (two words) into a long integer
-    // this is NTP time (seconds since Jan 1 1900):
-    unsigned long tempSecsSince1900 = highWord << 16 | lowWord;
+            // the server copies the transmit timestamp of the request into the originate timestamp (bytes 24-31)
+            if (size < NTP_PACKET_SIZE || memcmp(&this->_packetBuffer[24], this->_requestTimestamp, 8) != 0)
+            {
+                // stale or foreign packet, keep waiting for the right answer
+                continue;
+            }
 
-    if(tempSecsSince1900 < SEVENZYYEARS){
+            this->_answerPending = false;
+            if (this->handleNTPPacket(this->getMillisSince1900()) == NTP_UPDATE_INVALID)
+            {
+                this->_updatePending = false;
+                return NTP_UPDATE_INVALID;
+            }
+            break;
+        }
+
+        if (this->_answerPending)
+        {
+            if (millis() - this->_requestTime <= NTP_TIMEOUT)
+            {
+                return NTP_UPDATE_PENDING;
+            }
+            // answer lost, continue with the next request of the burst
+            this->_answerPending = false;
+        }
+    }
+
+    if (this->_samplesRequested < this->_burstSize)
+    {
+        if (millis() - this->_requestTime >= NTP_BURST_INTERVAL)
+        {
+            this->sendNTPPacket();
+        }
+        return NTP_UPDATE_PENDING;
+    }
+
+    this->_updatePending = false;
+    if (this->_samplesReceived == 0)
+    {
+        return NTP_UPDATE_TIMEOUT;
+    }
+    return this->applyNTPSample();
+}
+
+/**
+ * @brief (private) Calc offset and round trip delay of an answer of the NTP server (in _packetBuffer)
+ * and keep it if it has the shortest round trip of the current update
+ * 
+ * @param receiveTime local clock (ms since 1900) when the answer was received
+ * @return int NTP_UPDATE_SUCCESS or NTP_UPDATE_INVALID
+ */
+int NTPClientPlus::handleNTPPacket(uint64_t receiveTime)
+{
+    // mode has to be 4 (server), stratum 0 is a "kiss-o'-death" message (e.g. rate limit)
+    if ((this->_packetBuffer[0] & 0x07) != 4 || this->_packetBuffer[1] == 0)
+    {
+        return NTP_UPDATE_INVALID;
+    }
+
+    // T1: request sent (local), T2: request received (server), T3: answer sent (server), T4: answer received (local)
+    uint64_t serverReceive = this->ntpTimestampToMillis(&this->_packetBuffer[32]);
+    uint64_t serverTransmit = this->ntpTimestampToMillis(&this->_packetBuffer[40]);
+
+    if (serverTransmit < (uint64_t)SEVENZYYEARS * this->millisecondpersecond || serverReceive > serverTransmit)
+    {
         // NTP time is not valid
-        return 2;
+        return NTP_UPDATE_INVALID;
     }
 
-    // check if time off last ntp update is roughly in the same range: 100sec apart (validation check)
-    if(this->_lastSecsSince1900 == 0 || tempSecsSince1900 - this->_lastSecsSince1900 < 100000){
-        // Only update time then
-        this->_lastUpdate = millis() - (10 * (timeout + 1)); // Account for delay in reading the time
+    // offset = ((T2 - T1) + (T3 - T4)) / 2, delay = (T4 - T1) - (T3 - T2)
+    int64_t offset = ((int64_t)(serverReceive - this->_requestMillis) + (int64_t)(serverTransmit - receiveTime)) / 2;
+    long delay = (long)(receiveTime - this->_requestMillis) - (long)(serverTransmit - serverReceive);
+    if (delay < 0)
+    {
+        delay = 0;
+    }
 
-        this->_secsSince1900 = tempSecsSince1900;
+    this->_samplesReceived++;
+    if (this->_samplesReceived == 1 || delay < this->_bestDelay)
+    {
+        this->_bestOffset = offset;
+        this->_bestDelay = delay;
+    }
+    return NTP_UPDATE_SUCCESS;
+}
 
-        this->_currentEpoc = this->_secsSince1900 - SEVENZYYEARS;
+/**
+ * @brief (private) Correct the local clock with the best answer of the update (PI controller):
+ * the offset steps the clock (proportional part), the offset divided by the time since the
+ * last correction is the frequency error of millis() which is integrated into the drift (integral part).
+ * 
+ * @return int NTP_UPDATE_SUCCESS or NTP_UPDATE_DIFFERENCE
+ */
+int NTPClientPlus::applyNTPSample()
+{
+    int64_t offset = this->_bestOffset;
+    int64_t maxDifference = (int64_t)NTP_MAX_DIFFERENCE * this->millisecondpersecond;
+    int64_t changeToLastAnswer = offset - this->_lastOffset;
 
-        // Remember time of last update
-        this->_lastSecsSince1900 = tempSecsSince1900;
+    this->_lastOffset = offset;
+    this->_lastDelay = this->_bestDelay;
 
-        return 0; // return 0 after successful update
+    // check if the time is roughly in the range of the local clock or of the last answer (validation check)
+    if (this->_synchronized && (offset >= maxDifference || offset <= -maxDifference)
+        && (changeToLastAnswer >= maxDifference || changeToLastAnswer <= -maxDifference))
+    {
+        return NTP_UPDATE_DIFFERENCE;
     }
-    else{
-        // Remember time of last update
-        this->_lastSecsSince1900 = tempSecsSince1900;
-        
-        return 1;
+
+    uint64_t localTime = this->getMillisSince1900();
+    unsigned long now = millis();
+    unsigned long interval = now - this->_lastUpdate;
+
+    if (this->_synchronized && offset > -NTP_MAX_FREQ_OFFSET && offset < NTP_MAX_FREQ_OFFSET && interval >= NTP_MIN_FREQ_INTERVAL)
+    {
+        long frequencyError = (long)(offset * 1000000000LL / (int64_t)interval);   // in ppb
+        this->_drift = constrain(this->_drift + frequencyError / (1 << NTP_DRIFT_GAIN_SHIFT), -NTP_MAX_DRIFT, NTP_MAX_DRIFT);
+    }
+
+    this->_baseMillis = localTime + offset;
+    this->_lastUpdate = now;
+    this->_synchronized = true;
+
+    // poll less often while the clock keeps the time well
+    long absOffset = (long)(offset < 0 ? -offset : offset);
+    if (absOffset < NTP_POLL_ADJUST_OFFSET)
+    {
+        this->_pollInterval = min(this->_pollInterval * 2, NTP_MAX_POLL_INTERVAL);
+    }
+    else if (absOffset > 2 * NTP_POLL_ADJUST_OFFSET)
+    {
+        this->_pollInterval = max(this->_pollInterval / 2, NTP_MIN_POLL_INTERVAL);
     }
+
+    // time base has changed -> next boundary has to be calculated again
+    this->rescheduleTimeEvents();
+
+    return NTP_UPDATE_SUCCESS;
+}
+
+/**
+ * @brief (private) Convert a NTP timestamp (seconds and fraction since 1900, big endian) to ms
+ * 
+ * @param timestamp 8 bytes of the NTP packet
+ * @return uint64_t ms since 1. Jan. 1900
+ */
+uint64_t NTPClientPlus::ntpTimestampToMillis(const byte *timestamp)
+{
+    uint32_t seconds = (uint32_t)timestamp[0] << 24 | (uint32_t)timestamp[1] << 16 | (uint32_t)timestamp[2] << 8 | timestamp[3];
+    uint32_t fraction = (uint32_t)timestamp[4] << 24 | (uint32_t)timestamp[5] << 16 | (uint32_t)timestamp[6] << 8 | timestamp[7];
+    return (uint64_t)seconds * millisecondpersecond + (((uint64_t)fraction * millisecondpersecond) >> 32);
+}
+
+/**
+ * @brief Last offset between NTP time and local clock
+ * 
+ * @return long offset in ms
+ */
+long NTPClientPlus::getLastOffset() const
+{
+    return (long)this->_lastOffset;
+}
+
+/**
+ * @brief Round trip delay of the answer used for the last update
+ * 
+ * @return long delay in ms
+ */
+long NTPClientPlus::getLastDelay() const
+{
+    return this->_lastDelay;
+}
+
+/**
+ * @brief Estimated frequency correction of millis()
+ * 
+ * @return long drift in ppb (positive: millis() runs slow)
+ */
+long NTPClientPlus::getDrift() const
+{
+    return this->_drift;
+}
+
+/**
+ * @brief Time until the next update should be started
+ * 
+ * @return unsigned long poll interval in ms
+ */
+unsigned long NTPClientPlus::getPollInterval() const
+{
+    return this->_pollInterval;
 }
 
 /**
@@ -104,18 +323,71 @@ void NTPClientPlus::end()
 }
 
 /**
- * @brief Setter TimeOffset
+ * @brief Set a fixed offset from UTC (time zone without daylight saving time)
  * 
  * @param timeOffset offset from UTC in seconds
  */
 void NTPClientPlus::setTimeOffset(int timeOffset)
 {
-    this->_timeOffset = timeOffset;
+    this->_timeZone.setFixedOffset(timeOffset);
+    this->rescheduleTimeEvents();
 }
 
+/**
+ * @brief Get current offset of the local time from UTC (including daylight saving time)
+ * 
+ * @return long offset in seconds
+ */
 long NTPClientPlus::getTimeOffset()
 {
-    return this->_timeOffset;
+    return this->_timeZone.getOffset((int64_t)(this->getMillisSince1900() / millisecondpersecond) - SEVENZYYEARS);
+}
+
+/**
+ * @brief Set time zone and daylight saving time rules
+ * 
+ * @param tz POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3" (see timezone.h)
+ * @return true if valid, an invalid string leaves the time zone unchanged
+ */
+bool NTPClientPlus::setTimeZone(const char *tz)
+{
+    if (!this->_timeZone.parse(tz))
+    {
+        return false;
+    }
+    this->rescheduleTimeEvents();
+    return true;
+}
+
+/**
+ * @brief Set an already parsed time zone
+ * 
+ * @param timeZone valid time zone (e.g. validated with TimeZone::parse())
+ */
+void NTPClientPlus::setTimeZone(const TimeZone &timeZone)
+{
+    this->_timeZone = timeZone;
+    this->rescheduleTimeEvents();
+}
+
+/**
+ * @brief Get the TZ string of the time zone
+ * 
+ * @return const char* POSIX TZ string
+ */
+const char *NTPClientPlus::getTimeZone() const
+{
+    return this->_timeZone.getString();
+}
+
+/**
+ * @brief Check if daylight saving time is active
+ * 
+ * @return true if daylight saving time
+ */
+bool NTPClientPlus::isDST()
+{
+    return this->_timeZone.isDST((int64_t)(this->getMillisSince1900() / millisecondpersecond) - SEVENZYYEARS);
 }
 
 /**
@@ -126,6 +398,18 @@ long NTPClientPlus::getTimeOffset()
 void NTPClientPlus::setPoolServerName(const char *poolServerName)
 {
     this->_poolServerName = poolServerName;
+    this->_poolServerIP = IPAddress();
+}
+
+/**
+ * @brief Local clock (UTC): time of last correction plus elapsed millis() corrected by the drift
+ * 
+ * @return uint64_t ms since 1. Jan. 1900
+ */
+uint64_t NTPClientPlus::getMillisSince1900() const
+{
+    unsigned long elapsed = millis() - this->_lastUpdate;
+    return this->_baseMillis + elapsed + (int64_t)elapsed * this->_drift / 1000000000LL;
 }
 
 /**
@@ -135,9 +419,9 @@ void NTPClientPlus::setPoolServerName(const char *poolServerName)
  */
 unsigned long NTPClientPlus::getSecsSince1900() const
 {
-    return this->_timeOffset +                      // User offset
-           this->_secsSince1900 +                   // seconds returned by the NTP server
-           ((millis() - this->_lastUpdate) / 1000); // Time since last update
+    unsigned long utc = this->getMillisSince1900() / millisecondpersecond;
+    // offset of time zone, only recalculated after the next transition
+    return utc + this->_timeZone.getOffset((int64_t)utc - SEVENZYYEARS);
 }
 
 /**
@@ -240,73 +524,16 @@ String NTPClientPlus::getFormattedDate() {
  */
 void NTPClientPlus::calcDate()
 {
-    // Start: Calc date
-
     // get days since 1900
     unsigned long days1900 = this->getSecsSince1900() / secondperday;
 
-    // calc current year
-    this->_dateYear = this->getYear();
-
-    // calc how many leap days since 1.Jan 1900
-    int leapDays = 0;
-    for (int i = 1900; i < this->_dateYear; i++)
-    {
-        // check if leap year
-        if (this->isLeapYear(i))
-        {
-            leapDays++;
-        }
-    }
-    leapDays = leapDays - 1;
-
-    // check if current year is leap year
-    if (this->isLeapYear(this->_dateYear))
-    {
-        daysInMonth[2] = 29;
-    }
-    else
-    {
-        daysInMonth[2] = 28;
-    }
-
-    unsigned int dayOfYear = (days1900 - ((this->_dateYear - 1900) * 365) - leapDays);
-
-    // calc current month
-    this->_dateMonth = this->getMonth(dayOfYear);
-
-    this->_dateDay = 0;
-
-    // calc day of month
-    for (int i = 0; i < this->_dateMonth; i++)
-    {
-        this->_dateDay = this->_dateDay + daysInMonth[i];
-    }
-    this->_dateDay = dayOfYear - this->_dateDay;
+    // calc year, month and day of month (constant time)
+    this->civilFromDays((long)days1900 - this->daysFrom1900To1970, this->_dateYear, this->_dateMonth, this->_dateDay);
 
     // calc day of week:
     // Monday = 1, Tuesday = 2, Wednesday = 3, Thursday = 4, Friday = 5, Saturday = 6, Sunday = 7
     // 1. Januar 1900 was a monday
-    this->_dayOfWeek = 1;
-
-    for (int i = 0; i < days1900; i++)
-    {
-
-        if (this->_dayOfWeek < 7)
-        {
-            this->_dayOfWeek = this->_dayOfWeek + 1;
-        }
-        else
-        {
-            this->_dayOfWeek = 1;
-        }
-    }
-
-    // End: Calc date (dateDay, dateMonth, dateYear)
-
-    // calc if summer time active
-
-    this->updateSWChange();
+    this->_dayOfWeek = days1900 % 7 + 1;
 }
 
 /**
@@ -326,45 +553,31 @@ unsigned int NTPClientPlus::getDayOfWeek()
  */
 unsigned int NTPClientPlus::getYear()
 {
+    unsigned int year, month, day;
+    this->civilFromDays((long)(this->getSecsSince1900() / secondperday) - this->daysFrom1900To1970, year, month, day);
+    return year;
+}
 
-    unsigned long sec1900 = this->getSecsSince1900();
-
-    //NTP starts at 1. Jan 1900
-    unsigned int result = 1900;
-    unsigned int dayInYear = 0;
-    unsigned int days = 0;
-    unsigned int days1900 = 0;
-
-    int for_i = 0;
-    bool leapYear = LOW;
-
-    days1900 = sec1900 / this->secondperday;
-
-    for (for_i = 0; for_i < days1900; for_i++)
-    {
-
-        leapYear = this->isLeapYear(result);
-
-        if (leapYear)
-        {
-            dayInYear = 366;
-        }
-
-        else
-        {
-            dayInYear = 365;
-        }
-
-        days++;
-
-        if (days >= dayInYear)
-        {
-            result++;
-            days = 0;
-        }
-    }
-
-    return result;
+/**
+ * @brief Convert days since 1. Jan. 1970 to a date of the gregorian calendar in constant time
+ * (algorithm "civil_from_days" by Howard Hinnant, counts in eras of 400 years starting at 1. March)
+ * 
+ * @param days days since 1. Jan. 1970 (may be negative)
+ * @param year calculated year
+ * @param month calculated month (1-12)
+ * @param day calculated day of month (1-31)
+ */
+void NTPClientPlus::civilFromDays(long days, unsigned int &year, unsigned int &month, unsigned int &day)
+{
+    days += 719468;                                                             // shift epoch to 1. March 0000
+    long era = (days >= 0 ? days : days - 146096) / 146097;                     // 400 year era
+    unsigned long dayOfEra = (unsigned long)(days - era * 146097);              // [0, 146096]
+    unsigned long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;  // [0, 399]
+    unsigned long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);            // [0, 365], from 1. March
+    unsigned long monthFromMarch = (5 * dayOfYear + 2) / 153;                   // [0, 11], March = 0
+    day = dayOfYear - (153 * monthFromMarch + 2) / 5 + 1;
+    month = monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
 }
 
 /**
@@ -409,111 +622,21 @@ bool NTPClientPlus::isLeapYear(unsigned int year)
 /**
  * @brief Get Month of given day of year
  * 
- * @param dayOfYear 
+ * @param dayOfYear day of the current year (1 = 1. Jan.)
  * @return int 
  */
 int NTPClientPlus::getMonth(int dayOfYear)
 {
+    // days before the beginning of each month (without leap day)
+    static const int monthStart[13] = {0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    int leapDay = this->isLeapYear(this->getYear()) ? 1 : 0;
 
-    bool leapYear = this->isLeapYear(this->getYear());
-
-    // Month beginnings
-    int monthMin[13] = {0, 1, 32, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335};
-    // Month endings
-    int monthMax[13] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
-
-    int month = 0;
-
-    int y = 0;
-
-    // Calculation of the beginning and end of each month in the leap year
-    if (leapYear == HIGH)
-    {
-
-        for (y = 3; y < 13; y++)
-        {
-            monthMin[y] = monthMin[y] + 1;
-        }
-
-        for (y = 2; y < 13; y++)
-        {
-            monthMax[y] = monthMax[y] + 1;
-        }
-    }
-
-    // January
-    if (dayOfYear >= monthMin[1] && dayOfYear <= monthMax[1])
-    {
-        month = 1;
-    }
-
-    // February
-    if (dayOfYear >= monthMin[2] && dayOfYear <= monthMax[2])
-    {
-        month = 2;
-    }
-
-    // March
-    if (dayOfYear >= monthMin[3] && dayOfYear <= monthMax[3])
-    {
-        month = 3;
-    }
-
-    // April
-    if (dayOfYear >= monthMin[4] && dayOfYear <= monthMax[4])
-    {
-        month = 4;
-    }
-
-    // May
-    if (dayOfYear >= monthMin[5] && dayOfYear <= monthMax[5])
+    int month = 12;
+    while (month > 1 && dayOfYear <= monthStart[month] + (month > 2 ? leapDay : 0))
     {
-        month = 5;
+        month--;
     }
-
-    // June
-    if (dayOfYear >= monthMin[6] && dayOfYear <= monthMax[6])
-    {
-        month = 6;
-    }
-
-    // July
-    if (dayOfYear >= monthMin[7] && dayOfYear <= monthMax[7])
-    {
-        month = 7;
-    }
-
-    // August
-    if (dayOfYear >= monthMin[8] && dayOfYear <= monthMax[8])
-    {
-        month = 8;
-    }
-
-    // September
-    if (dayOfYear >= monthMin[9] && dayOfYear <= monthMax[9])
-    {
-        month = 9;
-    }
-
-    // October
-    if (dayOfYear >= monthMin[10] && dayOfYear <= monthMax[10])
-    {
-        month = 10;
-    }
-
-    // November
-    if (dayOfYear >= monthMin[11] && dayOfYear <= monthMax[11])
-    {
-        month = 11;
-    }
-
-    // December
-    if (dayOfYear >= monthMin[12] && dayOfYear <= monthMax[12])
-    {
-        month = 12;
-    }
-
-    return month;
+    return (dayOfYear >= 1 && dayOfYear <= 365 + leapDay) ? month : 0;
 }
 
 /**
@@ -522,6 +645,10 @@ int NTPClientPlus::getMonth(int dayOfYear)
  */
 void NTPClientPlus::sendNTPPacket()
 {
+    // flush any existing packets
+    while (this->_udp->parsePacket() != 0)
+        this->_udp->flush();
+
     // set all bytes in the buffer to 0
     memset(this->_packetBuffer, 0, NTP_PACKET_SIZE);
     // Initialize values needed to form NTP request
@@ -535,158 +662,97 @@ void NTPClientPlus::sendNTPPacket()
     this->_packetBuffer[14] = 49;
     this->_packetBuffer[15] = 52;
 
-    // all NTP fields have been given values, now
-    // you can send a packet requesting a timestamp:
-    if (this->_poolServerName)
+    // transmit timestamp (bytes 40-47): local clock (T1), the lowest bits of the fraction
+    // are replaced by micros() to make it unique, the answer has to contain it as originate timestamp
+    this->_requestMillis = this->getMillisSince1900();
+    unsigned long secsSince1900 = this->_requestMillis / millisecondpersecond;
+    unsigned long fraction = (unsigned long)(((this->_requestMillis % millisecondpersecond) << 32) / millisecondpersecond);
+    fraction = (fraction & ~0x3FFUL) | (micros() & 0x3FF);
+    for (int i = 0; i < 4; i++)
     {
-        this->_udp->beginPacket(this->_poolServerName, 123);
-    }
-    else
-    {
-        this->_udp->beginPacket(this->_poolServerIP, 123);
+        this->_requestTimestamp[i] = secsSince1900 >> (24 - 8 * i);
+        this->_requestTimestamp[4 + i] = fraction >> (24 - 8 * i);
     }
+    memcpy(&this->_packetBuffer[40], this->_requestTimestamp, 8);
+
+    // all NTP fields have been given values, now
+    // you can send a packet requesting a timestamp:
+    this->_udp->beginPacket(this->_poolServerIP, 123);
     this->_udp->write(this->_packetBuffer, NTP_PACKET_SIZE);
     this->_udp->endPacket();
+
+    this->_requestTime = millis();
+    this->_samplesRequested++;
+    this->_answerPending = true;
 }
 
 /**
- * @brief (private) Set time offset accordance to summer time
+ * @brief Register a callback which is called when the local time crosses a minute, hour or day boundary
  * 
- * @param summertime 
+ * @param event boundary (event_minute, event_hour or event_day)
+ * @param callback function to call, nullptr to remove the callback
  */
-void NTPClientPlus::setSummertime(bool summertime)
+void NTPClientPlus::setTimeEventCallback(TimeEvent event, TimeEventCallback callback)
 {
-    if (summertime)
-    {
-        this->_timeOffset = this->secondperhour * (this->_utcx + 1);
-    }
-    else
-    {
-        this->_timeOffset = this->secondperhour * (this->_utcx);
-    }
+    this->_timeEventCallbacks[event] = callback;
 }
 
 /**
- * @brief (private) Update Summer/Winter time change
+ * @brief Fire the callbacks of all boundaries which were crossed since the last call.
+ * Has to be called regularly from loop(). Until the deadline of the next minute boundary
+ * is reached, it only compares millis() with the deadline.
  * 
- * @returns bool summertime active
  */
-bool NTPClientPlus::updateSWChange()
+void NTPClientPlus::handleTimeEvents()
 {
-    unsigned int dayOfWeek = this->_dayOfWeek; 
-    unsigned int dateDay = this->_dateDay; 
-    unsigned int dateMonth = this->_dateMonth;
-
-    bool summertimeActive = false;
-    
-    if (this->_swChange)
+    if ((long)(millis() - this->_nextTimeEvent) < 0)
     {
-        //Start: Set summer-/ winter time
+        return;
+    }
 
-        // current month is march
-        if (dateMonth == 3)
-        {
+    unsigned long epochTime = this->getEpochTime();
+    unsigned long minute = epochTime / this->secondperminute;
+    unsigned long lastMinute = this->_lastEventMinute;
 
-            // it is last week in march
-            if ((this->daysInMonth[3] - dateDay) < 7)
-            {
+    // calc deadline of next minute boundary: remaining seconds of current minute minus elapsed ms of current second
+    uint64_t millisSince1900 = this->getMillisSince1900();
+    unsigned long msIntoSecond = millisSince1900 % this->millisecondpersecond;
+    unsigned long secondsToEvent = this->secondperminute - epochTime % this->secondperminute;
 
-                //Example year 2020: March 31 days; Check on March 26, 2020 (Thursday = weekday = 4); 5 days remaining; Last Sunday March 29, 2020
-                //Calculation: 31 - 26 = 5; 5 + 4 = 9;
-                //Result: Last day in March is a Tuesday. There follows another Sunday in October => set winter time
-
-                //Example year 2021: March 31 days; Check on March 30, 2021 (Tuesday = weekday = 2); 1 days remaining; Last Sunday March 28, 2021
-                //Calculation: 31 - 30 = 1; 1 + 2 = 3;
-                //Result: Last day in March is a Wednesday. Changeover to summer time already done => set summer time
-
-                // If today is Sunday (dayOfWeek == 7) then this is already the last sunday in march -> set summer time
-                if(dayOfWeek == 7){
-                    this->setSummertime(1);
-                    summertimeActive = true;
-                }
-
-                //There follows within the last week in March one more Sunday => set winter time
-                else if (((this->daysInMonth[3] - dateDay) + dayOfWeek) >= 7)
-                {
-                    this->setSummertime(0);
-                    summertimeActive = false;
-                }
-
-                // last sunday in march already over -> set summer time
-                else
-                {
-                    this->setSummertime(1);
-                    summertimeActive = true;
-                }
-            }
-
-            // Check in first three weeks of march -> winter time
-            else
-            {
-                this->setSummertime(0);
-                summertimeActive = false;
-            }
-        }
+    // the local time also jumps at a transition of the time zone (which may not be on a minute boundary)
+    int64_t utc = (int64_t)(millisSince1900 / this->millisecondpersecond) - SEVENZYYEARS;
+    int64_t secondsToTransition = this->_timeZone.getNextTransition(utc) - utc;
+    if (secondsToTransition < (int64_t)secondsToEvent)
+    {
+        secondsToEvent = (unsigned long)secondsToTransition;
+    }
+    this->_nextTimeEvent = millis() + secondsToEvent * this->millisecondpersecond - msIntoSecond;
+    this->_lastEventMinute = minute;
 
-        // current month is october
-        else if (dateMonth == 10)
+    // callbacks may reschedule (e.g. time zone change), so deadline is set before
+    if (minute != lastMinute)
+    {
+        if (this->_timeEventCallbacks[event_minute] != nullptr)
         {
-
-            // Check in last week of october
-            if ((this->daysInMonth[10] - dateDay) < 7)
-            {
-
-                //Example year 2020: October 31 days; Check on October 26, 2020 (Monday = weekday = 1); 5 days remaining; last Sunday October 25, 2020
-                //Calculation: 31 - 26 = 5; 5 + 1 = 6;
-                //Result: Last day in October is a Saturday. Changeover to winter time already done => set winter time
-
-                //Example year 2021: October 31 days; Check on 26. October 2021 (Tuesday = weekday = 2); 5 days remaining; Last Sunday 31. October 2021
-                //Calculation: 31 - 26 = 5; 5 + 2 = 7;
-                //Result: Last day in October is a Sunday. There follows another Sunday in October => set summer time
-                
-                // If today is Sunday (dayOfWeek == 7) then this is already the last sunday in october -> winter time
-                if(dayOfWeek == 7){
-                    this->setSummertime(0);
-                    summertimeActive = false;
-                }
-
-                // There follows within the last week in October one more Sunday => summer time
-                else if (((this->daysInMonth[10] - dateDay) + dayOfWeek) >= 7)
-                {
-                    this->setSummertime(1);
-                    summertimeActive = true;
-                }
-
-                // last sunday in october already over -> winter time
-                else
-                {
-                    this->setSummertime(0);
-                    summertimeActive = false;
-                }
-            }
-
-            // Check in first three weeks of october -> summer time
-            else
-            {
-                this->setSummertime(1);
-                summertimeActive = true;
-            }
+            this->_timeEventCallbacks[event_minute](epochTime);
         }
-
-        // Check in summer time
-        else if (dateMonth > 3 && dateMonth < 10)
+        if (minute / this->minuteperhour != lastMinute / this->minuteperhour && this->_timeEventCallbacks[event_hour] != nullptr)
         {
-            this->setSummertime(1);
-            summertimeActive = true;
+            this->_timeEventCallbacks[event_hour](epochTime);
         }
-
-        // Check in winter time
-        else if (dateMonth < 3 || dateMonth > 10)
+        if (epochTime / this->secondperday != lastMinute * this->secondperminute / this->secondperday && this->_timeEventCallbacks[event_day] != nullptr)
         {
-            this->setSummertime(0);
-            summertimeActive = false;
+            this->_timeEventCallbacks[event_day](epochTime);
         }
     }
+}
 
-    return summertimeActive;
-}
\ No newline at end of file
+/**
+ * @brief Let the next handleTimeEvents() check the boundaries immediately,
+ * has to be called when the time base changes (NTP update, time offset)
+ * 
+ */
+void NTPClientPlus::rescheduleTimeEvents()
+{
+    this->_nextTimeEvent = millis();
+}
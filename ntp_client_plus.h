@@ -3,10 +3,45 @@
 
 #include <Arduino.h>
 #include <WiFiUdp.h>
+#include "timezone.h"
 
 #define SEVENZYYEARS 2208988800UL
 #define NTP_PACKET_SIZE 48
 #define NTP_DEFAULT_LOCAL_PORT 1337
+// max time (ms) to wait for the answer of the NTP server
+#define NTP_TIMEOUT 1000
+// number of requests of an update, the answer with the shortest round trip is used
+#define NTP_BURST_SAMPLES 4
+// time (ms) between the requests of an update
+#define NTP_BURST_INTERVAL 2000
+// limits of the poll interval (ms), the interval is doubled while the offsets are small
+#define NTP_MIN_POLL_INTERVAL 64000UL
+#define NTP_MAX_POLL_INTERVAL 1024000UL
+// offset (ms) below which the poll interval is doubled, above twice the value it is halved
+#define NTP_POLL_ADJUST_OFFSET 25
+// max difference (s) between NTP time and local clock, unless the previous answer had the same difference
+#define NTP_MAX_DIFFERENCE 100000
+// only offsets (ms) below this value are used to correct the frequency of millis()
+#define NTP_MAX_FREQ_OFFSET 1000
+// min time (ms) between two updates used to correct the frequency of millis()
+#define NTP_MIN_FREQ_INTERVAL 60000
+// max frequency correction of millis() (ppb)
+#define NTP_MAX_DRIFT 500000
+// gain of the frequency correction: measured frequency error / 2^n is added
+#define NTP_DRIFT_GAIN_SHIFT 1
+
+// results of updateNTP() and pollNTP()
+#define NTP_UPDATE_SUCCESS 0
+#define NTP_UPDATE_TIMEOUT -1
+#define NTP_UPDATE_DIFFERENCE 1
+#define NTP_UPDATE_INVALID 2
+#define NTP_UPDATE_PENDING 3
+
+// time boundaries for which callbacks can be registered
+enum TimeEvent {event_minute, event_hour, event_day, NUM_TIME_EVENTS};
+
+// callback for a time event, gets the local epoch time (in s) at the boundary
+typedef void (*TimeEventCallback)(unsigned long epochTime);
 
 /**
  * @brief Own NTP Client library for Arduino with code from:
@@ -20,9 +55,13 @@ class NTPClientPlus{
         NTPClientPlus(UDP &udp, const char* poolServerName, int utcx, bool _swChange);
         void setupNTPClient();
         int updateNTP();
+        void requestNTP(uint8_t samples = NTP_BURST_SAMPLES);
+        int pollNTP();
+        bool isUpdatePending() const;
         void end();
         void setTimeOffset(int timeOffset);
         void setPoolServerName(const char* poolServerName);
+        uint64_t getMillisSince1900() const;
         unsigned long getSecsSince1900() const;
         unsigned long getEpochTime() const;
         int getHours24() const;
@@ -37,35 +76,66 @@ class NTPClientPlus{
         bool isLeapYear(unsigned int year);
         int getMonth(int dayOfYear);
         long getTimeOffset();
-        bool updateSWChange();
+        bool setTimeZone(const char* tz);
+        void setTimeZone(const TimeZone &timeZone);
+        const char* getTimeZone() const;
+        bool isDST();
+        void setTimeEventCallback(TimeEvent event, TimeEventCallback callback);
+        void handleTimeEvents();
+        void rescheduleTimeEvents();
+        long getLastOffset() const;
+        long getLastDelay() const;
+        long getDrift() const;
+        unsigned long getPollInterval() const;
 
 
     private:
+        // access of the host tests (test/) to the clock state
+        friend class NTPClientPlusTest;
+
         UDP*          _udp;
         bool          _udpSetup       = false;
 
         const char*   _poolServerName = "pool.ntp.org"; // Default time server
-        IPAddress     _poolServerIP;
+        IPAddress     _poolServerIP;                    // address of the time server, resolved at the start of each update
         unsigned int  _port           = NTP_DEFAULT_LOCAL_PORT;
-        long          _timeOffset     = 0;
-        int           _utcx           = 0;
-        bool          _swChange        = 1;
+        mutable TimeZone _timeZone;             // caches the next transition, so it changes in const getters
 
         unsigned long _updateInterval = 60000;  // In ms
 
-        unsigned long _currentEpoc    = 0;      // In s
-        unsigned long _lastUpdate     = 0;      // In ms
-        unsigned long _secsSince1900  = 0;      // seconds since 1. Januar 1900, 00:00:00
-        unsigned long _lastSecsSince1900 = 0;
+        unsigned long _lastUpdate     = 0;      // millis() of last clock correction
+        uint64_t      _baseMillis     = 0;      // UTC in ms since 1. Januar 1900, 00:00:00 at _lastUpdate
+        long          _drift          = 0;      // frequency correction of millis() in ppb
+        bool          _synchronized   = false;
+        int64_t       _lastOffset     = 0;      // offset (ms) of the last answer (NTP time - local clock)
+        long          _lastDelay      = 0;      // round trip delay (ms) of the last answer
+        unsigned long _pollInterval   = NTP_MIN_POLL_INTERVAL;
         unsigned int _dateYear         = 0;
         unsigned int _dateMonth        = 0;
         unsigned int _dateDay          = 0;
         unsigned int _dayOfWeek        = 0;
 
+        TimeEventCallback _timeEventCallbacks[NUM_TIME_EVENTS] = {nullptr};
+        unsigned long _nextTimeEvent    = 0;    // millis() deadline of next minute boundary
+        unsigned long _lastEventMinute  = 0;    // minutes since 1970 at last handleTimeEvents()
+
 
         byte          _packetBuffer[NTP_PACKET_SIZE];
+        bool          _updatePending  = false;
+        bool          _answerPending  = false;
+        uint8_t       _burstSize      = 0;      // number of requests of the current update
+        uint8_t       _samplesRequested = 0;
+        uint8_t       _samplesReceived = 0;
+        int64_t       _bestOffset     = 0;      // offset (ms) of the answer with the shortest round trip
+        long          _bestDelay      = 0;
+        unsigned long _requestTime    = 0;      // millis() when the request was sent
+        uint64_t      _requestMillis  = 0;      // local clock when the request was sent (T1)
+        byte          _requestTimestamp[8];     // transmit timestamp of the request
         void          sendNTPPacket();
-        void          setSummertime(bool summertime);
+        int           handleNTPPacket(uint64_t receiveTime);
+        int           applyNTPSample();
+        static uint64_t ntpTimestampToMillis(const byte *timestamp);
+        static void   civilFromDays(long days, unsigned int &year, unsigned int &month, unsigned int &day);
         
 
         static const unsigned long secondperday = 86400;
@@ -73,9 +143,7 @@ class NTPClientPlus{
         static const unsigned long secondperminute = 60;
         static const unsigned long minuteperhour = 60;
         static const unsigned long millisecondpersecond = 1000;
-
-        // number of days in months
-        unsigned int daysInMonth[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        static const long daysFrom1900To1970 = 25567;
 
 
 
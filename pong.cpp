@@ -93,7 +93,7 @@ void Pong::ctrlNone(uint8_t playerid){
  */
 void Pong::initGame(uint8_t numBots)
 {
-    (*_logger).logString("Pong: init with " + String(numBots) + " Bots");
+    LOG_INFO(*_logger, "Pong: init with %d Bots", (int)numBots);
     resetLEDs();
     _lastButtonClick = millis();
 
@@ -178,7 +178,7 @@ void Pong::updateBall()
  */
 void Pong::endGame()
 {
-    (*_logger).logString("Pong: Game ended");
+    LOG_INFO(*_logger, "Pong: Game ended");
     _gameState = GAME_STATE_END;
     toggleLed(_ball.x, _ball.y, LED_TYPE_BALL_RED);
 }
@@ -0,0 +1,143 @@
+#include "profiler.h"
+
+static const char *stageNames[NUM_PROFILER_STAGES] = {"webserver", "mode", "blend", "show", "ntp"};
+
+/**
+ * @brief Add one duration to the histogram
+ *
+ * @param ticks duration in ticks
+ */
+void StageHistogram::add(uint32_t ticks){
+    // bucket = position of highest set bit
+    uint8_t bucket = 0;
+    while(bucket < PROFILER_BUCKETS - 1 && (ticks >> (bucket + 1)) != 0){
+        bucket++;
+    }
+    if(_buckets[bucket] == 0xffff){
+        for(uint8_t i = 0; i < PROFILER_BUCKETS; i++){
+            _buckets[i] >>= 1;
+        }
+    }
+    _buckets[bucket]++;
+    if(ticks > _max){
+        _max = ticks;
+    }
+    _samples++;
+}
+
+/**
+ * @brief Get the (upper bound of the) duration below which the given percentage of samples lie
+ *
+ * @param percent percentage (0-100)
+ * @return uint32_t duration in ticks, limited to the max duration
+ */
+uint32_t StageHistogram::getPercentile(uint8_t percent) const {
+    uint32_t total = 0;
+    for(uint8_t i = 0; i < PROFILER_BUCKETS; i++){
+        total += _buckets[i];
+    }
+    if(total == 0){
+        return 0;
+    }
+    uint32_t threshold = (total * percent + 99) / 100;
+    uint32_t sum = 0;
+    for(uint8_t i = 0; i < PROFILER_BUCKETS; i++){
+        sum += _buckets[i];
+        if(sum >= threshold){
+            uint32_t upperBound = (i >= 31) ? 0xffffffff : ((2UL << i) - 1);
+            return (upperBound < _max) ? upperBound : _max;
+        }
+    }
+    return _max;
+}
+
+/**
+ * @brief Clear all samples
+ *
+ */
+void StageHistogram::reset(){
+    for(uint8_t i = 0; i < PROFILER_BUCKETS; i++){
+        _buckets[i] = 0;
+    }
+    _max = 0;
+    _samples = 0;
+}
+
+/**
+ * @brief Remember start of a stage
+ *
+ * @param stage measured stage
+ */
+void Profiler::start(ProfilerStage stage){
+    _startTicks[stage] = profilerTicks();
+}
+
+/**
+ * @brief Record the duration since start() of a stage
+ *
+ * @param stage measured stage
+ */
+void Profiler::stop(ProfilerStage stage){
+    record(stage, profilerTicks() - _startTicks[stage]);
+}
+
+/**
+ * @brief Record a duration of a stage which was measured outside
+ *
+ * @param stage measured stage
+ * @param ticks duration in ticks
+ */
+void Profiler::record(ProfilerStage stage, uint32_t ticks){
+    _histograms[stage].add(ticks);
+}
+
+/**
+ * @brief Get percentile of the durations of a stage
+ *
+ * @param stage measured stage
+ * @param percent percentage (0-100), e.g. 50 -> median
+ * @return uint32_t duration in microseconds
+ */
+uint32_t Profiler::getPercentile(ProfilerStage stage, uint8_t percent) const {
+    return _histograms[stage].getPercentile(percent) / profilerTicksPerMicrosecond();
+}
+
+/**
+ * @brief Get longest duration of a stage
+ *
+ * @param stage measured stage
+ * @return uint32_t duration in microseconds
+ */
+uint32_t Profiler::getMax(ProfilerStage stage) const {
+    return _histograms[stage].getMax() / profilerTicksPerMicrosecond();
+}
+
+/**
+ * @brief Get number of measured durations of a stage
+ *
+ * @param stage measured stage
+ * @return uint32_t number of samples
+ */
+uint32_t Profiler::getSamples(ProfilerStage stage) const {
+    return _histograms[stage].getSamples();
+}
+
+/**
+ * @brief Get name of a stage for reports
+ *
+ * @param stage measured stage
+ * @return const char* name of the stage
+ */
+const char *Profiler::getStageName(ProfilerStage stage){
+    return stageNames[stage];
+}
+
+/**
+ * @brief Clear all histograms
+ *
+ */
+void Profiler::reset(){
+    for(uint8_t i = 0; i < NUM_PROFILER_STAGES; i++){
+        _histograms[i].reset();
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file profiler.h
+ * @brief Lightweight timing of the stages of the main loop with log2 histograms
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * On a host system the ticks are taken from std::chrono instead of the cpu cycle counter.
+ *
+ */
+
+#ifndef profiler_h
+#define profiler_h
+
+#include <stdint.h>
+
+#ifdef ESP8266
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// number of buckets of one histogram, bucket i counts durations in [2^i, 2^(i+1)) ticks
+#define PROFILER_BUCKETS 32
+
+// stages of the main loop which are measured
+enum ProfilerStage {stage_webserver, stage_mode, stage_blend, stage_show, stage_ntp, NUM_PROFILER_STAGES};
+
+/**
+ * @brief Get current value of the tick counter (cpu cycles on ESP8266, nanoseconds on host)
+ *
+ * @return uint32_t ticks, wraps around
+ */
+static inline uint32_t profilerTicks(){
+#ifdef ESP8266
+    return ESP.getCycleCount();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Get number of ticks per microsecond
+ *
+ * @return uint32_t ticks per microsecond
+ */
+static inline uint32_t profilerTicksPerMicrosecond(){
+#ifdef ESP8266
+    return ESP.getCpuFreqMHz();
+#else
+    return 1000;
+#endif
+}
+
+/**
+ * @brief Histogram of durations with logarithmic buckets.
+ * If one bucket would overflow, all buckets are halved, so recent samples weigh more than old ones.
+ *
+ */
+class StageHistogram{
+    public:
+        void add(uint32_t ticks);
+        uint32_t getPercentile(uint8_t percent) const;
+        uint32_t getMax() const { return _max; }
+        uint32_t getSamples() const { return _samples; }
+        void reset();
+
+    private:
+        uint16_t _buckets[PROFILER_BUCKETS] = {0};
+        uint32_t _max = 0;
+        uint32_t _samples = 0;
+};
+
+/**
+ * @brief Measures the duration of each ProfilerStage, results are reported in microseconds
+ *
+ */
+class Profiler{
+    public:
+        void start(ProfilerStage stage);
+        void stop(ProfilerStage stage);
+        void record(ProfilerStage stage, uint32_t ticks);
+        uint32_t getPercentile(ProfilerStage stage, uint8_t percent) const;
+        uint32_t getMax(ProfilerStage stage) const;
+        uint32_t getSamples(ProfilerStage stage) const;
+        static const char *getStageName(ProfilerStage stage);
+        void reset();
+
+    private:
+        StageHistogram _histograms[NUM_PROFILER_STAGES];
+        uint32_t _startTicks[NUM_PROFILER_STAGES] = {0};
+};
+
+#endif
@@ -0,0 +1,514 @@
+/**
+ * @file log_receiver.cpp
+ * @brief Host side receiver for the multicast log messages of one or more wordclocks
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * Replacement for multicastUDP_receiver.py for high message rates. Decodes the binary records
+ * (UDPLOGGER_BINARY = 1, see ../logformat.h) and the text lines of UDPLogger, detects lost messages
+ * by the sequence numbers and keeps the last lines of each device in a ring buffer. If a trigger
+ * message occurs ("NTP-Update not successful", "Start program"), the ring buffer and the following
+ * lines of this device are appended to the log file. The log file is opened once (append only).
+ *
+ * Build (Linux / macOS):
+ *   g++ -O2 -std=c++17 -o log_receiver log_receiver.cpp
+ * Usage:
+ *   ./log_receiver -i <ip address of network interface> [-g 230.120.10.2] [-p 8123] [-o log.txt] [-n 20] [-q]
+ *
+ */
+
+#include "../logformat.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// max size of one datagram
+#define RECEIVER_MAX_DATAGRAM 2048
+// number of datagrams received with one system call (Linux)
+#define RECEIVER_BATCH 64
+// number of lines which are written to the log file after a trigger
+#define RECEIVER_SAVE_LINES 20
+
+static const char *triggers[] = {"NTP-Update not successful", "Start program"};
+static const char levelNames[] = {'D', 'I', 'W', 'E'};
+
+static volatile sig_atomic_t running = 1;
+
+struct Options {
+    const char *interfaceIp = nullptr;
+    const char *group = "230.120.10.2";
+    int port = 8123;
+    const char *logFile = "log.txt";
+    size_t historyLines = RECEIVER_SAVE_LINES;
+    bool quiet = false;
+};
+
+/**
+ * @brief Ring buffer of the last lines of one device
+ *
+ */
+class LineHistory {
+    public:
+        explicit LineHistory(size_t capacity) : _lines(capacity) {}
+
+        void add(const std::string &line){
+            if(_lines.empty()){
+                return;
+            }
+            _lines[_head] = line;
+            _head = (_head + 1) % _lines.size();
+            if(_count < _lines.size()){
+                _count++;
+            }
+        }
+
+        /**
+         * @brief Write all lines (oldest first) to the file and clear the history
+         *
+         * @param file destination
+         */
+        void dump(FILE *file){
+            if(_lines.empty()){
+                return;
+            }
+            size_t start = (_head + _lines.size() - _count) % _lines.size();
+            for(size_t i = 0; i < _count; i++){
+                const std::string &line = _lines[(start + i) % _lines.size()];
+                fwrite(line.data(), 1, line.size(), file);
+                fputc('\n', file);
+            }
+            _count = 0;
+        }
+
+    private:
+        std::vector<std::string> _lines;
+        size_t _head = 0;
+        size_t _count = 0;
+};
+
+/**
+ * @brief State of one wordclock (identified by its ip address)
+ *
+ */
+struct Device {
+    std::string address;
+    std::string name;
+    std::unordered_map<uint16_t, std::string> formats;
+    bool sequenceValid = false;
+    uint16_t expectedSequence = 0;
+    LineHistory history;
+    int saveCounter = 0;
+
+    Device(const std::string &address, size_t historyLines) : address(address), history(historyLines) {}
+};
+
+/**
+ * @brief Reader for the little endian numbers of a binary record
+ *
+ */
+class RecordReader {
+    public:
+        RecordReader(const uint8_t *data, size_t length) : _data(data), _length(length) {}
+
+        bool read(uint64_t &value, uint8_t size){
+            if(_position + size > _length){
+                return false;
+            }
+            value = 0;
+            for(uint8_t i = 0; i < size; i++){
+                value |= (uint64_t)_data[_position++] << (8 * i);
+            }
+            return true;
+        }
+
+        bool readString(std::string &value){
+            uint64_t length;
+            if(!read(length, 1) || _position + length > _length){
+                return false;
+            }
+            value.assign((const char *)_data + _position, length);
+            _position += length;
+            return true;
+        }
+
+    private:
+        const uint8_t *_data;
+        size_t _length;
+        size_t _position = 0;
+};
+
+/**
+ * @brief Format a binary message like printf on the device would have done
+ *
+ * @param format format string of the message
+ * @param args binary arguments (see logformat.h)
+ * @param length length of the arguments
+ * @return std::string formatted message, "<?>" marks missing arguments
+ */
+static std::string formatMessage(const std::string &format, const uint8_t *args, size_t length){
+    std::string result;
+    RecordReader reader(args, length);
+    char buffer[512];
+    for(size_t i = 0; i < format.size(); i++){
+        if(format[i] != '%'){
+            result += format[i];
+            continue;
+        }
+        LogFormatSpec spec = parseLogFormatSpec([&format, i](uint8_t index){
+            return (i + index < format.size()) ? format[i + index] : '\0';
+        });
+        std::string original = format.substr(i, spec.length);
+        i += spec.length - 1;
+        if(spec.type == arg_none){
+            result += (spec.conversion == '%') ? "%" : original;
+            continue;
+        }
+
+        // build specification for the host: values of '*' inserted, length modifiers of the device removed
+        std::string hostSpec;
+        bool complete = true;
+        for(size_t c = 0; c + 1 < original.size(); c++){
+            char ch = original[c];
+            if(ch == '*'){
+                uint64_t star = 0;
+                complete = complete && reader.read(star, 4);
+                hostSpec += std::to_string((int32_t)star);
+            }
+            else if(ch != 'h' && ch != 'l' && ch != 'z' && ch != 't' && ch != 'j'){
+                hostSpec += ch;
+            }
+        }
+
+        uint64_t value = 0;
+        std::string str;
+        switch(spec.type){
+            case arg_int32:
+                complete = complete && reader.read(value, 4);
+                break;
+            case arg_int64:
+                complete = complete && reader.read(value, 8);
+                break;
+            case arg_float:
+                complete = complete && reader.read(value, 4);
+                break;
+            case arg_string:
+                complete = complete && reader.readString(str);
+                break;
+            default:
+                break;
+        }
+        if(!complete){
+            result += "<?>";
+            break;
+        }
+
+        switch(spec.type){
+            case arg_int32:
+                if(spec.conversion == 'p'){
+                    snprintf(buffer, sizeof(buffer), "0x%08x", (uint32_t)value);
+                }
+                else if(spec.conversion == 'd' || spec.conversion == 'i'){
+                    snprintf(buffer, sizeof(buffer), (hostSpec + spec.conversion).c_str(), (int32_t)value);
+                }
+                else{
+                    snprintf(buffer, sizeof(buffer), (hostSpec + spec.conversion).c_str(), (uint32_t)value);
+                }
+                break;
+            case arg_int64:
+                if(spec.conversion == 'd' || spec.conversion == 'i'){
+                    snprintf(buffer, sizeof(buffer), (hostSpec + "ll" + spec.conversion).c_str(), (long long)value);
+                }
+                else{
+                    snprintf(buffer, sizeof(buffer), (hostSpec + "ll" + spec.conversion).c_str(), (unsigned long long)value);
+                }
+                break;
+            case arg_float:
+                {
+                    float f;
+                    uint32_t bits = value;
+                    memcpy(&f, &bits, 4);
+                    snprintf(buffer, sizeof(buffer), (hostSpec + spec.conversion).c_str(), (double)f);
+                }
+                break;
+            default:
+                snprintf(buffer, sizeof(buffer), (hostSpec + spec.conversion).c_str(), str.c_str());
+                break;
+        }
+        result += buffer;
+    }
+    return result;
+}
+
+class LogReceiver {
+    public:
+        LogReceiver(const Options &options, FILE *logFile) : _options(options), _logFile(logFile) {}
+
+        /**
+         * @brief Decode one datagram (binary or text) of a device
+         *
+         * @param address ip address of the sender
+         * @param data datagram
+         * @param length length of datagram
+         */
+        void handleDatagram(const std::string &address, const uint8_t *data, size_t length){
+            Device &device = getDevice(address);
+            if(length >= 2 && data[0] == LOGFORMAT_MAGIC_0 && data[1] == LOGFORMAT_MAGIC_1){
+                handleBinary(device, data, length);
+            }
+            else{
+                handleText(device, (const char *)data, length);
+            }
+        }
+
+        /**
+         * @brief Write buffered lines to the log file
+         *
+         */
+        void flush(){
+            fflush(_logFile);
+            if(!_options.quiet){
+                fflush(stdout);
+            }
+        }
+
+    private:
+        const Options &_options;
+        FILE *_logFile;
+        std::unordered_map<std::string, Device> _devices;
+
+        Device &getDevice(const std::string &address){
+            auto it = _devices.find(address);
+            if(it == _devices.end()){
+                it = _devices.emplace(address, Device(address, _options.historyLines)).first;
+            }
+            return it->second;
+        }
+
+        void handleBinary(Device &device, const uint8_t *data, size_t length){
+            if(length < 4 || data[2] != LOGFORMAT_VERSION){
+                handleLine(device, "[receiver] unsupported datagram");
+                return;
+            }
+            size_t nameLength = data[3];
+            size_t position = 4 + nameLength + 4;
+            if(position > length){
+                return;
+            }
+            device.name.assign((const char *)data + 4, nameLength);
+            while(position + LOGFORMAT_RECORD_HEADER <= length){
+                uint16_t sequence = data[position] | (data[position + 1] << 8);
+                uint8_t level = data[position + 2];
+                uint8_t recordLength = data[position + 3];
+                const uint8_t *payload = data + position + LOGFORMAT_RECORD_HEADER;
+                position += LOGFORMAT_RECORD_HEADER + recordLength;
+                if(position > length || recordLength == 0){
+                    break;
+                }
+                checkSequence(device, sequence);
+                if(payload[0] == record_format && recordLength >= LOGFORMAT_FORMAT_HEADER){
+                    uint16_t formatId = payload[1] | (payload[2] << 8);
+                    device.formats[formatId].assign((const char *)payload + LOGFORMAT_FORMAT_HEADER, recordLength - LOGFORMAT_FORMAT_HEADER);
+                }
+                else if(payload[0] == record_message && recordLength >= LOGFORMAT_MESSAGE_HEADER){
+                    uint32_t timestamp = payload[1] | (payload[2] << 8) | (payload[3] << 16) | ((uint32_t)payload[4] << 24);
+                    uint16_t formatId = payload[5] | (payload[6] << 8);
+                    char prefix[48];
+                    snprintf(prefix, sizeof(prefix), "[%c %10u] ", (level < sizeof(levelNames)) ? levelNames[level] : '?', timestamp);
+                    auto format = device.formats.find(formatId);
+                    if(format == device.formats.end()){
+                        handleLine(device, std::string(prefix) + "<unknown format " + std::to_string(formatId) + ">");
+                    }
+                    else{
+                        handleLine(device, std::string(prefix) + formatMessage(format->second, payload + LOGFORMAT_MESSAGE_HEADER, recordLength - LOGFORMAT_MESSAGE_HEADER));
+                    }
+                }
+            }
+        }
+
+        void handleText(Device &device, const char *data, size_t length){
+            // one line per message: "<seq> <name>: <text>"
+            const char *end = data + length;
+            while(data < end){
+                const char *lineEnd = (const char *)memchr(data, '\n', end - data);
+                if(lineEnd == nullptr){
+                    lineEnd = end;
+                }
+                std::string line(data, lineEnd - data);
+                data = lineEnd + 1;
+                size_t space = line.find(' ');
+                if(space != std::string::npos && space > 0 && line.find_first_not_of("0123456789") == space){
+                    checkSequence(device, (uint16_t)atoi(line.c_str()));
+                    line.erase(0, space + 1);
+                }
+                size_t colon = line.find(": ");
+                if(colon != std::string::npos){
+                    device.name = line.substr(0, colon);
+                    line.erase(0, colon + 2);
+                }
+                if(!line.empty()){
+                    handleLine(device, line);
+                }
+            }
+        }
+
+        void checkSequence(Device &device, uint16_t sequence){
+            if(device.sequenceValid && sequence != device.expectedSequence && sequence != 0){
+                uint16_t lost = sequence - device.expectedSequence;
+                if(lost < 0x8000){
+                    handleLine(device, "[receiver] " + std::to_string(lost) + " message(s) lost");
+                }
+                else{
+                    handleLine(device, "[receiver] message out of order");
+                }
+            }
+            device.sequenceValid = true;
+            device.expectedSequence = sequence + 1;
+        }
+
+        void handleLine(Device &device, const std::string &message){
+            char timeString[32];
+            time_t now = time(nullptr);
+            strftime(timeString, sizeof(timeString), "%b-%d-%Y_%H%M%S", localtime(&now));
+            std::string line = std::string(timeString) + ": " + device.address + " " + device.name + ": " + message;
+            if(!_options.quiet){
+                fwrite(line.data(), 1, line.size(), stdout);
+                fputc('\n', stdout);
+            }
+
+            device.history.add(line);
+            for(const char *trigger : triggers){
+                if(message.find(trigger) != std::string::npos){
+                    device.history.dump(_logFile);
+                    device.saveCounter = RECEIVER_SAVE_LINES;
+                    return;
+                }
+            }
+            if(device.saveCounter > 0){
+                fwrite(line.data(), 1, line.size(), _logFile);
+                fputc('\n', _logFile);
+                if(--device.saveCounter == 0){
+                    fputc('\n', _logFile);
+                }
+            }
+        }
+};
+
+static void stopReceiver(int){
+    running = 0;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options){
+    int opt;
+    while((opt = getopt(argc, argv, "i:g:p:o:n:q")) != -1){
+        switch(opt){
+            case 'i': options.interfaceIp = optarg; break;
+            case 'g': options.group = optarg; break;
+            case 'p': options.port = atoi(optarg); break;
+            case 'o': options.logFile = optarg; break;
+            case 'n': options.historyLines = strtoul(optarg, nullptr, 10); break;
+            case 'q': options.quiet = true; break;
+            default: return false;
+        }
+    }
+    return options.interfaceIp != nullptr;
+}
+
+int main(int argc, char **argv){
+    Options options;
+    if(!parseOptions(argc, argv, options)){
+        fprintf(stderr, "Usage: %s -i <interface ip> [-g group] [-p port] [-o logfile] [-n history lines] [-q]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *logFile = fopen(options.logFile, "a");
+    if(logFile == nullptr){
+        perror("open log file");
+        return 1;
+    }
+    setvbuf(logFile, nullptr, _IOFBF, 1 << 16);
+    if(options.quiet == false){
+        setvbuf(stdout, nullptr, _IOFBF, 1 << 16);
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int receiveBuffer = 4 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    sockaddr_in serverAddress = {};
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(options.port);
+    serverAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(sock, (sockaddr *)&serverAddress, sizeof(serverAddress)) < 0){
+        perror("bind");
+        return 1;
+    }
+    ip_mreq membership = {};
+    inet_pton(AF_INET, options.group, &membership.imr_multiaddr);
+    inet_pton(AF_INET, options.interfaceIp, &membership.imr_interface);
+    if(setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0){
+        perror("join multicast group");
+        return 1;
+    }
+    // wake up regularly to flush the files
+    timeval timeout = {0, 500000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    signal(SIGINT, stopReceiver);
+    signal(SIGTERM, stopReceiver);
+    printf("Ready\n");
+    fflush(stdout);
+
+    LogReceiver receiver(options, logFile);
+    static uint8_t buffers[RECEIVER_BATCH][RECEIVER_MAX_DATAGRAM];
+    char address[INET_ADDRSTRLEN];
+    time_t lastFlush = time(nullptr);
+    while(running){
+#ifdef __linux__
+        mmsghdr messages[RECEIVER_BATCH] = {};
+        iovec vectors[RECEIVER_BATCH];
+        sockaddr_in senders[RECEIVER_BATCH];
+        for(int i = 0; i < RECEIVER_BATCH; i++){
+            vectors[i] = {buffers[i], RECEIVER_MAX_DATAGRAM};
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+        }
+        // block for the first datagram, take all others which are already there
+        int count = recvmmsg(sock, messages, RECEIVER_BATCH, MSG_WAITFORONE, nullptr);
+        for(int i = 0; i < count; i++){
+            inet_ntop(AF_INET, &senders[i].sin_addr, address, sizeof(address));
+            receiver.handleDatagram(address, buffers[i], messages[i].msg_len);
+        }
+#else
+        sockaddr_in sender;
+        socklen_t senderLength = sizeof(sender);
+        ssize_t count = recvfrom(sock, buffers[0], RECEIVER_MAX_DATAGRAM, 0, (sockaddr *)&sender, &senderLength);
+        if(count > 0){
+            inet_ntop(AF_INET, &sender.sin_addr, address, sizeof(address));
+            receiver.handleDatagram(address, buffers[0], count);
+        }
+#endif
+        if(count <= 0 || time(nullptr) != lastFlush){
+            receiver.flush();
+            lastFlush = time(nullptr);
+        }
+    }
+    receiver.flush();
+    fclose(logFile);
+    close(sock);
+    return 0;
+}
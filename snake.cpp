@@ -57,7 +57,7 @@ void Snake::loopCycle()
  */
 void Snake::ctrlUp(){
     if (millis() > _lastButtonClick + DEBOUNCE_TIME && _gameState == GAME_STATE_RUNNING) {
-        (*_logger).logString("Snake: UP");
+        LOG_DEBUG(*_logger, "Snake: UP");
         _userDirection = DIRECTION_DOWN; // need to swap direction as field is rotated 180deg
         _lastButtonClick = millis();
     }
@@ -69,7 +69,7 @@ void Snake::ctrlUp(){
  */
 void Snake::ctrlDown(){
     if (millis() > _lastButtonClick + DEBOUNCE_TIME && _gameState == GAME_STATE_RUNNING) {
-        (*_logger).logString("Snake: DOWN");
+        LOG_DEBUG(*_logger, "Snake: DOWN");
         _userDirection = DIRECTION_UP; // need to swap direction as field is rotated 180deg
         _lastButtonClick = millis();
     }
@@ -81,7 +81,7 @@ void Snake::ctrlDown(){
  */
 void Snake::ctrlRight(){
     if (millis() > _lastButtonClick + DEBOUNCE_TIME && _gameState == GAME_STATE_RUNNING) {
-        (*_logger).logString("Snake: RIGHT");
+        LOG_DEBUG(*_logger, "Snake: RIGHT");
         _userDirection = DIRECTION_LEFT; // need to swap direction as field is rotated 180deg
         _lastButtonClick = millis();
     }
@@ -93,7 +93,7 @@ void Snake::ctrlRight(){
  */
 void Snake::ctrlLeft(){
     if (millis() > _lastButtonClick + DEBOUNCE_TIME && _gameState == GAME_STATE_RUNNING) {
-        (*_logger).logString("Snake: LEFT");
+        LOG_DEBUG(*_logger, "Snake: LEFT");
         _userDirection = DIRECTION_RIGHT; // need to swap direction as field is rotated 180deg
         _lastButtonClick = millis();
     }
@@ -114,7 +114,7 @@ void Snake::resetLEDs()
  */
 void Snake::initGame()
 {
-    (*_logger).logString("Snake: init");
+    LOG_INFO(*_logger, "Snake: init");
     resetLEDs();
     _head.x = 0;
     _head.y = 0;
@@ -139,7 +139,7 @@ void Snake::initGame()
 void Snake::updateGame()
 {
   if ((millis() - _lastDrawUpdate) > GAME_DELAY) {
-    (*_logger).logString("Snake: update game");
+    LOG_DEBUG(*_logger, "Snake: update game");
     toggleLed(_tail[_wormLength-1].x, _tail[_wormLength-1].y, LED_TYPE_OFF);
     switch(_userDirection) {
       case DIRECTION_RIGHT:
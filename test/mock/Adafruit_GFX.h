@@ -0,0 +1,12 @@
+/**
+ * @file Adafruit_GFX.h
+ * @brief Mock of the GFX library for the host tests
+ *
+ */
+
+#ifndef mock_adafruit_gfx_h
+#define mock_adafruit_gfx_h
+
+#include <Arduino.h>
+
+#endif
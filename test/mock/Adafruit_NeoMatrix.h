@@ -0,0 +1,26 @@
+/**
+ * @file Adafruit_NeoMatrix.h
+ * @brief Mock of the NeoMatrix for the host tests (drawing functions do nothing)
+ *
+ */
+
+#ifndef mock_adafruit_neomatrix_h
+#define mock_adafruit_neomatrix_h
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_NeoPixel.h>
+
+#define NEO_MATRIX_TOP 0x00
+#define NEO_MATRIX_LEFT 0x00
+#define NEO_MATRIX_ROWS 0x00
+#define NEO_MATRIX_ZIGZAG 0x08
+
+class Adafruit_NeoMatrix : public Adafruit_NeoPixel{
+    public:
+        Adafruit_NeoMatrix(int w, int h, int pin, int matrixType, int ledType) {}
+        void drawPixel(int16_t x, int16_t y, uint16_t color) {}
+        void fillScreen(uint16_t color) {}
+        void setTextWrap(bool wrap) {}
+};
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @file Adafruit_NeoPixel.h
+ * @brief Mock of the NeoPixel strip for the host tests, keeps the pixel buffer and counts show()
+ *
+ */
+
+#ifndef mock_adafruit_neopixel_h
+#define mock_adafruit_neopixel_h
+
+#include <Arduino.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+// 11 x 12 leds (grid + row of the minute indicators)
+#define MOCK_NEOPIXEL_COUNT 132
+
+class Adafruit_NeoPixel{
+    public:
+        void begin() {}
+        void show(){ shows++; }
+        bool canShow(){ return true; }
+        void clear(){ memset(pixels, 0, sizeof(pixels)); }
+        uint8_t *getPixels(){ return pixels; }
+        uint16_t numPixels() const { return MOCK_NEOPIXEL_COUNT; }
+        // like the library: stored + 1, so 0 means "not scaled"
+        void setBrightness(uint8_t b){ brightness = b + 1; }
+        uint8_t getBrightness() const { return brightness - 1; }
+        void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b){
+            if(n < MOCK_NEOPIXEL_COUNT){
+                pixels[n * 3] = g;
+                pixels[n * 3 + 1] = r;
+                pixels[n * 3 + 2] = b;
+            }
+        }
+
+        uint8_t pixels[MOCK_NEOPIXEL_COUNT * 3] = {0};
+        uint8_t brightness = 0;
+        uint32_t shows = 0;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal mock of the ESP8266 Arduino core for the host tests
+ *
+ * Flash is ordinary memory on the host, so PROGMEM and the pgm_read functions are plain accesses.
+ * millis() and micros() return fakeMillis and fakeMicros, the tests set them explicitly.
+ *
+ */
+
+#ifndef mock_arduino_h
+#define mock_arduino_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define SPECIAL 0xF8
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define vsnprintf_P vsnprintf
+#define snprintf_P snprintf
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+// like ESP8266 core 3.x: min() and max() from the standard library
+using std::min;
+using std::max;
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+// current time of millis() and micros(), advanced by the tests (delay() advances fakeMillis)
+extern unsigned long fakeMillis;
+extern unsigned long fakeMicros;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+int analogRead(int pin);
+void pinMode(int pin, int mode);
+
+inline uint16_t word(uint8_t high, uint8_t low){ return (high << 8) | low; }
+
+class String{
+    public:
+        String() {}
+        String(const char *text) : s(text) {}
+        String(int value) : s(std::to_string(value)) {}
+        String(unsigned int value) : s(std::to_string(value)) {}
+        String(long value) : s(std::to_string(value)) {}
+        String(unsigned long value) : s(std::to_string(value)) {}
+        String(double value) : s(std::to_string(value)) {}
+        String operator+(const String &other) const { String r; r.s = s + other.s; return r; }
+        String &operator+=(const String &other){ s += other.s; return *this; }
+        String &operator+=(char c){ s += c; return *this; }
+        bool operator==(const char *text) const { return s == text; }
+        bool operator!=(const char *text) const { return s != text; }
+        char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+        const char *c_str() const { return s.c_str(); }
+        unsigned int length() const { return s.size(); }
+        int indexOf(char c, unsigned int from = 0) const { size_t p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+        int indexOf(const String &text, unsigned int from = 0) const { size_t p = s.find(text.s, from); return p == std::string::npos ? -1 : (int)p; }
+        String substring(unsigned int from, unsigned int to) const { String r; r.s = s.substr(from, to - from); return r; }
+        long toInt() const { return atol(s.c_str()); }
+        bool equals(const char *text) const { return s == text; }
+        void toCharArray(char *buffer, unsigned int size) const { strncpy(buffer, s.c_str(), size); buffer[size - 1] = '\0'; }
+    private:
+        std::string s;
+};
+
+inline String operator+(const char *a, const String &b){ return String(a) + b; }
+
+class Print{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size){
+            for(size_t i = 0; i < size; i++){
+                write(buffer[i]);
+            }
+            return size;
+        }
+        size_t print(const char *text){ return write((const uint8_t *)text, strlen(text)); }
+};
+
+class HardwareSerial{
+    public:
+        void begin(unsigned long) {}
+        template<class T> void print(T) {}
+        template<class T> void println(T) {}
+        void println() {}
+        int printf(const char *, ...) { return 0; }
+        size_t write(const uint8_t *, size_t size) { return size; }
+};
+extern HardwareSerial Serial;
+
+class IPAddress{
+    public:
+        IPAddress() {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d){ _address[0] = a; _address[1] = b; _address[2] = c; _address[3] = d; }
+        uint8_t operator[](int i) const { return _address[i]; }
+        operator uint32_t() const { uint32_t v; memcpy(&v, _address, 4); return v; }
+        String toString() const { char text[16]; snprintf(text, sizeof(text), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]); return String(text); }
+    private:
+        uint8_t _address[4] = {0, 0, 0, 0};
+};
+
+class EspClass{
+    public:
+        uint32_t getCycleCount(){ return (uint32_t)micros() * 80; }
+        uint8_t getCpuFreqMHz(){ return 80; }
+        uint32_t getFreeHeap(){ return 30000; }
+};
+extern EspClass ESP;
+
+#endif
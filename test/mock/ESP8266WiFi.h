@@ -0,0 +1,30 @@
+/**
+ * @file ESP8266WiFi.h
+ * @brief Mock of the WiFi class for the host tests, only the DNS lookup
+ *
+ */
+
+#ifndef mock_esp8266wifi_h
+#define mock_esp8266wifi_h
+
+#include <Arduino.h>
+
+class ESP8266WiFiClass{
+    public:
+        int hostByName(const char *host, IPAddress &result){
+            lookups++;
+            if(!resolvable){
+                return 0;
+            }
+            result = hostAddress;
+            return 1;
+        }
+
+        // answer of the lookups, number of lookups
+        IPAddress hostAddress = IPAddress(192, 0, 2, 123);
+        bool resolvable = true;
+        unsigned long lookups = 0;
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file WiFiUdp.h
+ * @brief Mock of the UDP classes for the host tests
+ *
+ * UDP is the abstract interface of the Arduino core, tests derive their own transports from it.
+ * WiFiUDP records the sent datagrams and never receives anything.
+ *
+ */
+
+#ifndef mock_wifiudp_h
+#define mock_wifiudp_h
+
+#include <Arduino.h>
+#include <vector>
+
+class UDP : public Print{
+    public:
+        virtual uint8_t begin(uint16_t port) = 0;
+        virtual void stop() = 0;
+        virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+        virtual int beginPacket(const char *host, uint16_t port) = 0;
+        virtual int endPacket() = 0;
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+        virtual int parsePacket() = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int read(unsigned char *buffer, size_t len) = 0;
+        virtual int peek() = 0;
+        virtual void flush() = 0;
+        virtual IPAddress remoteIP() = 0;
+        virtual uint16_t remotePort() = 0;
+};
+
+class WiFiUDP : public UDP{
+    public:
+        uint8_t begin(uint16_t port){ return 1; }
+        uint8_t beginMulticast(IPAddress interfaceAddr, IPAddress multicast, uint16_t port){ return 1; }
+        void stop() {}
+        int beginPacket(IPAddress ip, uint16_t port){ sent.emplace_back(); return 1; }
+        int beginPacket(const char *host, uint16_t port){ sent.emplace_back(); return 1; }
+        int beginPacketMulticast(IPAddress multicastAddress, uint16_t port, IPAddress interfaceAddress, int ttl = 1){ sent.emplace_back(); return 1; }
+        int endPacket(){ return 1; }
+        size_t write(uint8_t c){ return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size){
+            if(!sent.empty()){
+                sent.back().insert(sent.back().end(), buffer, buffer + size);
+            }
+            return size;
+        }
+        int parsePacket(){ return 0; }
+        int available(){ return 0; }
+        int read(){ return -1; }
+        int read(unsigned char *buffer, size_t len){ return 0; }
+        int peek(){ return -1; }
+        void flush() {}
+        IPAddress remoteIP(){ return IPAddress(); }
+        uint16_t remotePort(){ return 0; }
+
+        // payload of each sent datagram
+        std::vector<std::vector<uint8_t>> sent;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file esp8266_peri.h
+ * @brief Mock of the UART registers of the ESP8266 for the host tests
+ *
+ * Bytes written to the TX FIFO (USF) are recorded, the fill level of the FIFO (USS) counts them
+ * until the test empties it. The other registers are plain variables.
+ *
+ */
+
+#ifndef mock_esp8266_peri_h
+#define mock_esp8266_peri_h
+
+#include <stdint.h>
+#include <vector>
+
+#define ESP8266_CLOCK 80000000UL
+
+// bit positions as in the ESP8266 core
+#define UIFE 1
+#define UCBN 2
+#define UCSBN 4
+#define UCFET 0
+#define USTXC 16
+#define UCTXRST 18
+#define UCTXI 22
+
+class MockUARTFifo{
+    public:
+        MockUARTFifo &operator=(uint32_t value){
+            bytes.push_back(value);
+            level++;
+            return *this;
+        }
+
+        std::vector<uint8_t> bytes;     // all bytes written to the FIFO
+        uint16_t level = 0;             // bytes currently in the FIFO
+};
+
+struct MockUARTRegisters{
+    uint32_t USIS, USIE, USIC, USD, USC0, USC1;
+};
+
+extern MockUARTFifo mockUARTFifo[2];
+extern MockUARTRegisters mockUARTRegs[2];
+
+#define USF(u) mockUARTFifo[(u) & 1]
+#define USS(u) ((uint32_t)mockUARTFifo[(u) & 1].level << USTXC)
+#define USIS(u) mockUARTRegs[(u) & 1].USIS
+#define USIE(u) mockUARTRegs[(u) & 1].USIE
+#define USIC(u) mockUARTRegs[(u) & 1].USIC
+#define USD(u) mockUARTRegs[(u) & 1].USD
+#define USC0(u) mockUARTRegs[(u) & 1].USC0
+#define USC1(u) mockUARTRegs[(u) & 1].USC1
+
+#endif
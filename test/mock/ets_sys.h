@@ -0,0 +1,20 @@
+/**
+ * @file ets_sys.h
+ * @brief Mock of the interrupt functions of the ESP8266 SDK for the host tests
+ *
+ * The handler attached to the UART interrupt is stored, so a test can call it.
+ *
+ */
+
+#ifndef mock_ets_sys_h
+#define mock_ets_sys_h
+
+typedef void (*MockInterruptHandler)(void *arg);
+extern MockInterruptHandler mockUARTHandler;
+extern void *mockUARTHandlerArg;
+
+#define ETS_UART_INTR_ATTACH(handler, arg) (mockUARTHandler = (handler), mockUARTHandlerArg = (arg))
+#define ETS_UART_INTR_ENABLE()
+#define ETS_UART_INTR_DISABLE()
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file mock.cpp
+ * @brief Globals and functions of the mocked Arduino core, linked into every host test
+ *
+ */
+
+#include <Arduino.h>
+#include <ets_sys.h>
+#include <esp8266_peri.h>
+#include <ESP8266WiFi.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+
+unsigned long fakeMillis = 0;
+unsigned long fakeMicros = 0;
+
+MockInterruptHandler mockUARTHandler = nullptr;
+void *mockUARTHandlerArg = nullptr;
+MockUARTFifo mockUARTFifo[2];
+MockUARTRegisters mockUARTRegs[2];
+
+unsigned long millis(){
+    return fakeMillis;
+}
+
+unsigned long micros(){
+    return fakeMicros;
+}
+
+void delay(unsigned long ms){
+    fakeMillis += ms;
+    fakeMicros += ms * 1000;
+}
+
+long random(long max){
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max){
+    return max > min ? min + rand() % (max - min) : min;
+}
+
+void randomSeed(unsigned long seed){
+    srand(seed);
+}
+
+int analogRead(int pin){
+    return 0;
+}
+
+void pinMode(int pin, int mode){
+}
@@ -0,0 +1,12 @@
+/**
+ * @file pgmspace.h
+ * @brief Mock of pgmspace.h for the host tests, see Arduino.h
+ *
+ */
+
+#ifndef mock_pgmspace_h
+#define mock_pgmspace_h
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file test_base64.cpp
+ * @brief Fuzz test and benchmark of the Base64 decoder against the original decoder
+ *
+ * baseline/Base64.* is an unchanged copy of the original library, compiled in its own namespace.
+ * The original decoder has no end of data handling (invalid characters give garbage), so it decodes
+ * only the part of the text in front of the first character which is not part of the alphabet.
+ *
+ */
+
+#include "testing.h"
+#include <random>
+#include <vector>
+#include <Arduino.h>
+#include <pgmspace.h>
+
+namespace baseline {
+#include "baseline/Base64.cpp"
+}
+#undef _BASE64_H
+#include "Base64.h"
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int validPrefix(const char *text, int length){
+    int prefix = 0;
+    while(prefix < length && text[prefix] != '\0' && strchr(alphabet, text[prefix]) != nullptr){
+        prefix++;
+    }
+    return prefix;
+}
+
+/**
+ * @brief Random texts (valid, with padding, random bytes, valid with one invalid character) decoded
+ * at once, in place and streamed in random pieces with a random output size
+ *
+ */
+static void testFuzzAgainstBaseline(){
+    std::mt19937 random(22);
+    std::vector<char> text(2100), expected(2100), decoded(2100), inPlace(2100);
+    unsigned long failures = 0;
+    for(int iteration = 0; iteration < 50000; iteration++){
+        int length = random() % (iteration < 40000 ? 40 : 2000);
+        int kind = random() % 4;
+        for(int i = 0; i < length; i++){
+            text[i] = (kind == 2) ? (char)(random() % 256) : alphabet[random() % 64];
+        }
+        if(kind == 1){
+            for(int k = random() % 3; k > 0 && k <= length; k--){
+                text[length - k] = '=';
+            }
+        }
+        if(kind == 3 && length > 0){
+            text[random() % length] = "=\n -_*\x80\xff"[random() % 8];
+        }
+
+        int expectedLength = baseline::Base64.decode(expected.data(), text.data(), validPrefix(text.data(), length));
+        int decodedLength = Base64.decode(decoded.data(), text.data(), length);
+        bool ok = decodedLength == expectedLength && memcmp(decoded.data(), expected.data(), expectedLength + 1) == 0;
+
+        memcpy(inPlace.data(), text.data(), length);
+        int inPlaceLength = Base64.decode(inPlace.data(), inPlace.data(), length);
+        ok &= inPlaceLength == expectedLength && memcmp(inPlace.data(), expected.data(), expectedLength + 1) == 0;
+
+        // streamed in place, the output buffer may be smaller than the data
+        memcpy(inPlace.data(), text.data(), length);
+        int outputSize = (random() % 3 != 0) ? length : random() % (length + 1);
+        Base64Decoder decoder;
+        decoder.begin(inPlace.data(), outputSize);
+        for(int position = 0; position < length; ){
+            char piece[16];
+            int pieceLength = min(1 + (int)(random() % 9), length - position);
+            memcpy(piece, text.data() + position, pieceLength);
+            decoder.write(piece, pieceLength);
+            position += pieceLength;
+        }
+        int streamedLength = decoder.end();
+        ok &= memcmp(inPlace.data(), expected.data(), streamedLength) == 0;
+        if(outputSize >= expectedLength){
+            ok &= streamedLength == expectedLength;
+        }
+        else{
+            // complete groups as long as they fit, the rest of the buffer stays unused
+            ok &= streamedLength <= outputSize && streamedLength > outputSize - 3;
+        }
+
+        if(!ok && failures++ < 5){
+            printf("text of %d characters (kind %d): expected %d bytes, decoded %d, in place %d, streamed %d of %d\n",
+                   length, kind, expectedLength, decodedLength, inPlaceLength, streamedLength, outputSize);
+        }
+    }
+    CHECK_EQUAL(failures, 0);
+}
+
+static void testEncodeMatchesBaseline(){
+    std::mt19937 random(23);
+    std::vector<char> plain(300), encoded(500), expected(500), decoded(300);
+    unsigned long failures = 0;
+    for(int length = 0; length < 300; length++){
+        for(int i = 0; i < length; i++){
+            plain[i] = random();
+        }
+        int encodedLength = Base64.encode(encoded.data(), plain.data(), length);
+        int expectedLength = baseline::Base64.encode(expected.data(), plain.data(), length);
+        int decodedLength = Base64.decode(decoded.data(), encoded.data(), encodedLength);
+        if(encodedLength != expectedLength || strcmp(encoded.data(), expected.data()) != 0 || encodedLength != Base64.encodedLength(length)
+           || decodedLength != length || memcmp(decoded.data(), plain.data(), length) != 0 || Base64.decodedLength(encoded.data(), encodedLength) != length){
+            failures++;
+        }
+    }
+    CHECK_EQUAL(failures, 0);
+    // the original read in front of the text
+    char empty[1] = {'\0'};
+    CHECK_EQUAL(Base64.decodedLength(empty, 0), 0);
+}
+
+/**
+ * @brief Decode the payload of /leddirect (121 leds * 4 bytes) and a larger block, original and current decoder
+ *
+ */
+static void benchDecode(){
+    std::mt19937 random(24);
+    for(int plainLength : {121 * 4, 16384}){
+        std::vector<char> plain(plainLength), text(plainLength * 2), output(plainLength + 8);
+        for(char &c : plain){
+            c = random();
+        }
+        int textLength = Base64.encode(text.data(), plain.data(), plainLength);
+        unsigned long iterations = plainLength < 1000 ? 200000 : 5000;
+        double original = benchNanoseconds(iterations, [&](unsigned long i){
+            benchSink += baseline::Base64.decode(output.data(), text.data(), textLength);
+        });
+        double current = benchNanoseconds(iterations, [&](unsigned long i){
+            benchSink += Base64.decode(output.data(), text.data(), textLength);
+        });
+        printf("bench Base64.decode %d characters: original %.0f ns (%.2f ns/char), current %.0f ns (%.2f ns/char) (host)\n",
+               textLength, original, original / textLength, current, current / textLength);
+    }
+}
+
+int main(int argc, char **argv){
+    testFuzzAgainstBaseline();
+    testEncodeMatchesBaseline();
+    if(benchRequested(argc, argv)){
+        benchDecode();
+    }
+    return testSummary("test_base64");
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_clockface.cpp
+ * @brief Golden test of the clock face: the word masks generated at compile time (clockface.cpp)
+ * have to light the same letters as the original hand written functions for every minute of the day
+ *
+ * The original functions timeToString() and showStringOnClock() of all languages are in baseline/
+ * (unchanged copies of the former wordclockfunctions.ino*). Each one is compiled in its own namespace
+ * with a fake ledmatrix which records the letters of the sentence.
+ *
+ */
+
+#include "testing.h"
+#include "clockface.h"
+
+/**
+ * @brief Fake of the LEDMatrix used by the original functions, collects the pixels as WordMask
+ *
+ */
+struct BaselineMatrix {
+    WordMask mask;
+
+    void gridFlush(){ mask = WordMask(); }
+    void gridAddPixel(uint8_t x, uint8_t y, uint32_t color){
+        uint8_t index = y * WIDTH + x;
+        mask.bits[index >> 5] |= 1UL << (index & 31);
+    }
+    void setMinIndicator(uint8_t pattern, uint32_t color) {}
+};
+
+struct BaselineLogger {
+    void logString(const String &message) {}
+};
+
+// the original code is kept unchanged, without its warnings
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+// helper of the original sketch (wordclock_esp8266.ino) used by showStringOnClock()
+String split(String s, char parser, int index) {
+  String rs="";
+  int parserIndex = index;
+  int parserCnt=0;
+  int rFromIndex=0, rToIndex=-1;
+  while (index >= parserCnt) {
+    rFromIndex = rToIndex+1;
+    rToIndex = s.indexOf(parser,rFromIndex);
+    if (index == parserCnt) {
+      if (rToIndex == 0 || rToIndex == -1) return "";
+      return s.substring(rFromIndex,rToIndex);
+    } else parserCnt++;
+  }
+  return rs;
+}
+
+namespace german {
+    BaselineMatrix ledmatrix;
+    BaselineLogger logger;
+#include "baseline/wordclockfunctions.ino"
+}
+
+namespace english {
+    BaselineMatrix ledmatrix;
+    BaselineLogger logger;
+#include "baseline/wordclockfunctions.ino_english"
+}
+
+namespace italian {
+    BaselineMatrix ledmatrix;
+    BaselineLogger logger;
+#include "baseline/wordclockfunctions.ino_italian"
+}
+
+#pragma GCC diagnostic pop
+
+static const char *layouts[NUM_LANGUAGES] = {
+    "ESPISTAFUNFVIERTELZEHNZWANZIGUVORTECHNICNACHHALBMELFUNFXCONTROLLEREINSEAWZWEIDREITUMVIERSECHSQYACHTSIEBENZWOLFZEHNEUNJUHR",
+    "ITPISKTENNPQUARTERHALFTWENTYUFIVEMINUTESNATOPASTMEAONEFTWONTHREELRFOUREAWFIVEOSIXZUSEVENEIGHTELEVENUNINETWELVETENAWOCLOCK",
+    "SONORLEBORE=R#UNASDUEZTREOTTONOVEDIECIUNDICIDODICISETTEQUATTROCSEICINQUEAMENOECUNOQUARTOVENTICINQUELVETENAWOCLDIECIPMEZZA"
+};
+
+/**
+ * @brief Letters of a mask as text, words separated by spaces (for the failure message)
+ *
+ */
+static std::string maskToText(const WordMask &mask, const char *layout){
+    std::string text;
+    for(uint8_t i = 0; i < CLOCKFACE_LETTERS; i++){
+        if(mask.isSet(i)){
+            text += layout[i];
+        }
+        else if(i > 0 && mask.isSet(i - 1)){
+            text += ' ';
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Time as sentence of the original functions
+ *
+ */
+static String baselineSentence(uint8_t language, uint8_t hours, uint8_t minutes){
+    switch(language){
+        case lang_german:
+            return german::timeToString(hours, minutes);
+        case lang_english:
+            return english::timeToString(hours, minutes);
+        default:
+            return italian::timeToString(hours, minutes);
+    }
+}
+
+/**
+ * @brief Letters of a sentence as the original showStringOnClock() lights them
+ *
+ */
+static WordMask renderBaseline(uint8_t language, const String &sentence){
+    switch(language){
+        case lang_german:
+            german::showStringOnClock(sentence, 0xffffff);
+            return german::ledmatrix.mask;
+        case lang_english:
+            english::showStringOnClock(sentence, 0xffffff);
+            return english::ledmatrix.mask;
+        default:
+            italian::showStringOnClock(sentence, 0xffffff);
+            return italian::ledmatrix.mask;
+    }
+}
+
+static String replacePrefix(const String &sentence, const char *prefix){
+    int end = sentence.indexOf(sentence[0] == '=' ? "# " : "LE ");
+    return String(prefix) + sentence.substring(end + (sentence[0] == '=' ? 1 : 2), sentence.length());
+}
+
+static String addTwelve(const String &sentence){
+    int end = sentence.indexOf("OCLOCK");
+    if(end < 0){
+        return sentence + "TWELVE ";
+    }
+    return sentence.substring(0, end) + "TWELVE OCLOCK ";
+}
+
+static String italianPrefixForUna(const String &sentence){ return replacePrefix(sentence, "= #"); }
+static String italianPrefixForDodici(const String &sentence){ return replacePrefix(sentence, "SONO LE"); }
+
+/**
+ * @brief Time states (hour 0-11, minutes / 5) in which the table intentionally differs from the original functions.
+ * If the words differ, correctSentence() fixes the sentence of the original, otherwise only the letters
+ * which show the words are taken from another place of the layout.
+ *
+ */
+struct BaselineDeviation {
+    uint8_t language;
+    bool (*applies)(uint8_t hour, uint8_t slot);
+    String (*correctSentence)(const String &sentence);
+    const char *reason;
+};
+
+static const BaselineDeviation deviations[] = {
+    {lang_german, [](uint8_t h, uint8_t s){ return s == 0 && (h == 4 || h == 5 || h == 10); }, nullptr,
+     "full hour: the original took VIER, FUNF and ZEHN from the minute words"},
+    {lang_english, [](uint8_t h, uint8_t s){ return s == 0 && (h == 5 || h == 10); }, nullptr,
+     "full hour: the original took FIVE and TEN from the minute words"},
+    {lang_english, [](uint8_t h, uint8_t s){ return (h == 0 && s < 7) || (h == 11 && s >= 7); }, addTwelve,
+     "the original has no case for hour 12, TWELVE was missing"},
+    {lang_italian, [](uint8_t h, uint8_t s){ return s >= 1 && s <= 6; }, nullptr,
+     "minutes E ...: the original took E, UN, DIECI and CINQUE behind the hour from anywhere in the layout"},
+    {lang_italian, [](uint8_t h, uint8_t s){ return h == 0 && s >= 7; }, italianPrefixForUna,
+     "E' L'UNA MENO ...: the original chose the prefix before advancing to the next hour"},
+    {lang_italian, [](uint8_t h, uint8_t s){ return h == 11 && s >= 7; }, italianPrefixForDodici,
+     "SONO LE DODICI MENO ...: the original chose the prefix before advancing to the next hour"},
+};
+
+static const BaselineDeviation *findDeviation(uint8_t language, uint8_t hours, uint8_t minutes){
+    for(const BaselineDeviation &deviation : deviations){
+        if(deviation.language == language && deviation.applies(hours % 12, minutes / 5)){
+            return &deviation;
+        }
+    }
+    return nullptr;
+}
+
+static std::string lettersOf(const std::string &text){
+    std::string letters;
+    for(char c : text){
+        if(c != ' '){
+            letters += c;
+        }
+    }
+    return letters;
+}
+
+static bool sameMask(const WordMask &a, const WordMask &b){
+    return memcmp(&a, &b, sizeof(WordMask)) == 0;
+}
+
+/**
+ * @brief Render all 1440 minutes of a day with the table and the original functions
+ *
+ */
+static void testAllMinutesMatchBaseline(uint8_t language){
+    unsigned int differences = 0;
+    for(uint8_t hours = 0; hours < 24; hours++){
+        for(uint8_t minutes = 0; minutes < 60; minutes++){
+            String sentence = baselineSentence(language, hours, minutes);
+            const BaselineDeviation *deviation = findDeviation(language, hours, minutes);
+            if(deviation != nullptr && deviation->correctSentence != nullptr){
+                sentence = deviation->correctSentence(sentence);
+            }
+            WordMask expected = renderBaseline(language, sentence);
+            WordMask actual;
+            memcpy_P(&actual, getClockFaceMask(language, hours, minutes), sizeof(actual));
+            std::string expectedText = maskToText(expected, layouts[language]);
+            std::string actualText = maskToText(actual, layouts[language]);
+
+            bool ok;
+            if(deviation != nullptr && deviation->correctSentence == nullptr){
+                // same words at other places: letters equal, positions differ
+                ok = !sameMask(expected, actual) && lettersOf(expectedText) == lettersOf(actualText);
+            }
+            else{
+                ok = sameMask(expected, actual);
+            }
+            if(!ok && differences++ < 5){
+                printf("%s %02u:%02u: original \"%s\", table \"%s\"%s%s\n", getLanguageName(language), hours, minutes,
+                       expectedText.c_str(), actualText.c_str(), deviation ? ", known deviation: " : "", deviation ? deviation->reason : "");
+            }
+        }
+    }
+    CHECK_EQUAL(differences, 0);
+}
+
+/**
+ * @brief Positions of the words which the original functions took from the wrong place
+ *
+ */
+static void testCorrectedWordPositions(){
+    // VIER UHR: VIER of the hours (row 8), not of VIERTEL
+    CHECK(getClockFaceMask(lang_german, 4, 0)->isSet(84));
+    CHECK(!getClockFaceMask(lang_german, 4, 0)->isSet(11));
+    // FIVE OCLOCK: FIVE of the hours (row 7)
+    CHECK(getClockFaceMask(lang_english, 5, 0)->isSet(73));
+    CHECK(!getClockFaceMask(lang_english, 5, 0)->isSet(29));
+    for(uint8_t hours = 0; hours < 12; hours++){
+        for(uint8_t minutes = 5; minutes <= 30; minutes += 5){
+            // E in front of the minutes: the single E at the start of row 8, not the E of MENO
+            CHECK(getClockFaceMask(lang_italian, hours, minutes)->isSet(77));
+            CHECK(!getClockFaceMask(lang_italian, hours, minutes)->isSet(74));
+        }
+    }
+}
+
+static void testLanguageNames(){
+    CHECK_EQUAL(findLanguage("de"), lang_german);
+    CHECK_EQUAL(findLanguage("en"), lang_english);
+    CHECK_EQUAL(findLanguage("it"), lang_italian);
+    CHECK_EQUAL(findLanguage("fr"), -1);
+    CHECK_EQUAL(findLanguage(""), -1);
+    CHECK(strcmp(getLanguageName(lang_english), "en") == 0);
+    CHECK(strcmp(getLanguageName(NUM_LANGUAGES), "") == 0);
+    // invalid language falls back to German
+    CHECK(getClockFaceMask(NUM_LANGUAGES, 3, 15) == getClockFaceMask(lang_german, 3, 15));
+}
+
+int main(int argc, char **argv){
+    for(uint8_t language = 0; language < NUM_LANGUAGES; language++){
+        testAllMinutesMatchBaseline(language);
+    }
+    testCorrectedWordPositions();
+    testLanguageNames();
+    return testSummary("test_clockface");
+}
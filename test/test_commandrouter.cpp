@@ -0,0 +1,356 @@
+/**
+ * @file test_commandrouter.cpp
+ * @brief Host tests of CommandRouter and CommandArgs: the queries of the web interface (data/index.html)
+ * replayed against handlers which parse their arguments like the handlers of the sketch, invalid values
+ * and collisions in the hash table
+ *
+ */
+
+#include "testing.h"
+#include <string>
+#include <vector>
+#include "commandrouter.h"
+
+// what the last executed handler did
+static std::string effect;
+
+static const char *const modeNames[] = {"clock", "diclock", "spiral", "tetris", "snake", "pingpong"};
+static const char *const languages[] = {"de", "en", "it"};
+
+// handlers with the same parsing as in wordclock_esp8266.ino, the action is replaced by a note in effect
+
+static CommandResult cmdLED(CommandArgs &args){
+    uint8_t red, green, blue;
+    if(!args.nextColor(red, green, blue) || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = "color " + std::to_string(red) + " " + std::to_string(green) + " " + std::to_string(blue);
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdMode(CommandArgs &args){
+    int8_t state = args.nextEnum(modeNames, 6);
+    if(state < 0 || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = "mode " + std::to_string(state);
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdNightmode(CommandArgs &args){
+    bool on;
+    if(!args.nextBool(on) || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = std::string("nightmode ") + (on ? "1" : "0");
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdSetting(CommandArgs &args){
+    int startHour, startMin, endHour, endMin;
+    long brightness;
+    if(!args.nextTime(startHour, startMin) || !args.nextTime(endHour, endMin) || !args.nextInt(brightness, 0, 255) || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        char text[64];
+        snprintf(text, sizeof(text), "setting %d:%02d %d:%02d %ld", startHour, startMin, endHour, endMin, brightness < 10 ? 10 : brightness);
+        effect = text;
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdResetWifi(CommandArgs &args){
+    if(!args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = "resetwifi";
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdLanguage(CommandArgs &args){
+    for(int i = 0; i < 3; i++){
+        if(strcmp(languages[i], args.getString()) == 0){
+            if(!args.isCheckOnly()){
+                effect = "language " + std::to_string(i);
+            }
+            return cmd_ok;
+        }
+    }
+    return cmd_invalid;
+}
+
+static CommandResult cmdStateAutoChange(CommandArgs &args){
+    bool on;
+    if(!args.nextBool(on) || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = std::string("stateautochange ") + (on ? "1" : "0");
+    }
+    return cmd_ok;
+}
+
+static CommandResult control(CommandArgs &args, const char *game, const char *const controls[], uint8_t count){
+    int8_t control = args.nextEnum(controls, count);
+    if(control < 0 || !args.atEnd()){
+        return cmd_invalid;
+    }
+    if(!args.isCheckOnly()){
+        effect = std::string(game) + " " + controls[control];
+    }
+    return cmd_ok;
+}
+
+static CommandResult cmdTetris(CommandArgs &args){
+    static const char *const controls[] = {"up", "left", "right", "down", "play", "pause"};
+    return control(args, "tetris", controls, 6);
+}
+
+static CommandResult cmdSnake(CommandArgs &args){
+    static const char *const controls[] = {"up", "left", "right", "down", "new"};
+    return control(args, "snake", controls, 5);
+}
+
+static CommandResult cmdPong(CommandArgs &args){
+    static const char *const controls[] = {"up", "down", "new"};
+    return control(args, "pong", controls, 3);
+}
+
+static CommandResult cmdNop(CommandArgs &args){
+    effect = "nop";
+    return cmd_ok;
+}
+
+/**
+ * @brief Router with the commands of setupCommands() (without timezone, TimeZone has its own tests)
+ *
+ */
+static bool setupCommands(CommandRouter &router){
+    return router.add("led", cmdLED) && router.add("mode", cmdMode) && router.add("nightmode", cmdNightmode)
+           && router.add("setting", cmdSetting) && router.add("resetwifi", cmdResetWifi) && router.add("language", cmdLanguage)
+           && router.add("stateautochange", cmdStateAutoChange) && router.add("tetris", cmdTetris)
+           && router.add("snake", cmdSnake) && router.add("pong", cmdPong);
+}
+
+/**
+ * @brief Split "name=value" like the webserver and dispatch it
+ *
+ */
+static CommandResult dispatchQuery(const CommandRouter &router, const std::string &query, bool checkOnly = false){
+    size_t equal = query.find('=');
+    std::string name = query.substr(0, equal);
+    std::string value = (equal == std::string::npos) ? "" : query.substr(equal + 1);
+    effect.clear();
+    return checkOnly ? router.check(name.c_str(), value.c_str()) : router.dispatch(name.c_str(), value.c_str());
+}
+
+/**
+ * @brief All "./cmd?..." queries written literally in the web interface
+ *
+ */
+static std::vector<std::string> queriesOfWebInterface(){
+    std::vector<std::string> queries;
+    FILE *fp = fopen("../data/index.html", "r");
+    if(fp == nullptr){
+        return queries;
+    }
+    std::string html;
+    char buffer[4096];
+    size_t length;
+    while((length = fread(buffer, 1, sizeof(buffer), fp)) > 0){
+        html.append(buffer, length);
+    }
+    fclose(fp);
+    const std::string prefix = "./cmd?";
+    for(size_t start = html.find(prefix); start != std::string::npos; start = html.find(prefix, start)){
+        start += prefix.size();
+        size_t end = html.find_first_of("'\"", start);
+        queries.push_back(html.substr(start, end - start));
+    }
+    return queries;
+}
+
+/**
+ * @brief Every query of the web interface is accepted and check() agrees with dispatch(),
+ * the setting query is built by saveSettings() from the time inputs ("22:00" -> "22-00")
+ *
+ */
+static void testQueriesOfWebInterface(){
+    CommandRouter router;
+    CHECK(setupCommands(router));
+    std::vector<std::string> queries = queriesOfWebInterface();
+    // 6 modes, 12 colors, 5 snake, 6 tetris, 3 pong, 2 nightmode, 2 stateautochange, setting= (built below), resetwifi
+    CHECK_EQUAL(queries.size(), 38);
+    queries.push_back("setting=22-00-07-30-50");
+    for(const std::string &query : queries){
+        if(query == "setting="){
+            continue;
+        }
+        CommandResult checked = dispatchQuery(router, query, true);
+        bool executedByCheck = !effect.empty();
+        CommandResult result = dispatchQuery(router, query);
+        if(!testCheck(checked == cmd_ok && result == cmd_ok && !executedByCheck && !effect.empty(), "query of the web interface accepted", __FILE__, __LINE__)){
+            printf("    %s: check %d, dispatch %d\n", query.c_str(), checked, result);
+        }
+    }
+}
+
+/**
+ * @brief Results and effects of valid and invalid values
+ *
+ */
+static void testValues(){
+    struct QueryCase {
+        const char *query;
+        CommandResult result;
+        const char *effect;
+    };
+    static const QueryCase cases[] = {
+        {"led=255-0-128", cmd_ok, "color 255 0 128"},
+        {"led=0-0-0", cmd_ok, "color 0 0 0"},
+        {"led=007-08-9", cmd_ok, "color 7 8 9"},
+        {"led=256-0-0", cmd_invalid, ""},
+        {"led=1-2", cmd_invalid, ""},
+        {"led=1-2-3-4", cmd_invalid, ""},           // trailing input
+        {"led=1-2-3-", cmd_invalid, ""},            // trailing separator
+        {"led=1-2-3x", cmd_invalid, ""},
+        {"led=1--2-3", cmd_invalid, ""},
+        {"led=-1-2-3", cmd_invalid, ""},
+        {"led=99999999999999999999-0-0", cmd_invalid, ""},
+        {"led=", cmd_invalid, ""},
+        {"mode=pingpong", cmd_ok, "mode 5"},
+        {"mode=clocks", cmd_invalid, ""},
+        {"mode=cloc", cmd_invalid, ""},
+        {"mode=clock-", cmd_invalid, ""},
+        {"mode=clock-spiral", cmd_invalid, ""},
+        {"mode=", cmd_invalid, ""},
+        {"nightmode=1", cmd_ok, "nightmode 1"},
+        {"nightmode=2", cmd_invalid, ""},
+        {"nightmode=1-9", cmd_invalid, ""},
+        {"nightmode=true", cmd_invalid, ""},
+        {"stateautochange=0", cmd_ok, "stateautochange 0"},
+        {"stateautochange=01", cmd_ok, "stateautochange 1"},
+        {"stateautochange=0-", cmd_invalid, ""},
+        {"setting=23-59-00-00-5", cmd_ok, "setting 23:59 0:00 10"},
+        {"setting=22-00-07-30-255", cmd_ok, "setting 22:00 7:30 255"},
+        {"setting=24-00-07-30-50", cmd_invalid, ""},
+        {"setting=22-60-07-30-50", cmd_invalid, ""},
+        {"setting=22-00-07-30-256", cmd_invalid, ""},
+        {"setting=22-00-07-30", cmd_invalid, ""},
+        {"setting=22-00-07-30-255-x", cmd_invalid, ""},
+        {"setting=22-00-07-30-50-", cmd_invalid, ""},
+        {"setting=22:00-07:30-50", cmd_invalid, ""},
+        {"resetwifi", cmd_ok, "resetwifi"},
+        {"resetwifi=", cmd_ok, "resetwifi"},
+        {"resetwifi=1", cmd_invalid, ""},
+        {"resetwifi=-", cmd_invalid, ""},
+        {"language=it", cmd_ok, "language 2"},
+        {"language=fr", cmd_invalid, ""},
+        {"language=en-", cmd_invalid, ""},
+        {"tetris=pause", cmd_ok, "tetris pause"},
+        {"tetris=new", cmd_invalid, ""},
+        {"snake=new-new", cmd_invalid, ""},
+        {"pong=left", cmd_invalid, ""},
+        {"pong=up-", cmd_invalid, ""},
+        // unknown names
+        {"foo=1", cmd_unknown, ""},
+        {"=1", cmd_unknown, ""},
+        {"", cmd_unknown, ""},
+        {"LED=1-2-3", cmd_unknown, ""},
+        {"le=1-2-3", cmd_unknown, ""},
+        {"ledx=1-2-3", cmd_unknown, ""},
+        {"timezone=UTC0", cmd_unknown, ""},
+    };
+    CommandRouter router;
+    CHECK(setupCommands(router));
+    for(const QueryCase &c : cases){
+        CommandResult checked = dispatchQuery(router, c.query, true);
+        bool executedByCheck = !effect.empty();
+        CommandResult result = dispatchQuery(router, c.query);
+        if(!testCheck(result == c.result && checked == c.result && !executedByCheck && effect == c.effect, "result of the query", __FILE__, __LINE__)){
+            printf("    %s: dispatch %d (expected %d), check %d, effect \"%s\" (expected \"%s\")\n",
+                   c.query, result, c.result, checked, effect.c_str(), c.effect);
+        }
+    }
+}
+
+/**
+ * @brief Names in the same slot of the hash table are found behind each other, a full table
+ * and names which exist already are rejected
+ *
+ */
+static void testHashCollisions(){
+    CommandRouter router;
+    CHECK(setupCommands(router));
+    CHECK(!router.add("led", cmdNop));
+    CHECK_EQUAL(router.getNumCommands(), 10);
+
+    // names with the slot of "led" (linear probing behind it) and with the slot of "pong"
+    std::vector<std::string> colliding;
+    for(int i = 0; colliding.size() < 4; i++){
+        std::string name = "c" + std::to_string(i);
+        uint32_t slot = CommandRouter::hash(name.c_str()) & (COMMANDROUTER_TABLE_SIZE - 1);
+        if(slot == (CommandRouter::hash(colliding.size() < 3 ? "led" : "pong") & (COMMANDROUTER_TABLE_SIZE - 1))){
+            colliding.push_back(name);
+        }
+    }
+    for(size_t i = 0; i < 3; i++){
+        CHECK(router.add(colliding[i].c_str(), cmdNop));
+    }
+    // a colliding name which is not registered ends at the next empty slot
+    CHECK_EQUAL(dispatchQuery(router, colliding[3] + "=1"), cmd_unknown);
+    for(size_t i = 0; i < 3; i++){
+        CHECK_EQUAL(dispatchQuery(router, colliding[i]), cmd_ok);
+        CHECK(effect == "nop");
+    }
+    CHECK_EQUAL(dispatchQuery(router, "led=1-2-3"), cmd_ok);
+    CHECK(effect == "color 1 2 3");
+    CHECK_EQUAL(dispatchQuery(router, "pong=new"), cmd_ok);
+    CHECK(effect == "pong new");
+
+    // table full at COMMANDROUTER_MAX_COMMANDS
+    std::vector<std::string> names;
+    for(int i = 0; i < COMMANDROUTER_MAX_COMMANDS + 2; i++){
+        names.push_back("n" + std::to_string(i));
+    }
+    for(int i = 0; i < 3; i++){
+        CHECK(router.add(names[i].c_str(), cmdNop));
+    }
+    CHECK_EQUAL(router.getNumCommands(), COMMANDROUTER_MAX_COMMANDS);
+    CHECK(!router.add(names[3].c_str(), cmdNop));
+    CHECK_EQUAL(dispatchQuery(router, names[3]), cmd_unknown);
+    CHECK_EQUAL(dispatchQuery(router, names[2]), cmd_ok);
+    CHECK_EQUAL(dispatchQuery(router, "snake=up"), cmd_ok);
+}
+
+static void benchDispatch(){
+    CommandRouter router;
+    setupCommands(router);
+    // check(): lookup and parsing without the effect string of the test handlers
+    double known = benchNanoseconds(10000000, [&](unsigned long i){
+        benchSink += router.check("setting", "22-00-07-30-50");
+    });
+    double unknown = benchNanoseconds(10000000, [&](unsigned long i){
+        benchSink += router.check("brightness", "50");
+    });
+    printf("bench CommandRouter::check: setting=22-00-07-30-50 %.1f ns, unknown name %.1f ns (host)\n", known, unknown);
+}
+
+int main(int argc, char **argv){
+    testQueriesOfWebInterface();
+    testValues();
+    testHashCollisions();
+    if(benchRequested(argc, argv)){
+        benchDispatch();
+    }
+    return testSummary("test_commandrouter");
+}
@@ -0,0 +1,220 @@
+/**
+ * @file test_framestream.cpp
+ * @brief Replay of a recorded DDP frame stream through FrameStreamDecoder and LEDMatrix (like handleFrameStream()
+ * of the sketch): which frames of the sender are shown and the statistics of the decoder
+ *
+ * Recording format: for each received datagram [time in ms, uint32 little endian][length, uint16 little endian][payload]
+ *
+ * data/framestream.rec was written by this test (./build/test_framestream --record data/framestream.rec) and
+ * contains a sender of 50 fps with: a lost packet, a duplicated packet, two reordered packets, frames split into
+ * two packets with timecode, a wrap of the sequence numbers, a malformed packet, a restart of the sender after
+ * a pause, a frame with more leds than the display and a packet beyond the last led.
+ * Each frame n of the sender has its own pattern (frameData()), so the shown frame can be identified.
+ *
+ */
+
+#include "testing.h"
+#include <vector>
+#include "ledmatrix.h"
+#include "framestream.h"
+
+static const char *recordingFile = "data/framestream.rec";
+
+struct RecordedPacket {
+    uint32_t time;
+    std::vector<uint8_t> payload;
+};
+
+/**
+ * @brief RGB data of frame n of the sender
+ *
+ */
+static std::vector<uint8_t> frameData(int n, int pixels){
+    std::vector<uint8_t> data(pixels * 3);
+    for(int i = 0; i < pixels * 3; i++){
+        data[i] = (uint8_t)(n * 7 + i * 13);
+    }
+    return data;
+}
+
+static std::vector<uint8_t> ddpPacket(uint8_t sequence, bool push, uint32_t firstPixel, const uint8_t *rgb, uint16_t pixels, bool timecode = false){
+    uint32_t offset = firstPixel * 3;
+    uint16_t length = pixels * 3;
+    std::vector<uint8_t> packet = {(uint8_t)(DDP_FLAG_VERSION_1 | (push ? DDP_FLAG_PUSH : 0) | (timecode ? DDP_FLAG_TIMECODE : 0)), sequence,
+                                   DDP_TYPE_RGB24, DDP_ID_DISPLAY, (uint8_t)(offset >> 24), (uint8_t)(offset >> 16), (uint8_t)(offset >> 8),
+                                   (uint8_t)offset, (uint8_t)(length >> 8), (uint8_t)length};
+    if(timecode){
+        packet.insert(packet.end(), {0, 0, 0x12, 0x34});
+    }
+    packet.insert(packet.end(), rgb, rgb + length);
+    return packet;
+}
+
+/**
+ * @brief The impaired stream of the recording (see file comment)
+ *
+ */
+static std::vector<RecordedPacket> generateStream(){
+    std::vector<RecordedPacket> stream;
+    uint32_t time = 0;
+    auto send = [&](uint8_t sequence, bool push, uint32_t firstPixel, int frame, uint16_t pixels, bool timecode = false){
+        std::vector<uint8_t> data = frameData(frame, firstPixel + pixels);
+        stream.push_back({time, ddpPacket(sequence, push, firstPixel, &data[firstPixel * 3], pixels, timecode)});
+    };
+    // frames 0-5 with sequence 1-6
+    for(int frame = 0; frame <= 5; frame++, time += 20){
+        send(frame + 1, true, 0, frame, NUM_LEDS);
+    }
+    // frame 6 lost, frame 7 duplicated
+    time += 20;
+    send(8, true, 0, 7, NUM_LEDS);
+    send(8, true, 0, 7, NUM_LEDS);
+    time += 20;
+    // frames 8 and 9 swapped
+    time += 20;
+    send(10, true, 0, 9, NUM_LEDS);
+    send(9, true, 0, 8, NUM_LEDS);
+    time += 20;
+    // frames 10-13 in two packets with timecode, sequence numbers wrap from 15 to 1
+    for(int frame = 10; frame <= 13; frame++, time += 20){
+        uint8_t sequence = (11 + (frame - 10) * 2 - 1) % 15 + 1;
+        send(sequence, false, 0, frame, 60, true);
+        send(sequence % 15 + 1, true, 60, frame, NUM_LEDS - 60, true);
+    }
+    // malformed: length field longer than the packet
+    std::vector<uint8_t> malformed = stream.back().payload;
+    malformed.resize(malformed.size() - 30);
+    stream.push_back({time, malformed});
+    // sender restarts after a pause with sequence 1
+    time += 1500;
+    for(int frame = 14; frame <= 17; frame++, time += 20){
+        send(frame - 13, true, 0, frame, NUM_LEDS);
+    }
+    // frame with 200 leds is clipped, a packet behind the last led only pushes
+    send(5, true, 0, 18, 200);
+    time += 20;
+    send(6, true, NUM_LEDS, 19, 10);
+    return stream;
+}
+
+static bool writeRecording(const char *file, const std::vector<RecordedPacket> &stream){
+    FILE *fp = fopen(file, "wb");
+    if(fp == nullptr){
+        return false;
+    }
+    for(const RecordedPacket &packet : stream){
+        uint8_t header[6] = {(uint8_t)packet.time, (uint8_t)(packet.time >> 8), (uint8_t)(packet.time >> 16), (uint8_t)(packet.time >> 24),
+                             (uint8_t)packet.payload.size(), (uint8_t)(packet.payload.size() >> 8)};
+        fwrite(header, 1, sizeof(header), fp);
+        fwrite(packet.payload.data(), 1, packet.payload.size(), fp);
+    }
+    return fclose(fp) == 0;
+}
+
+static std::vector<RecordedPacket> readRecording(const char *file){
+    std::vector<RecordedPacket> stream;
+    FILE *fp = fopen(file, "rb");
+    if(fp == nullptr){
+        return stream;
+    }
+    uint8_t header[6];
+    while(fread(header, 1, sizeof(header), fp) == sizeof(header)){
+        RecordedPacket packet;
+        packet.time = header[0] | header[1] << 8 | header[2] << 16 | (uint32_t)header[3] << 24;
+        packet.payload.resize(header[4] | header[5] << 8);
+        if(fread(packet.payload.data(), 1, packet.payload.size(), fp) != packet.payload.size()){
+            break;
+        }
+        stream.push_back(packet);
+    }
+    fclose(fp);
+    return stream;
+}
+
+/**
+ * @brief Number of the sender frame shown by the matrix, -1 if the leds show no complete frame
+ *
+ */
+static int shownFrame(LEDMatrix &ledmatrix){
+    for(int n = 0; n < 64; n++){
+        std::vector<uint8_t> data = frameData(n, NUM_LEDS);
+        bool same = true;
+        for(uint8_t i = 0; i < NUM_LEDS && same; i++){
+            same = ledmatrix.getTargetColor(i) == LEDMatrix::Color24bit(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+        }
+        if(same){
+            return n;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Decode the stream like handleFrameStream() and note the shown frame at each push
+ *
+ */
+static std::vector<int> replay(const std::vector<RecordedPacket> &stream, FrameStreamDecoder &decoder, LEDMatrix &ledmatrix){
+    std::vector<int> shown;
+    for(const RecordedPacket &packet : stream){
+        fakeMillis = packet.time;
+        FramePacket frame;
+        if(!decoder.decode(packet.payload.data(), packet.payload.size(), packet.time, frame)){
+            continue;
+        }
+        ledmatrix.gridSetPixels(frame.firstPixel, frame.data, frame.pixels);
+        if(frame.push){
+            ledmatrix.drawOnMatrixInstant();
+            shown.push_back(shownFrame(ledmatrix));
+        }
+    }
+    return shown;
+}
+
+static void testRecordingIsCurrent(){
+    std::vector<RecordedPacket> recorded = readRecording(recordingFile);
+    std::vector<RecordedPacket> generated = generateStream();
+    CHECK_EQUAL(recorded.size(), generated.size());
+    bool same = recorded.size() == generated.size();
+    for(size_t i = 0; i < recorded.size() && same; i++){
+        same = recorded[i].time == generated[i].time && recorded[i].payload == generated[i].payload;
+    }
+    CHECK(same);
+}
+
+static void testReplayImpairedStream(){
+    std::vector<RecordedPacket> stream = readRecording(recordingFile);
+    CHECK(!stream.empty());
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, 255, &logger);
+    FrameStreamDecoder decoder(NUM_LEDS);
+    std::vector<int> shown = replay(stream, decoder, ledmatrix);
+
+    // frame 6 lost, 7 only once, 8 too late, 14-17 after the restart, 18 clipped and pushed again
+    const std::vector<int> expected = {0, 1, 2, 3, 4, 5, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 18};
+    CHECK(shown == expected);
+    if(shown != expected){
+        printf("    shown frames:");
+        for(int frame : shown){
+            printf(" %d", frame);
+        }
+        printf("\n");
+    }
+    CHECK_EQUAL(decoder.getFrames(), expected.size());
+    CHECK_EQUAL(decoder.getPackets(), expected.size() + 4);
+    // sequence 7 missing, sequence 9 missing when 10 arrived
+    CHECK_EQUAL(decoder.getLostPackets(), 2);
+    // duplicate of 8, late 9
+    CHECK_EQUAL(decoder.getDroppedPackets(), 2);
+    CHECK_EQUAL(decoder.getInvalidPackets(), 1);
+    CHECK_EQUAL(matrix.shows, expected.size() - 1);
+}
+
+int main(int argc, char **argv){
+    if(argc > 2 && strcmp(argv[1], "--record") == 0){
+        return writeRecording(argv[2], generateStream()) ? 0 : 1;
+    }
+    testRecordingIsCurrent();
+    testReplayImpairedStream();
+    return testSummary("test_framestream");
+}
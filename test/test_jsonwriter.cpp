@@ -0,0 +1,125 @@
+/**
+ * @file test_jsonwriter.cpp
+ * @brief Host tests of JsonWriter: commas, nesting, escaping and the output in chunks of the buffer size
+ *
+ */
+
+#include "testing.h"
+#include <string>
+#include <vector>
+#include "jsonwriter.h"
+
+static std::string output;
+static std::vector<uint16_t> chunks;
+
+static void collect(const char *data, uint16_t length){
+    output.append(data, length);
+    chunks.push_back(length);
+}
+
+/**
+ * @brief Write a document with nested values and all value types
+ *
+ */
+static void writeDocument(JsonWriter &json){
+    json.beginObject();
+    json.addNumber("modeid", 3);
+    json.addUnsigned("heap", 4294967295UL);
+    json.addNumber("offset", -2147483647L - 1);
+    json.add("name", "Wordclock \"Küche\"\\1");
+    json.add("none", nullptr);
+    json.addFormatted("color", "%02X%02X%02X", 255, 0, 128);
+    json.beginArray("files");
+    json.beginObject();
+    json.add("name", "index.html");
+    json.addUnsigned("size", 12345);
+    json.endObject();
+    json.beginObject();
+    json.endObject();
+    json.beginArray();
+    json.endArray();
+    json.add(nullptr, "tab\tnewline\n\x01");
+    json.endArray();
+    json.beginObject("empty");
+    json.endObject();
+    json.endObject();
+    json.flush();
+}
+
+static const char *expectedDocument =
+    "{\"modeid\":3,\"heap\":4294967295,\"offset\":-2147483648,\"name\":\"Wordclock \\\"Küche\\\"\\\\1\",\"none\":null,"
+    "\"color\":\"FF0080\",\"files\":[{\"name\":\"index.html\",\"size\":12345},{},[],\"tab\\u0009newline\\u000a\\u0001\"],"
+    "\"empty\":{}}";
+
+/**
+ * @brief The document is the same for every buffer size, all chunks but the last one fill the buffer
+ *
+ */
+static void testDocumentInChunks(){
+    for(uint16_t size : {1, 8, 13, 256}){
+        std::vector<char> buffer(size);
+        output.clear();
+        chunks.clear();
+        JsonWriter json(buffer.data(), size, collect);
+        writeDocument(json);
+        CHECK(output == expectedDocument);
+        CHECK_EQUAL(json.getLength(), strlen(expectedDocument));
+        unsigned long partialChunks = 0;
+        for(size_t i = 0; i + 1 < chunks.size(); i++){
+            partialChunks += chunks[i] != size;
+        }
+        CHECK_EQUAL(partialChunks, 0);
+        CHECK_EQUAL(chunks.size(), (strlen(expectedDocument) + size - 1) / size);
+    }
+}
+
+/**
+ * @brief A value formatted longer than JSONWRITER_FORMAT_SIZE is truncated
+ *
+ */
+static void testFormattedTruncated(){
+    char buffer[32];
+    output.clear();
+    JsonWriter json(buffer, sizeof(buffer), collect);
+    json.addFormatted(nullptr, "%0*d", JSONWRITER_FORMAT_SIZE + 10, 7);
+    json.flush();
+    CHECK_EQUAL(output.size(), JSONWRITER_FORMAT_SIZE - 1 + 2);
+}
+
+/**
+ * @brief Nesting deeper than JSONWRITER_MAX_DEPTH - 1 levels and an end without begin let the writer fail,
+ * the output stops at the failing call
+ *
+ */
+static void testNestingOverflowFails(){
+    char buffer[64];
+    output.clear();
+    JsonWriter json(buffer, sizeof(buffer), collect);
+    for(int i = 0; i < JSONWRITER_MAX_DEPTH - 1; i++){
+        json.beginArray();
+    }
+    CHECK(!json.hasFailed());
+    json.beginObject();
+    CHECK(json.hasFailed());
+    json.endArray();
+    json.flush();
+    CHECK(output == std::string(JSONWRITER_MAX_DEPTH - 1, '['));
+
+    output.clear();
+    JsonWriter unbalanced(buffer, sizeof(buffer), collect);
+    unbalanced.beginObject();
+    unbalanced.endObject();
+    CHECK(!unbalanced.hasFailed());
+    unbalanced.endObject();
+    unbalanced.add(nullptr, "after");
+    unbalanced.flush();
+    CHECK(unbalanced.hasFailed());
+    CHECK(output == "{}");
+}
+
+int main(int argc, char **argv){
+    testDocumentInChunks();
+    testFormattedTruncated();
+    testNestingOverflowFails();
+    return testSummary("test_jsonwriter");
+}
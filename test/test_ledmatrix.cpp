@@ -0,0 +1,351 @@
+/**
+ * @file test_ledmatrix.cpp
+ * @brief Host tests of LEDMatrix
+ *
+ */
+
+#include "testing.h"
+#include <math.h>
+#include "ledmatrix.h"
+
+/**
+ * @brief Float blend of the original implementation (before the Q8 fixed point version), reference of the tests
+ *
+ */
+static uint32_t interpolateColor24bitFloat(uint32_t color1, uint32_t color2, float factor){
+    uint8_t resultRed = color1 >> 16 & 0xff;
+    uint8_t resultGreen = color1 >> 8 & 0xff;
+    uint8_t resultBlue = color1 & 0xff;
+    resultRed = (uint8_t)(resultRed + (int16_t)(factor * ((int16_t)(color2 >> 16 & 0xff) - (int16_t)resultRed)));
+    resultGreen = (uint8_t)(resultGreen + (int16_t)(factor * ((int16_t)(color2 >> 8 & 0xff) - (int16_t)resultGreen)));
+    resultBlue = (uint8_t)(resultBlue + (int16_t)(factor * ((int16_t)(color2 & 0xff) - (int16_t)resultBlue)));
+    return LEDMatrix::Color24bit(resultRed, resultGreen, resultBlue);
+}
+
+static int channelDifference(uint32_t color1, uint32_t color2, uint8_t shift){
+    return abs((int)((color1 >> shift) & 0xff) - (int)((color2 >> shift) & 0xff));
+}
+
+/**
+ * @brief Every factor (0..256) with every pair of channel values: the fixed point blend differs
+ * by at most 1 LSB from the float blend and is the correctly rounded result
+ *
+ */
+static void testInterpolateFixedMatchesFloat(){
+    unsigned long tooFar = 0;
+    unsigned long notRounded = 0;
+    unsigned long differing = 0;
+    for(uint16_t factor = 0; factor <= BLEND_FACTOR_ONE; factor++){
+        for(uint16_t a = 0; a < 256; a++){
+            for(uint16_t b = 0; b < 256; b++){
+                // each channel gets another combination of the pair, so all three lanes are covered
+                uint32_t color1 = LEDMatrix::Color24bit(a, b, a ^ 0x5a);
+                uint32_t color2 = LEDMatrix::Color24bit(b, a, 255 - b);
+                uint32_t fixed = LEDMatrix::interpolateColor24bitFixed(color1, color2, factor);
+                uint32_t reference = interpolateColor24bitFloat(color1, color2, factor / (float)BLEND_FACTOR_ONE);
+                for(uint8_t shift = 0; shift <= 16; shift += 8){
+                    int difference = channelDifference(fixed, reference, shift);
+                    if(difference > 1){
+                        tooFar++;
+                    }
+                    differing += difference != 0;
+                    // exact value of the blend, the fixed point result has to be the nearest integer
+                    double exact = ((color1 >> shift) & 0xff) + factor / 256.0 * ((double)((color2 >> shift) & 0xff) - ((color1 >> shift) & 0xff));
+                    if(fabs(((fixed >> shift) & 0xff) - exact) > 0.5){
+                        notRounded++;
+                    }
+                }
+                if((fixed & 0xff000000) != 0){
+                    tooFar++;
+                }
+            }
+        }
+    }
+    CHECK_EQUAL(tooFar, 0);
+    CHECK_EQUAL(notRounded, 0);
+    printf("fixed point blend: %lu of %lu channels differ by 1 LSB from the float blend\n", differing, 257UL * 65536 * 3);
+}
+
+static void testInterpolateFixedEnds(){
+    CHECK_EQUAL(LEDMatrix::interpolateColor24bitFixed(0x123456, 0xabcdef, 0), 0x123456);
+    CHECK_EQUAL(LEDMatrix::interpolateColor24bitFixed(0x123456, 0xabcdef, BLEND_FACTOR_ONE), 0xabcdef);
+    CHECK_EQUAL(LEDMatrix::interpolateColor24bitFixed(0x123456, 0xffabcdef, BLEND_FACTOR_ONE + 10), 0xabcdef);
+    CHECK_EQUAL(LEDMatrix::interpolateColor24bitFixed(0x000000, 0xffffff, 128), 0x808080);
+}
+
+/**
+ * @brief Gamma corrected value (gamma 2.25, 8 fractional bits) of a channel, scaled like the strip brightness
+ *
+ */
+static uint32_t gammaScaled(uint8_t value, uint16_t scale){
+    uint32_t corrected = (uint32_t)(pow(value / 255.0, 2.25) * 255 * 256 + 0.5);
+    return (corrected * scale) >> 8;
+}
+
+/**
+ * @brief Strip index of a led as calculated by Adafruit_NeoMatrix::drawPixel for
+ * NEO_MATRIX_TOP + NEO_MATRIX_LEFT + NEO_MATRIX_ROWS + NEO_MATRIX_ZIGZAG (row HEIGHT holds the minute indicators)
+ *
+ */
+static int neoMatrixIndex(int x, int y){
+    return y * WIDTH + ((y & 1) ? WIDTH - 1 - x : x);
+}
+
+/**
+ * @brief Every led is written with its full 24 bit color to the zigzag position in the strip buffer (GRB),
+ * gamma corrected, scaled by the brightness of the strip like Adafruit_NeoPixel::setPixelColor and rounded
+ *
+ */
+static void testDirectWriteLayout(){
+    for(int stripBrightness : {255, 127, 10}){
+        Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+        matrix.setBrightness(stripBrightness);
+        UDPLogger logger;
+        LEDMatrix ledmatrix(&matrix, stripBrightness, &logger);
+        for(uint8_t y = 0; y < HEIGHT; y++){
+            for(uint8_t x = 0; x < WIDTH; x++){
+                // low bits set in every channel, 565 colors would lose them
+                ledmatrix.gridAddPixel(x, y, LEDMatrix::Color24bit(x * 23 + 1, y * 23 + 2, x * y + 3));
+            }
+        }
+        ledmatrix.setMinIndicator(0x0f, LEDMatrix::Color24bit(7, 77, 177));
+        ledmatrix.drawOnMatrixInstant();
+
+        unsigned long wrong = 0;
+        auto expect = [&](int index, uint8_t red, uint8_t green, uint8_t blue){
+            uint16_t scale = stripBrightness + 1;
+            wrong += matrix.pixels[index * 3] != ((gammaScaled(green, scale) + 128) >> 8);
+            wrong += matrix.pixels[index * 3 + 1] != ((gammaScaled(red, scale) + 128) >> 8);
+            wrong += matrix.pixels[index * 3 + 2] != ((gammaScaled(blue, scale) + 128) >> 8);
+        };
+        for(uint8_t y = 0; y < HEIGHT; y++){
+            for(uint8_t x = 0; x < WIDTH; x++){
+                expect(neoMatrixIndex(x, y), x * 23 + 1, y * 23 + 2, x * y + 3);
+            }
+        }
+        // indicators at the right end of the last row, the rest of the row stays off
+        for(uint8_t x = 0; x < WIDTH; x++){
+            if(x >= WIDTH - NUM_INDICATORS){
+                expect(neoMatrixIndex(x, HEIGHT), 7, 77, 177);
+            }
+            else{
+                expect(neoMatrixIndex(x, HEIGHT), 0, 0, 0);
+            }
+        }
+        CHECK_EQUAL(wrong, 0);
+    }
+}
+
+/**
+ * @brief At low brightness the dithered values of 8 consecutive frames average to the gamma corrected value
+ * with its fractional part (1/8 resolution), without dithering the value is rounded and frames are skipped
+ *
+ */
+static void testTemporalDithering(){
+    const uint8_t stripBrightness = 10;
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    matrix.setBrightness(stripBrightness);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, stripBrightness, &logger);
+    ledmatrix.setDithering(true);
+    for(uint8_t x = 0; x < WIDTH; x++){
+        ledmatrix.gridAddPixel(x, 0, LEDMatrix::Color24bit(100 + x * 10, 255, x * 20));
+    }
+    unsigned int sums[WIDTH][3] = {{0}};
+    for(int frame = 0; frame < 8; frame++){
+        ledmatrix.drawOnMatrixInstant();
+        for(uint8_t x = 0; x < WIDTH; x++){
+            for(int c = 0; c < 3; c++){
+                sums[x][c] += matrix.pixels[neoMatrixIndex(x, 0) * 3 + c];
+            }
+        }
+    }
+    unsigned long wrong = 0;
+    for(uint8_t x = 0; x < WIDTH; x++){
+        const uint8_t channels[3] = {255, (uint8_t)(100 + x * 10), (uint8_t)(x * 20)};   // GRB
+        for(int c = 0; c < 3; c++){
+            double exact = gammaScaled(channels[c], stripBrightness + 1) / 256.0;
+            wrong += fabs(sums[x][c] / 8.0 - exact) > 1 / 8.0;
+        }
+    }
+    CHECK_EQUAL(wrong, 0);
+    // dithered frames are always drawn
+    CHECK_EQUAL(ledmatrix.getRenderedFrames(), 8);
+
+    ledmatrix.setDithering(false);
+    ledmatrix.drawOnMatrixInstant();
+    CHECK_EQUAL(matrix.pixels[neoMatrixIndex(1, 0) * 3 + 1], (gammaScaled(110, stripBrightness + 1) + 128) >> 8);
+    ledmatrix.drawOnMatrixInstant();
+    CHECK_EQUAL(ledmatrix.getSkippedFrames(), 1);
+}
+
+/**
+ * @brief A linear fade of 500 ms is halfway after 250 ms and finished after 500 ms, whether the frames
+ * are drawn every 10 ms, every 50 ms or with gaps of 125 and 250 ms
+ *
+ */
+static void testTransitionIndependentOfFrameRate(){
+    for(unsigned long period : {10UL, 50UL, 125UL, 250UL}){
+        Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+        UDPLogger logger;
+        LEDMatrix ledmatrix(&matrix, 255, &logger);
+        ledmatrix.setTransition(500, ease_linear);
+        fakeMillis = 10000;
+        ledmatrix.gridAddPixel(0, 0, 0xc80000);
+        for(unsigned long t = period; t <= 250; t += period){
+            fakeMillis = 10000 + t;
+            ledmatrix.drawOnMatrixSmooth();
+        }
+        // red at half the way from 0 to 200
+        CHECK_EQUAL(matrix.pixels[1], (gammaScaled(100, 256) + 128) >> 8);
+        fakeMillis = 10000 + 499;
+        ledmatrix.drawOnMatrixSmooth();
+        CHECK(matrix.pixels[1] < ((gammaScaled(200, 256) + 128) >> 8));
+        fakeMillis = 10000 + 500;
+        ledmatrix.drawOnMatrixSmooth();
+        CHECK_EQUAL(matrix.pixels[1], (gammaScaled(200, 256) + 128) >> 8);
+        // converged, the next frame is skipped
+        ledmatrix.drawOnMatrixSmooth();
+        CHECK_EQUAL(ledmatrix.getSkippedFrames(), 1);
+    }
+    fakeMillis = 0;
+}
+
+/**
+ * @brief Fill all leds (grid and minute indicators) with one color and return the estimated current
+ *
+ */
+static uint16_t estimateCurrentOfColor(uint32_t color, uint8_t brightness){
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, brightness, &logger);
+    for(uint8_t y = 0; y < HEIGHT; y++){
+        for(uint8_t x = 0; x < WIDTH; x++){
+            ledmatrix.gridAddPixel(x, y, color);
+        }
+    }
+    ledmatrix.setMinIndicator(0x0f, color);
+    ledmatrix.drawOnMatrixInstant();
+    return ledmatrix.getEstimatedCurrent();
+}
+
+/**
+ * @brief The current estimation follows the gamma corrected values which are sent to the leds
+ *
+ */
+static void testCurrentEstimationUsesGamma(){
+    // full white: gamma does not change 255
+    CHECK_EQUAL(estimateCurrentOfColor(0xffffff, 255), NUM_LEDS * 3 * LED_CURRENT_PER_CHANNEL);
+    CHECK_EQUAL(estimateCurrentOfColor(0x000000, 255), 0);
+
+    // 50% grey: (128/255)^2.25 * 255 = 54 per channel, not 128
+    uint8_t gray = (uint16_t)(pow(128 / 255.0, 2.25) * 255 * 256 + 0.5) >> 8;
+    CHECK_EQUAL(gray, 54);
+    uint32_t expected = NUM_LEDS * 3 * gray * LED_CURRENT_PER_CHANNEL / 255;
+    CHECK_EQUAL(estimateCurrentOfColor(0x808080, 255), expected);
+    CHECK_EQUAL(estimateCurrentOfColor(0x808080, 128), expected * 128 / 255);
+
+    // only red
+    uint8_t red = (uint16_t)(pow(200 / 255.0, 2.25) * 255 * 256 + 0.5) >> 8;
+    CHECK_EQUAL(estimateCurrentOfColor(0xc80000, 255), NUM_LEDS * red * LED_CURRENT_PER_CHANNEL / 255);
+}
+
+/**
+ * @brief A transition is finished if the next frame is drawn more than 65.5 s (16 bit of millis()) after its start
+ *
+ */
+static void testTransitionAfterLongPause(){
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, 255, &logger);
+    ledmatrix.setTransition(500, ease_linear);
+
+    fakeMillis = 1000;
+    ledmatrix.gridAddPixel(0, 0, 0xff0000);
+    fakeMillis = 1250;
+    ledmatrix.drawOnMatrixSmooth();
+    // halfway: red is on its way up, but not there yet
+    CHECK(matrix.pixels[1] > 0 && matrix.pixels[1] < 255);
+
+    // next frame after a pause of 65536 + 100 ms: the transition is over
+    fakeMillis = 1000 + 65536 + 100;
+    ledmatrix.drawOnMatrixSmooth();
+    CHECK_EQUAL(matrix.pixels[1], 255);
+
+    // transitions work across the overflow of millis()
+    fakeMillis = 0xffffff00UL;
+    ledmatrix.gridAddPixel(0, 0, 0x0000ff);
+    fakeMillis = 0xffffff00UL + 600;
+    ledmatrix.drawOnMatrixSmooth();
+    CHECK_EQUAL(matrix.pixels[1], 0);
+    CHECK_EQUAL(matrix.pixels[2], 255);
+    fakeMillis = 0;
+}
+
+/**
+ * @brief The clock flushes and redraws the grid every loop: a led which gets the same color again keeps its
+ * running transition, a converged led stays on its color and a changed color starts a new transition
+ *
+ */
+static void testFlushAndRedrawKeepsTransition(){
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, 255, &logger);
+    ledmatrix.setTransition(500, ease_linear);
+    fakeMillis = 10000;
+    ledmatrix.gridAddPixel(0, 0, 0xc80000);
+    for(unsigned long t = 10; t <= 500; t += 10){
+        fakeMillis = 10000 + t;
+        ledmatrix.gridFlush();
+        ledmatrix.gridAddPixel(0, 0, 0xc80000);
+        ledmatrix.drawOnMatrixSmooth();
+        if(t == 250){
+            CHECK_EQUAL(matrix.pixels[1], (gammaScaled(100, 256) + 128) >> 8);
+        }
+        if(t == 490){
+            CHECK(matrix.pixels[1] < ((gammaScaled(200, 256) + 128) >> 8));
+        }
+    }
+    CHECK_EQUAL(matrix.pixels[1], (gammaScaled(200, 256) + 128) >> 8);
+
+    // converged: flush and redraw do not change the led
+    fakeMillis = 10600;
+    ledmatrix.gridFlush();
+    ledmatrix.gridAddPixel(0, 0, 0xc80000);
+    ledmatrix.drawOnMatrixSmooth();
+    CHECK_EQUAL(matrix.pixels[1], (gammaScaled(200, 256) + 128) >> 8);
+
+    // a new color fades from the current one
+    ledmatrix.gridFlush();
+    ledmatrix.gridAddPixel(0, 0, 0x000000);
+    fakeMillis = 10600 + 250;
+    ledmatrix.drawOnMatrixSmooth();
+    CHECK_EQUAL(matrix.pixels[1], (gammaScaled(100, 256) + 128) >> 8);
+    fakeMillis = 0;
+}
+
+static void benchInterpolate(){
+    const uint32_t colors[8] = {0x000000, 0xffffff, 0xff0000, 0x00ff00, 0x0000ff, 0x123456, 0xc8c800, 0x80c8ff};
+    double fixedTime = benchNanoseconds(10000000, [&](unsigned long i){
+        benchSink += LEDMatrix::interpolateColor24bitFixed(colors[i & 7] ^ benchSink, colors[(i >> 3) & 7], i & 0xff);
+    });
+    double floatTime = benchNanoseconds(10000000, [&](unsigned long i){
+        benchSink += interpolateColor24bitFloat(colors[i & 7] ^ benchSink, colors[(i >> 3) & 7], (i & 0xff) / 256.0f);
+    });
+    printf("bench interpolateColor24bit: fixed %.2f ns, float %.2f ns per call (host)\n", fixedTime, floatTime);
+}
+
+int main(int argc, char **argv){
+    testInterpolateFixedEnds();
+    testInterpolateFixedMatchesFloat();
+    testDirectWriteLayout();
+    testTemporalDithering();
+    testTransitionIndependentOfFrameRate();
+    testCurrentEstimationUsesGamma();
+    testTransitionAfterLongPause();
+    testFlushAndRedrawKeepsTransition();
+    if(benchRequested(argc, argv)){
+        benchInterpolate();
+    }
+    return testSummary("test_ledmatrix");
+}
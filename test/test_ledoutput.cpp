@@ -0,0 +1,219 @@
+/**
+ * @file test_ledoutput.cpp
+ * @brief Host tests of the LED output drivers (frame buffers, UART1 encoding) and their use by LEDMatrix
+ *
+ */
+
+#include "testing.h"
+#include <vector>
+#include <ets_sys.h>
+#include <esp8266_peri.h>
+#include "ledoutput.h"
+#include "ledmatrix.h"
+
+/**
+ * @brief Output driver which records the frames passed to show()
+ *
+ */
+class RecordingOutput : public LEDOutput{
+    public:
+        void begin(){ begun = true; }
+        void show(const uint8_t *pixels, uint16_t numBytes){ frames.emplace_back(pixels, pixels + numBytes); }
+        void loop() {}
+        bool isBusy(){ return false; }
+
+        bool begun = false;
+        std::vector<std::vector<uint8_t>> frames;
+};
+
+/**
+ * @brief Line level of the 8 bit times of one UART byte: start bit, 6 data bits (LSB first), stop bit, TX inverted
+ *
+ */
+static void uartLineLevels(uint8_t value, bool levels[8]){
+    levels[0] = true;
+    for(uint8_t i = 0; i < 6; i++){
+        levels[1 + i] = !((value >> i) & 1);
+    }
+    levels[7] = false;
+}
+
+/**
+ * @brief Decode the NeoPixel bits from the waveform of the UART bytes: 4 bit times per NeoPixel bit,
+ * high-low-low-low (0.31 us high) is a 0, high-high-high-low (0.94 us high) is a 1
+ *
+ * @return std::vector<uint8_t> decoded bytes, empty if a bit has no valid waveform
+ */
+static std::vector<uint8_t> decodeNeoPixelBits(const std::vector<uint8_t> &uartBytes){
+    std::vector<uint8_t> result;
+    uint8_t value = 0;
+    uint8_t bits = 0;
+    for(uint8_t uartByte : uartBytes){
+        bool levels[8];
+        uartLineLevels(uartByte, levels);
+        for(uint8_t half = 0; half < 2; half++){
+            const bool *l = &levels[half * 4];
+            if(!l[0] || l[3] || l[1] != l[2]){
+                return std::vector<uint8_t>();
+            }
+            value = (value << 1) | l[1];
+            if(++bits == 8){
+                result.push_back(value);
+                value = 0;
+                bits = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static void testFrameBuffersSwap(){
+    LEDFrameBuffers frames;
+    uint8_t first[6] = {1, 2, 3, 4, 5, 6};
+    uint8_t second[3] = {7, 8, 9};
+
+    CHECK(!frames.isPending());
+    CHECK(!frames.swap());
+
+    frames.store(first, sizeof(first));
+    CHECK(frames.isPending());
+    // not visible to the transmitter before the swap
+    CHECK_EQUAL(frames.frontLength(), 0);
+    CHECK(frames.swap());
+    CHECK(!frames.isPending());
+    CHECK_EQUAL(frames.frontLength(), 6);
+    CHECK(memcmp(frames.front(), first, 6) == 0);
+
+    // a new frame goes to the other buffer, the front buffer stays unchanged while it is sent
+    const uint8_t *sending = frames.front();
+    frames.store(second, sizeof(second));
+    CHECK(frames.front() == sending);
+    CHECK(memcmp(frames.front(), first, 6) == 0);
+    CHECK(frames.swap());
+    CHECK(frames.front() != sending);
+    CHECK_EQUAL(frames.frontLength(), 3);
+    CHECK(memcmp(frames.front(), second, 3) == 0);
+    CHECK(!frames.swap());
+
+    // several frames before a swap: only the last one is sent
+    frames.store(first, sizeof(first));
+    frames.store(second, sizeof(second));
+    CHECK(frames.swap());
+    CHECK_EQUAL(frames.frontLength(), 3);
+    CHECK(memcmp(frames.front(), second, 3) == 0);
+
+    // frames longer than the buffer are cut
+    static uint8_t large[LEDOUTPUT_MAX_FRAME_BYTES + 10];
+    frames.store(large, sizeof(large));
+    CHECK(frames.swap());
+    CHECK_EQUAL(frames.frontLength(), LEDOUTPUT_MAX_FRAME_BYTES);
+}
+
+static void testUARTEncodingOfKnownPattern(){
+    // GRB of three leds: green, red, blue and a mixed color, every 2 bit combination occurs
+    const uint8_t pattern[12] = {0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff, 0x1b, 0xe4, 0xa5};
+    UART1Output output;
+    mockUARTFifo[1] = MockUARTFifo();
+    output.begin();
+    CHECK(mockUARTHandler != nullptr);
+    CHECK_EQUAL(mockUARTRegs[1].USD, ESP8266_CLOCK / 3200000);
+
+    fakeMicros = 10000;
+    output.show(pattern, sizeof(pattern));
+    // 4 UART bytes per NeoPixel byte, all fit into the FIFO at once
+    CHECK_EQUAL(mockUARTFifo[1].bytes.size(), sizeof(pattern) * 4);
+    // 0x1b = 00 01 10 11 -> the four entries of the encoding table
+    const uint8_t expected[4] = {0b110111, 0b000111, 0b110100, 0b000100};
+    CHECK(memcmp(&mockUARTFifo[1].bytes[9 * 4], expected, 4) == 0);
+    std::vector<uint8_t> decoded = decodeNeoPixelBits(mockUARTFifo[1].bytes);
+    CHECK(decoded == std::vector<uint8_t>(pattern, pattern + sizeof(pattern)));
+    CHECK(!output.isBusy());
+}
+
+static void testUARTRefillAndDoubleBuffer(){
+    UART1Output output;
+    mockUARTFifo[1] = MockUARTFifo();
+    output.begin();
+    uint8_t frame1[(WIDTH * HEIGHT + NUM_INDICATORS) * 3];
+    uint8_t frame2[(WIDTH * HEIGHT + NUM_INDICATORS) * 3];
+    for(uint16_t i = 0; i < sizeof(frame1); i++){
+        frame1[i] = i;
+        frame2[i] = 255 - i;
+    }
+
+    fakeMicros = 100000;
+    output.show(frame1, sizeof(frame1));
+    // FIFO (128 bytes) is full after 32 pixel bytes, the rest is sent from the interrupt
+    CHECK_EQUAL(mockUARTFifo[1].bytes.size(), 128);
+    CHECK(output.isBusy());
+    CHECK(mockUARTRegs[1].USIE & (1 << UIFE));
+
+    // next frame while sending: stored in the back buffer, the frame in progress is not changed
+    output.show(frame2, sizeof(frame2));
+    CHECK(output.isBusy());
+
+    int interrupts = 0;
+    while((mockUARTRegs[1].USIE & (1 << UIFE)) && interrupts < 100){
+        mockUARTFifo[1].level = 0;
+        mockUARTRegs[1].USIS = 1 << UIFE;
+        mockUARTHandler(mockUARTHandlerArg);
+        interrupts++;
+    }
+    CHECK_EQUAL(interrupts, (sizeof(frame1) * 4 + 127) / 128 - 1);
+    CHECK(decodeNeoPixelBits(mockUARTFifo[1].bytes) == std::vector<uint8_t>(frame1, frame1 + sizeof(frame1)));
+
+    // second frame starts only after the latch time of the leds
+    CHECK(output.isBusy());
+    mockUARTFifo[1] = MockUARTFifo();
+    output.loop();
+    CHECK(mockUARTFifo[1].bytes.empty());
+    fakeMicros += UART1OUTPUT_LATCH_US;
+    output.loop();
+    CHECK_EQUAL(mockUARTFifo[1].bytes.size(), 128);
+    while(mockUARTRegs[1].USIE & (1 << UIFE)){
+        mockUARTFifo[1].level = 0;
+        mockUARTRegs[1].USIS = 1 << UIFE;
+        mockUARTHandler(mockUARTHandlerArg);
+    }
+    CHECK(decodeNeoPixelBits(mockUARTFifo[1].bytes) == std::vector<uint8_t>(frame2, frame2 + sizeof(frame2)));
+    CHECK(!output.isBusy());
+}
+
+static void testLEDMatrixUsesOutput(){
+    Adafruit_NeoMatrix matrix(11, 12, 2, 0, 0);
+    UDPLogger logger;
+    LEDMatrix ledmatrix(&matrix, 255, &logger);
+    RecordingOutput output;
+    ledmatrix.setOutput(&output);
+    CHECK(output.begun);
+
+    ledmatrix.gridAddPixel(0, 0, 0xff0000);
+    ledmatrix.gridAddPixel(10, 1, 0x0000ff);
+    ledmatrix.drawOnMatrixInstant();
+    CHECK_EQUAL(output.frames.size(), 1);
+    CHECK_EQUAL(matrix.shows, 0);
+    CHECK_EQUAL(output.frames[0].size(), MOCK_NEOPIXEL_COUNT * 3);
+    // GRB, second row runs from right to left
+    const uint8_t red[3] = {0, 255, 0};
+    const uint8_t blue[3] = {0, 0, 255};
+    CHECK(memcmp(&output.frames[0][0], red, 3) == 0);
+    CHECK(memcmp(&output.frames[0][11 * 3], blue, 3) == 0);
+
+    // unchanged frame is not sent again
+    ledmatrix.drawOnMatrixInstant();
+    CHECK_EQUAL(output.frames.size(), 1);
+
+    // without driver the strip is sent by the library
+    ledmatrix.setOutput(nullptr);
+    ledmatrix.drawOnMatrixInstant();
+    CHECK_EQUAL(output.frames.size(), 1);
+    CHECK_EQUAL(matrix.shows, 1);
+}
+
+int main(int argc, char **argv){
+    testFrameBuffersSwap();
+    testUARTEncodingOfKnownPattern();
+    testUARTRefillAndDoubleBuffer();
+    testLEDMatrixUsesOutput();
+    return testSummary("test_ledoutput");
+}
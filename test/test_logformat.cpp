@@ -0,0 +1,62 @@
+/**
+ * @file test_logformat.cpp
+ * @brief Host tests of the conversion parser of the binary log protocol
+ *
+ */
+
+#include "testing.h"
+#include <string.h>
+#include "logformat.h"
+
+static LogFormatSpec parse(const char *specification){
+    return parseLogFormatSpec([specification](uint8_t index){ return specification[index]; });
+}
+
+/**
+ * @brief Length, argument type and '*' arguments of the specifications used by the sketch and of corner cases
+ *
+ */
+static void testParseSpecifications(){
+    struct {
+        const char *specification;
+        uint8_t length;
+        LogArgType type;
+        uint8_t starArgs;
+    } cases[] = {
+        {"%d", 2, arg_int32, 0},
+        {"%-5lu ms", 5, arg_int32, 0},
+        {"%02X:", 4, arg_int32, 0},
+        {"%lld", 4, arg_int64, 0},
+        {"%llu", 4, arg_int64, 0},
+        {"%c", 2, arg_int32, 0},
+        {"%p", 2, arg_int32, 0},
+        {"%.2f", 4, arg_float, 0},
+        {"%+8.3e", 6, arg_float, 0},
+        {"%s", 2, arg_string, 0},
+        {"%-*.*s|", 6, arg_string, 2},
+        {"%*d", 3, arg_int32, 1},
+        {"%zu", 3, arg_int32, 0},
+        {"%hhx", 4, arg_int32, 0},
+        {"%%", 2, arg_none, 0},
+        {"%k", 2, arg_none, 0},
+        {"%-*", 3, arg_none, 0},
+        {"%", 1, arg_none, 0},
+    };
+    unsigned long wrong = 0;
+    for(auto &c : cases){
+        LogFormatSpec spec = parse(c.specification);
+        if(spec.length != c.length || spec.type != c.type || spec.starArgs != c.starArgs){
+            printf("%s: length %d, type %d, star arguments %d\n", c.specification, spec.length, spec.type, spec.starArgs);
+            wrong++;
+        }
+    }
+    CHECK_EQUAL(wrong, 0);
+    CHECK_EQUAL(parse("%-5lu").conversion, 'u');
+    CHECK_EQUAL(parse("%-5lu").longs, 1);
+    CHECK_EQUAL(parse("%5").conversion, '\0');
+}
+
+int main(int argc, char **argv){
+    testParseSpecifications();
+    return testSummary("test_logformat");
+}
@@ -0,0 +1,366 @@
+/**
+ * @file test_ntp.cpp
+ * @brief Host tests of the NTP exchange of NTPClientPlus (requestNTP(), pollNTP(), handleNTPPacket())
+ * with a scripted fake UDP transport and server
+ *
+ */
+
+#include "testing.h"
+#include <deque>
+#include <vector>
+#include <WiFiUdp.h>
+#include <ESP8266WiFi.h>
+#include "ntp_client_plus.h"
+
+/**
+ * @brief Access to the state of the update of NTPClientPlus (friend of the class)
+ *
+ */
+class NTPClientPlusTest{
+    public:
+        static bool synchronized(const NTPClientPlus &ntp){ return ntp._synchronized; }
+        static uint8_t samplesReceived(const NTPClientPlus &ntp){ return ntp._samplesReceived; }
+};
+
+// 14. Nov. 2023, 22:13:20 UTC in ms since 1900
+static const uint64_t serverStart = (SEVENZYYEARS + 1700000000ULL) * 1000;
+
+enum ServerAction {answer, drop, foreignNonce, kissOfDeath, shortPacket};
+
+/**
+ * @brief How the server handles one request: delays of both directions and the answer
+ *
+ */
+struct ServerStep {
+    ServerAction action;
+    unsigned long uplink;       // ms from the request to the server
+    unsigned long downlink;     // ms from the server back to the client
+};
+
+/**
+ * @brief UDP transport with an NTP server: each sent request is answered following the script,
+ * the answers are delivered when fakeMillis reaches their arrival time
+ *
+ */
+class FakeNTPServer : public UDP{
+    public:
+        // time of the server clock at fakeMillis = 0
+        uint64_t serverBase = serverStart;
+        std::deque<ServerStep> script;
+        std::vector<std::vector<uint8_t>> requests;
+        // destination of each request (0.0.0.0 if sent to a host name)
+        std::vector<uint32_t> addresses;
+
+        uint8_t begin(uint16_t port){ return 1; }
+        void stop() {}
+        int beginPacket(IPAddress ip, uint16_t port){ requests.emplace_back(); addresses.push_back(ip); return 1; }
+        int beginPacket(const char *host, uint16_t port){ requests.emplace_back(); addresses.push_back(0); return 1; }
+        int endPacket(){
+            ServerStep step = {drop, 0, 0};
+            if(!script.empty()){
+                step = script.front();
+                script.pop_front();
+            }
+            if(step.action != drop){
+                deliver(fakeMillis + step.uplink + step.downlink, answerTo(requests.back(), step, fakeMillis + step.uplink));
+            }
+            return 1;
+        }
+        size_t write(uint8_t c){ return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size){
+            requests.back().insert(requests.back().end(), buffer, buffer + size);
+            return size;
+        }
+        int parsePacket(){
+            _current.clear();
+            if(_inbox.empty() || _inbox.front().first > fakeMillis){
+                return 0;
+            }
+            _current = _inbox.front().second;
+            _inbox.pop_front();
+            return _current.size();
+        }
+        int available(){ return _current.size(); }
+        int read(){ return -1; }
+        int read(unsigned char *buffer, size_t len){
+            size_t size = min(len, _current.size());
+            memcpy(buffer, _current.data(), size);
+            _current.clear();
+            return size;
+        }
+        int peek(){ return -1; }
+        void flush(){ _current.clear(); }
+        IPAddress remoteIP(){ return IPAddress(); }
+        uint16_t remotePort(){ return 123; }
+
+        /**
+         * @brief Answer of the server, received and sent at the same time (T2 = T3)
+         *
+         */
+        std::vector<uint8_t> answerTo(const std::vector<uint8_t> &request, const ServerStep &step, unsigned long serverMillis){
+            std::vector<uint8_t> packet(NTP_PACKET_SIZE, 0);
+            packet[0] = 0x24;       // version 4, mode 4 (server)
+            packet[1] = step.action == kissOfDeath ? 0 : 2;
+            memcpy(&packet[24], &request[40], 8);
+            if(step.action == foreignNonce){
+                packet[31] ^= 0x01;
+            }
+            uint64_t time = serverBase + serverMillis;
+            writeTimestamp(&packet[32], time);
+            writeTimestamp(&packet[40], time);
+            if(step.action == shortPacket){
+                packet.resize(NTP_PACKET_SIZE / 2);
+            }
+            return packet;
+        }
+
+        void deliver(unsigned long at, const std::vector<uint8_t> &packet){
+            auto position = _inbox.begin();
+            while(position != _inbox.end() && position->first <= at){
+                position++;
+            }
+            _inbox.insert(position, std::make_pair(at, packet));
+        }
+
+        size_t pendingPackets() const { return _inbox.size(); }
+
+    private:
+        std::deque<std::pair<unsigned long, std::vector<uint8_t>>> _inbox;
+        std::vector<uint8_t> _current;
+
+        // fraction rounded up, so ntpTimestampToMillis() returns exactly the ms
+        static void writeTimestamp(uint8_t *timestamp, uint64_t millis){
+            uint32_t seconds = millis / 1000;
+            uint32_t fraction = (((millis % 1000) << 32) + 999) / 1000;
+            for(int i = 0; i < 4; i++){
+                timestamp[i] = seconds >> (24 - 8 * i);
+                timestamp[4 + i] = fraction >> (24 - 8 * i);
+            }
+        }
+};
+
+/**
+ * @brief Call pollNTP() every ms (micros() follows) until the update is finished
+ *
+ */
+static int pollUntilDone(NTPClientPlus &ntp, unsigned long *duration = nullptr){
+    unsigned long start = fakeMillis;
+    int result;
+    while((result = ntp.pollNTP()) == NTP_UPDATE_PENDING && fakeMillis - start < 60000){
+        fakeMillis++;
+        fakeMicros = fakeMillis * 1000 + 7;
+    }
+    if(duration != nullptr){
+        *duration = fakeMillis - start;
+    }
+    return result;
+}
+
+static void startClock(){
+    fakeMillis = 1000;
+    fakeMicros = fakeMillis * 1000;
+}
+
+/**
+ * @brief First update sets the clock, the client has to wait the round trip
+ *
+ */
+static void testSingleAnswer(){
+    startClock();
+    FakeNTPServer server;
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+    server.script.push_back({answer, 15, 15});
+    ntp.requestNTP(1);
+    CHECK(ntp.isUpdatePending());
+    unsigned long duration;
+    CHECK_EQUAL(pollUntilDone(ntp, &duration), NTP_UPDATE_SUCCESS);
+    CHECK_EQUAL(duration, 30);
+    CHECK(!ntp.isUpdatePending());
+    // symmetric delays: the offset is exact
+    CHECK_EQUAL(ntp.getMillisSince1900(), server.serverBase + fakeMillis);
+    CHECK_EQUAL(ntp.getLastDelay(), 30);
+    CHECK_EQUAL(ntp.getEpochTime(), 1700000000UL + fakeMillis / 1000);
+    // request in client mode with the transmit timestamp as nonce
+    CHECK_EQUAL(server.requests.size(), 1);
+    CHECK_EQUAL(server.requests[0].size(), NTP_PACKET_SIZE);
+    CHECK_EQUAL(server.requests[0][0] & 0x07, 3);
+
+    // no update started
+    CHECK_EQUAL(ntp.pollNTP(), NTP_UPDATE_PENDING);
+    CHECK(!ntp.isUpdatePending());
+}
+
+/**
+ * @brief No answer within NTP_TIMEOUT, short packets and kiss-o'-death
+ *
+ */
+static void testTimeoutAndInvalidAnswers(){
+    startClock();
+    FakeNTPServer server;
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+
+    server.script.push_back({drop, 0, 0});
+    ntp.requestNTP(1);
+    unsigned long duration;
+    CHECK_EQUAL(pollUntilDone(ntp, &duration), NTP_UPDATE_TIMEOUT);
+    CHECK_EQUAL(duration, NTP_TIMEOUT + 1);
+    CHECK(!ntp.isUpdatePending());
+    CHECK(!NTPClientPlusTest::synchronized(ntp));
+
+    // answer later than NTP_TIMEOUT counts as lost
+    server.script.push_back({answer, 600, 600});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_TIMEOUT);
+
+    // a short packet is ignored like a foreign one
+    server.script.push_back({shortPacket, 5, 5});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_TIMEOUT);
+
+    // stratum 0: the server refuses to answer (e.g. rate limit)
+    server.script.push_back({kissOfDeath, 5, 5});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_INVALID);
+    CHECK(!ntp.isUpdatePending());
+    CHECK(!NTPClientPlusTest::synchronized(ntp));
+}
+
+/**
+ * @brief Answers whose originate timestamp does not match the current request are ignored
+ *
+ */
+static void testNonMatchingAnswers(){
+    startClock();
+    FakeNTPServer server;
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+
+    // originate timestamp differs from the sent transmit timestamp (e.g. spoofed answer), then the real answer
+    server.script.push_back({foreignNonce, 5, 5});
+    ntp.requestNTP(1);
+    server.deliver(fakeMillis + 20, server.answerTo(server.requests.back(), {answer, 10, 10}, fakeMillis + 10));
+    unsigned long duration;
+    CHECK_EQUAL(pollUntilDone(ntp, &duration), NTP_UPDATE_SUCCESS);
+    CHECK_EQUAL(duration, 20);
+    CHECK_EQUAL(NTPClientPlusTest::samplesReceived(ntp), 1);
+    CHECK_EQUAL(ntp.getMillisSince1900(), server.serverBase + fakeMillis);
+}
+
+/**
+ * @brief A late answer of an earlier request (stale nonce) must not be taken for the answer of the current one
+ *
+ */
+static void testStaleNonce(){
+    startClock();
+    FakeNTPServer server;
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+    server.script.push_back({answer, 0, 0});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_SUCCESS);
+
+    // the answer of this request arrives after the timeout
+    fakeMillis += 64000;
+    fakeMicros = fakeMillis * 1000 + 3;
+    server.script.push_back({answer, 1500, 1500});
+    ntp.requestNTP(1);
+    std::vector<uint8_t> lateRequest = server.requests.back();
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_TIMEOUT);
+    CHECK_EQUAL(server.pendingPackets(), 1);
+
+    // meanwhile the server clock has jumped by 10 s: the stale answer would step the clock by 10 s
+    server.serverBase += 10000;
+    fakeMillis += 64000;
+    fakeMicros = fakeMillis * 1000 + 5;
+    server.script.push_back({answer, 10, 10});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(server.pendingPackets(), 1);
+    server.deliver(fakeMillis + 5, server.answerTo(lateRequest, {answer, 0, 0}, fakeMillis));
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_SUCCESS);
+    CHECK_EQUAL(NTPClientPlusTest::samplesReceived(ntp), 1);
+    CHECK_EQUAL(ntp.getMillisSince1900(), server.serverBase + fakeMillis);
+    CHECK_EQUAL(ntp.getLastOffset(), 10000);
+
+    // stale packets in the receive buffer are discarded when a request is sent
+    server.deliver(fakeMillis, server.answerTo(lateRequest, {answer, 0, 0}, fakeMillis));
+    fakeMillis += 64000;
+    fakeMicros = fakeMillis * 1000 + 9;
+    ntp.requestNTP(1);
+    CHECK_EQUAL(server.pendingPackets(), 0);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_TIMEOUT);
+}
+
+/**
+ * @brief A burst with asymmetric network delays: the answer with the shortest round trip is used,
+ * its offset ((uplink - downlink) / 2 away from the true offset) is the least distorted
+ *
+ */
+static void testBurstUsesLowestDelay(){
+    static const ServerStep bursts[2][4] = {
+        {{answer, 100, 20}, {drop, 0, 0}, {answer, 10, 12}, {answer, 5, 60}},
+        {{answer, 5, 60}, {answer, 10, 12}, {answer, 100, 20}, {drop, 0, 0}},
+    };
+    for(const auto &burst : bursts){
+        startClock();
+        FakeNTPServer server;
+        NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+        server.script.push_back({answer, 0, 0});
+        ntp.requestNTP(1);
+        CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_SUCCESS);
+
+        // the server clock is 20 ms ahead of the local clock
+        fakeMillis += 64000;
+        server.serverBase += 20;
+        // offsets 20 + 40, 20 - 1 and 20 - 27, round trip delays 120, 22 and 65
+        server.script.insert(server.script.end(), burst, burst + 4);
+        ntp.requestNTP(4);
+        unsigned long duration;
+        CHECK_EQUAL(pollUntilDone(ntp, &duration), NTP_UPDATE_SUCCESS);
+        CHECK_EQUAL(server.requests.size(), 5);
+        CHECK_EQUAL(NTPClientPlusTest::samplesReceived(ntp), 3);
+        // the update ends after the answer (or the timeout) of the last request
+        CHECK(duration > 3 * NTP_BURST_INTERVAL);
+        CHECK_EQUAL(ntp.getLastDelay(), 22);
+        CHECK_EQUAL(ntp.getLastOffset(), 19);
+        CHECK_EQUAL(ntp.getMillisSince1900(), server.serverBase + fakeMillis - 1);
+        // small offset: the poll interval is doubled
+        CHECK_EQUAL(ntp.getPollInterval(), 2 * NTP_MIN_POLL_INTERVAL);
+    }
+}
+
+/**
+ * @brief The server name is resolved once per update, all requests of a burst go to the address.
+ * A failed lookup keeps the address of the previous update
+ *
+ */
+static void testServerResolvedOncePerUpdate(){
+    startClock();
+    FakeNTPServer server;
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+    WiFi.lookups = 0;
+    server.script.insert(server.script.end(), 4, {answer, 10, 10});
+    ntp.requestNTP(4);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_SUCCESS);
+    CHECK_EQUAL(WiFi.lookups, 1);
+    CHECK_EQUAL(server.addresses.size(), 4);
+    for(uint32_t address : server.addresses){
+        CHECK_EQUAL(address, (uint32_t)IPAddress(192, 0, 2, 123));
+    }
+
+    fakeMillis += 64000;
+    WiFi.resolvable = false;
+    server.script.push_back({answer, 10, 10});
+    ntp.requestNTP(1);
+    CHECK_EQUAL(pollUntilDone(ntp), NTP_UPDATE_SUCCESS);
+    CHECK_EQUAL(WiFi.lookups, 2);
+    CHECK_EQUAL(server.addresses.back(), (uint32_t)IPAddress(192, 0, 2, 123));
+    WiFi.resolvable = true;
+}
+
+int main(int argc, char **argv){
+    testSingleAnswer();
+    testTimeoutAndInvalidAnswers();
+    testNonMatchingAnswers();
+    testStaleNonce();
+    testBurstUsesLowestDelay();
+    testServerResolvedOncePerUpdate();
+    return testSummary("test_ntp");
+}
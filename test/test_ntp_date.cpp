@@ -0,0 +1,207 @@
+/**
+ * @file test_ntp_date.cpp
+ * @brief Host tests of the date calculation of NTPClientPlus (civilFromDays(), calcDate(), getMonth())
+ * against gmtime_r() of the host for every day from 1970 to 2106
+ *
+ */
+
+#include "testing.h"
+#include <time.h>
+#include <WiFiUdp.h>
+#include "ntp_client_plus.h"
+
+// last day which fits into a 32 bit unix time (7. Feb. 2106)
+static const long lastDay = 0xffffffffUL / 86400;
+
+static struct tm utcDate(long days){
+    time_t t = (time_t)days * 86400;
+    struct tm date;
+    gmtime_r(&t, &date);
+    return date;
+}
+
+/**
+ * @brief Access to the clock state and the private date calculation of NTPClientPlus (friend of the class)
+ *
+ */
+class NTPClientPlusTest{
+    public:
+        /**
+         * @brief Set the local clock of the client to a time of a day (UTC, no time zone)
+         *
+         */
+        static void setClockToDay(NTPClientPlus &ntp, long days, unsigned long secondsIntoDay){
+            ntp._baseMillis = ((uint64_t)SEVENZYYEARS + (uint64_t)days * 86400 + secondsIntoDay) * 1000;
+            ntp._lastUpdate = millis();
+            ntp._drift = 0;
+        }
+
+        static void advanceDay(NTPClientPlus &ntp){
+            ntp._baseMillis += 86400000;
+        }
+
+        static void civilFromDays(long days, unsigned int &year, unsigned int &month, unsigned int &day){
+            NTPClientPlus::civilFromDays(days, year, month, day);
+        }
+
+        static unsigned int year(const NTPClientPlus &ntp){ return ntp._dateYear; }
+        static unsigned int month(const NTPClientPlus &ntp){ return ntp._dateMonth; }
+        static unsigned int day(const NTPClientPlus &ntp){ return ntp._dateDay; }
+};
+
+static void setClockToDay(NTPClientPlus &ntp, long days, unsigned long secondsIntoDay){
+    NTPClientPlusTest::setClockToDay(ntp, days, secondsIntoDay);
+}
+
+static void testCivilFromDaysMatchesGmtime(){
+    unsigned long errors = 0;
+    for(long days = 0; days <= lastDay; days++){
+        struct tm date = utcDate(days);
+        unsigned int year, month, day;
+        NTPClientPlusTest::civilFromDays(days, year, month, day);
+        if(year != (unsigned)date.tm_year + 1900 || month != (unsigned)date.tm_mon + 1 || day != (unsigned)date.tm_mday){
+            if(errors++ < 5){
+                printf("day %ld: %04u-%02u-%02u, gmtime %04d-%02d-%02d\n", days, year, month, day, date.tm_year + 1900, date.tm_mon + 1, date.tm_mday);
+            }
+        }
+    }
+    CHECK_EQUAL(errors, 0);
+}
+
+/**
+ * @brief calcDate(), getYear(), getDayOfWeek() and getMonth() for every day, at noon
+ *
+ */
+static void testCalcDateMatchesGmtime(){
+    WiFiUDP udp;
+    NTPClientPlus ntp(udp, "pool.ntp.org", 0, false);
+    unsigned long errors = 0;
+    for(long days = 0; days <= lastDay; days++){
+        struct tm date = utcDate(days);
+        setClockToDay(ntp, days, 12 * 3600);
+        ntp.calcDate();
+        unsigned int weekday = date.tm_wday == 0 ? 7 : date.tm_wday;
+        if(NTPClientPlusTest::year(ntp) != (unsigned)date.tm_year + 1900 || NTPClientPlusTest::month(ntp) != (unsigned)date.tm_mon + 1 || NTPClientPlusTest::day(ntp) != (unsigned)date.tm_mday
+           || ntp.getDayOfWeek() != weekday || ntp.getYear() != (unsigned)date.tm_year + 1900 || ntp.getMonth(date.tm_yday + 1) != date.tm_mon + 1){
+            if(errors++ < 5){
+                printf("day %ld: %04u-%02u-%02u weekday %u, gmtime %04d-%02d-%02d weekday %u\n", days, NTPClientPlusTest::year(ntp), NTPClientPlusTest::month(ntp), NTPClientPlusTest::day(ntp),
+                       ntp.getDayOfWeek(), date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, weekday);
+            }
+        }
+    }
+    CHECK_EQUAL(errors, 0);
+}
+
+/**
+ * @brief Leap years, month ends and the boundaries of the epoch, also at the first and last second of the day
+ *
+ */
+static void testEdgeCases(){
+    struct DateCase {
+        long days;
+        unsigned int year, month, day, weekday;
+    };
+    static const DateCase cases[] = {
+        {0, 1970, 1, 1, 4},             // start of the unix epoch, thursday
+        {789, 1972, 2, 29, 2},          // first leap day after 1970
+        {790, 1972, 3, 1, 3},
+        {10956, 1999, 12, 31, 5},
+        {11016, 2000, 2, 29, 2},        // divisible by 400 -> leap year
+        {11017, 2000, 3, 1, 3},
+        {11322, 2000, 12, 31, 7},       // day 366 of a leap year
+        {24855, 2038, 1, 19, 2},        // last day of a signed 32 bit unix time
+        {47540, 2100, 2, 28, 7},        // divisible by 100 -> no leap year
+        {47541, 2100, 3, 1, 1},
+        {49710, 2106, 2, 7, 7},         // last day of an unsigned 32 bit unix time
+    };
+    WiFiUDP udp;
+    NTPClientPlus ntp(udp, "pool.ntp.org", 0, false);
+    for(const DateCase &c : cases){
+        for(unsigned long seconds : {0UL, 86399UL}){
+            setClockToDay(ntp, c.days, seconds);
+            ntp.calcDate();
+            CHECK_EQUAL(NTPClientPlusTest::year(ntp), c.year);
+            CHECK_EQUAL(NTPClientPlusTest::month(ntp), c.month);
+            CHECK_EQUAL(NTPClientPlusTest::day(ntp), c.day);
+            CHECK_EQUAL(ntp.getDayOfWeek(), c.weekday);
+        }
+    }
+
+    // days before 1970 (civilFromDays accepts negative days)
+    unsigned int year, month, day;
+    NTPClientPlusTest::civilFromDays(-1, year, month, day);
+    CHECK(year == 1969 && month == 12 && day == 31);
+    NTPClientPlusTest::civilFromDays(-25567, year, month, day);
+    CHECK(year == 1900 && month == 1 && day == 1);
+
+    // getMonth() of the current year: last day of february and invalid days
+    setClockToDay(ntp, 11016, 0);
+    CHECK_EQUAL(ntp.getMonth(60), 2);
+    CHECK_EQUAL(ntp.getMonth(61), 3);
+    CHECK_EQUAL(ntp.getMonth(366), 12);
+    CHECK_EQUAL(ntp.getMonth(0), 0);
+    CHECK_EQUAL(ntp.getMonth(367), 0);
+    setClockToDay(ntp, 47540, 0);
+    CHECK_EQUAL(ntp.getMonth(59), 2);
+    CHECK_EQUAL(ntp.getMonth(60), 3);
+    CHECK_EQUAL(ntp.getMonth(366), 0);
+
+    CHECK(ntp.isLeapYear(2000));
+    CHECK(ntp.isLeapYear(2024));
+    CHECK(!ntp.isLeapYear(2100));
+    CHECK(!ntp.isLeapYear(2023));
+
+    CHECK(strcmp(ntp.getFormattedDate().c_str(), "28.02.2100") == 0);
+}
+
+/**
+ * @brief Year and weekday as calculated before civilFromDays(): one loop iteration per day since 1900
+ *
+ */
+static unsigned int yearByCountingDays(unsigned long days1900, unsigned int &dayOfWeek){
+    unsigned int year = 1900;
+    unsigned int days = 0;
+    for(unsigned long i = 0; i < days1900; i++){
+        bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        if(++days >= (leapYear ? 366U : 365U)){
+            year++;
+            days = 0;
+        }
+    }
+    dayOfWeek = 1;
+    for(unsigned long i = 0; i < days1900; i++){
+        dayOfWeek = dayOfWeek < 7 ? dayOfWeek + 1 : 1;
+    }
+    return year;
+}
+
+static void benchCalcDate(){
+    WiFiUDP udp;
+    NTPClientPlus ntp(udp, "pool.ntp.org", 0, false);
+    setClockToDay(ntp, 20000, 0);
+    double constantTime = benchNanoseconds(1000000, [&](unsigned long i){
+        NTPClientPlusTest::advanceDay(ntp);
+        ntp.calcDate();
+        benchSink += NTPClientPlusTest::day(ntp);
+    });
+    double loopTime = benchNanoseconds(200, [&](unsigned long i){
+        unsigned int dayOfWeek;
+        benchSink += yearByCountingDays(25567 + 20000 + i, dayOfWeek) + dayOfWeek;
+    });
+    double gmtimeTime = benchNanoseconds(1000000, [&](unsigned long i){
+        struct tm date = utcDate(20000 + (i & 0xffff));
+        benchSink += date.tm_mday;
+    });
+    printf("bench calcDate: civilFromDays %.1f ns, day counting loops %.0f ns, gmtime_r %.1f ns per call (host)\n",
+           constantTime, loopTime, gmtimeTime);
+}
+
+int main(int argc, char **argv){
+    testCivilFromDaysMatchesGmtime();
+    testCalcDateMatchesGmtime();
+    testEdgeCases();
+    if(benchRequested(argc, argv)){
+        benchCalcDate();
+    }
+    return testSummary("test_ntp_date");
+}
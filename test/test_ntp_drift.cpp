@@ -0,0 +1,255 @@
+/**
+ * @file test_ntp_drift.cpp
+ * @brief Host simulation of the clock discipline of NTPClientPlus (applyNTPSample()): a crystal with
+ * a frequency error, a network with jitter, and the update loop of the sketch which polls with getPollInterval()
+ *
+ */
+
+#include "testing.h"
+#include <math.h>
+#include <deque>
+#include <random>
+#include <vector>
+#include <WiFiUdp.h>
+#include "ntp_client_plus.h"
+
+// true time at the start of the simulation in ms since 1900
+static const double trueStart = (SEVENZYYEARS + 1700000000.0) * 1000.0 + 123.4;
+
+/**
+ * @brief Simulated world: true time, the crystal of the device (millis() = true time * (1 + skew)) and the network
+ *
+ */
+struct World {
+    double trueMs = 0;
+    double localMs = 0;
+    double skewPpm = 0;
+    double baseDelay = 10;      // ms of each direction
+    double jitterMean = 10;     // mean of the exponentially distributed additional delay
+    double lossRate = 0.02;
+    std::mt19937 random{1};
+
+    void advance(double ms){
+        trueMs += ms;
+        localMs += ms * (1 + skewPpm * 1e-6);
+        fakeMillis = (unsigned long)localMs;
+        fakeMicros = (unsigned long)(localMs * 1000);
+    }
+
+    double networkDelay(){
+        std::exponential_distribution<double> jitter(1.0 / jitterMean);
+        return baseDelay + jitter(random);
+    }
+};
+
+/**
+ * @brief UDP transport with an NTP server on the true time
+ *
+ */
+class SimulatedNTPServer : public UDP{
+    public:
+        SimulatedNTPServer(World &world) : _world(world) {}
+        unsigned int requests = 0;
+
+        uint8_t begin(uint16_t port){ return 1; }
+        void stop() {}
+        int beginPacket(IPAddress ip, uint16_t port){ _request.clear(); return 1; }
+        int beginPacket(const char *host, uint16_t port){ _request.clear(); return 1; }
+        int endPacket(){
+            requests++;
+            if(std::uniform_real_distribution<double>(0, 1)(_world.random) < _world.lossRate){
+                return 1;
+            }
+            double received = _world.trueMs + _world.networkDelay();
+            std::vector<uint8_t> packet(NTP_PACKET_SIZE, 0);
+            packet[0] = 0x24;
+            packet[1] = 2;
+            memcpy(&packet[24], &_request[40], 8);
+            writeTimestamp(&packet[32], trueStart + received);
+            writeTimestamp(&packet[40], trueStart + received + 0.05);
+            _inbox.push_back(std::make_pair(received + 0.05 + _world.networkDelay(), packet));
+            return 1;
+        }
+        size_t write(uint8_t c){ return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size){
+            _request.insert(_request.end(), buffer, buffer + size);
+            return size;
+        }
+        int parsePacket(){
+            _current.clear();
+            for(auto packet = _inbox.begin(); packet != _inbox.end(); packet++){
+                if(packet->first <= _world.trueMs){
+                    _current = packet->second;
+                    _inbox.erase(packet);
+                    return _current.size();
+                }
+            }
+            return 0;
+        }
+        int available(){ return _current.size(); }
+        int read(){ return -1; }
+        int read(unsigned char *buffer, size_t len){
+            size_t size = min(len, _current.size());
+            memcpy(buffer, _current.data(), size);
+            _current.clear();
+            return size;
+        }
+        int peek(){ return -1; }
+        void flush(){ _current.clear(); }
+        IPAddress remoteIP(){ return IPAddress(); }
+        uint16_t remotePort(){ return 123; }
+
+    private:
+        World &_world;
+        std::vector<uint8_t> _request;
+        std::vector<uint8_t> _current;
+        std::deque<std::pair<double, std::vector<uint8_t>>> _inbox;
+
+        static void writeTimestamp(uint8_t *timestamp, double millis){
+            double seconds = floor(millis / 1000);
+            uint32_t fraction = (uint32_t)((millis / 1000 - seconds) * 4294967296.0);
+            for(int i = 0; i < 4; i++){
+                timestamp[i] = (uint32_t)seconds >> (24 - 8 * i);
+                timestamp[4 + i] = fraction >> (24 - 8 * i);
+            }
+        }
+};
+
+/**
+ * @brief Statistics of a simulation run, the errors after the first hour
+ *
+ */
+struct SimulationResult {
+    double maxError = 0;                // ms, local clock - true time
+    long maxDrift = 0;                  // ppb, largest estimate during the run
+    unsigned long minPollInterval = NTP_MAX_POLL_INTERVAL;    // whole run
+    unsigned long maxPollInterval = 0;
+    unsigned long minPollAfterStep = NTP_MAX_POLL_INTERVAL;
+    unsigned int failures = 0;
+    unsigned int requests = 0;
+};
+
+/**
+ * @brief Run the update loop of the sketch (wordclock_esp8266.ino: start an update when the poll interval
+ * has elapsed, retry after 10 s (PERIOD_NTPRETRY) if it failed), optionally change the skew during the run
+ *
+ */
+static SimulationResult simulate(World &world, NTPClientPlus &ntp, SimulatedNTPServer &server, double hours,
+                                 double skewStepAt = -1, double skewStep = 0){
+    SimulationResult result;
+    ntp.updateNTP();
+    unsigned long lastUpdate = fakeMillis;
+    unsigned long period = ntp.getPollInterval();
+    const double end = world.trueMs + hours * 3600000;
+    const double warmup = world.trueMs + 3600000;
+    bool stepped = false;
+    while(world.trueMs < end){
+        if(!stepped && skewStepAt >= 0 && world.trueMs >= skewStepAt){
+            world.skewPpm += skewStep;
+            stepped = true;
+        }
+        if(!ntp.isUpdatePending() && fakeMillis - lastUpdate > period){
+            ntp.requestNTP();
+        }
+        if(ntp.isUpdatePending()){
+            int status = ntp.pollNTP();
+            if(status != NTP_UPDATE_PENDING){
+                lastUpdate = fakeMillis;
+                if(status == NTP_UPDATE_SUCCESS){
+                    period = ntp.getPollInterval();
+                    result.minPollInterval = min(result.minPollInterval, period);
+                    result.maxPollInterval = max(result.maxPollInterval, period);
+                    if(stepped){
+                        result.minPollAfterStep = min(result.minPollAfterStep, period);
+                    }
+                }
+                else{
+                    result.failures++;
+                    period = 10000;    // PERIOD_NTPRETRY
+                }
+            }
+            world.advance(1);
+        }
+        else{
+            world.advance(100);
+        }
+        long drift = ntp.getDrift();
+        result.maxDrift = max(result.maxDrift, drift < 0 ? -drift : drift);
+        if(world.trueMs > warmup){
+            result.maxError = max(result.maxError, fabs((double)ntp.getMillisSince1900() - (trueStart + world.trueMs)));
+        }
+    }
+    result.requests = server.requests;
+    return result;
+}
+
+/**
+ * @brief Crystal errors up to +-100 ppm with network jitter: the drift estimate converges to the skew,
+ * the clock stays within a few network delays of the true time and the poll interval grows to the maximum
+ *
+ */
+static void testConvergesWithSkewAndJitter(){
+    for(double skew : {-100.0, -37.0, 0.0, 55.0, 100.0}){
+        World world;
+        world.skewPpm = skew;
+        SimulatedNTPServer server(world);
+        NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+        SimulationResult result = simulate(world, ntp, server, 24);
+
+        // positive drift: millis() runs slow
+        double estimate = ntp.getDrift() / 1000.0;
+        printf("skew %+6.1f ppm: drift %+7.2f ppm, max error %5.1f ms, poll %lu..%lu s, %u requests, %u failed updates\n",
+               skew, estimate, result.maxError, result.minPollInterval / 1000, result.maxPollInterval / 1000, result.requests, result.failures);
+        CHECK(fabs(estimate + skew) < 10);
+        CHECK(result.maxDrift <= NTP_MAX_DRIFT);
+        CHECK(result.maxError < 50);
+        // starts at 64 s and grows to 1024 s
+        CHECK_EQUAL(result.minPollInterval, NTP_MIN_POLL_INTERVAL);
+        CHECK_EQUAL(result.maxPollInterval, NTP_MAX_POLL_INTERVAL);
+        CHECK_EQUAL(ntp.getPollInterval(), NTP_MAX_POLL_INTERVAL);
+    }
+}
+
+/**
+ * @brief The crystal changes its frequency by 100 ppm (e.g. temperature): the offsets grow,
+ * the poll interval drops towards 64 s until the drift is corrected and then grows again
+ *
+ */
+static void testFollowsFrequencyStep(){
+    World world;
+    world.skewPpm = 50;
+    SimulatedNTPServer server(world);
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+    SimulationResult result = simulate(world, ntp, server, 24, 6 * 3600000.0, -100);
+    double estimate = ntp.getDrift() / 1000.0;
+    printf("skew +50 -> -50 ppm after 6 h: drift %+7.2f ppm, max error %5.1f ms, poll after the step %lu..%lu s\n",
+           estimate, result.maxError, result.minPollAfterStep / 1000, result.maxPollInterval / 1000);
+    CHECK(fabs(estimate - 50) < 10);
+    CHECK(result.minPollAfterStep < NTP_MAX_POLL_INTERVAL);
+    CHECK(result.minPollAfterStep >= NTP_MIN_POLL_INTERVAL);
+    CHECK(result.maxDrift <= NTP_MAX_DRIFT);
+    CHECK_EQUAL(ntp.getPollInterval(), NTP_MAX_POLL_INTERVAL);
+}
+
+/**
+ * @brief A skew beyond the limit: the drift estimate stops at NTP_MAX_DRIFT, the offsets stay
+ * large and the poll interval stays at its minimum
+ *
+ */
+static void testDriftIsLimited(){
+    World world;
+    world.skewPpm = -1500;
+    SimulatedNTPServer server(world);
+    NTPClientPlus ntp(server, "pool.ntp.org", 0, false);
+    SimulationResult result = simulate(world, ntp, server, 6);
+    CHECK_EQUAL(ntp.getDrift(), NTP_MAX_DRIFT);
+    CHECK(result.maxDrift <= NTP_MAX_DRIFT);
+    CHECK_EQUAL(result.maxPollInterval, NTP_MIN_POLL_INTERVAL);
+}
+
+int main(int argc, char **argv){
+    testConvergesWithSkewAndJitter();
+    testFollowsFrequencyStep();
+    testDriftIsLimited();
+    return testSummary("test_ntp_drift");
+}
@@ -0,0 +1,98 @@
+/**
+ * @file test_profiler.cpp
+ * @brief Host tests and benchmark of the loop stage profiler
+ *
+ */
+
+#include "testing.h"
+#include "profiler.h"
+
+/**
+ * @brief Percentiles are the upper bound of the log2 bucket, limited to the longest duration
+ *
+ */
+static void testPercentiles(){
+    StageHistogram histogram;
+    CHECK_EQUAL(histogram.getPercentile(50), 0);
+    // 90 short samples in [64, 128), 9 in [1024, 2048) and one of 5000 ticks
+    for(int i = 0; i < 90; i++){
+        histogram.add(64 + i % 64);
+    }
+    for(int i = 0; i < 9; i++){
+        histogram.add(1500);
+    }
+    histogram.add(5000);
+    CHECK_EQUAL(histogram.getSamples(), 100);
+    CHECK_EQUAL(histogram.getPercentile(50), 127);
+    CHECK_EQUAL(histogram.getPercentile(90), 127);
+    CHECK_EQUAL(histogram.getPercentile(99), 2047);
+    CHECK_EQUAL(histogram.getPercentile(100), 5000);
+    CHECK_EQUAL(histogram.getMax(), 5000);
+    histogram.reset();
+    CHECK_EQUAL(histogram.getSamples(), 0);
+    CHECK_EQUAL(histogram.getPercentile(99), 0);
+}
+
+/**
+ * @brief A full bucket halves all buckets, so the distribution follows recent samples
+ *
+ */
+static void testSaturationHalvesBuckets(){
+    StageHistogram histogram;
+    for(int i = 0; i < 0xffff; i++){
+        histogram.add(100);
+    }
+    // 0xffff + 1 samples of bucket 6 -> halved to 0x8000, new samples of bucket 10 take over after 0x8000 more
+    histogram.add(100);
+    for(int i = 0; i < 0x8000 + 1; i++){
+        histogram.add(1500);
+    }
+    CHECK_EQUAL(histogram.getPercentile(50), 1500);
+    CHECK_EQUAL(histogram.getSamples(), 0xffffUL + 1 + 0x8000 + 1);
+}
+
+/**
+ * @brief Stage results are reported in microseconds (ticks of the 80 MHz cycle counter)
+ *
+ */
+static void testStageMicroseconds(){
+    Profiler profiler;
+    profiler.record(stage_show, 80 * 3000);
+    CHECK_EQUAL(profiler.getMax(stage_show), 3000);
+    CHECK_EQUAL(profiler.getSamples(stage_show), 1);
+    CHECK_EQUAL(profiler.getSamples(stage_ntp), 0);
+    fakeMicros = 1000;
+    profiler.start(stage_ntp);
+    fakeMicros = 1250;
+    profiler.stop(stage_ntp);
+    fakeMicros = 0;
+    CHECK_EQUAL(profiler.getMax(stage_ntp), 250);
+    CHECK(strcmp(Profiler::getStageName(stage_ntp), "ntp") == 0);
+    profiler.reset();
+    CHECK_EQUAL(profiler.getSamples(stage_show), 0);
+}
+
+/**
+ * @brief Cost of recording one sample and of a p99 query
+ *
+ */
+static void benchHistogram(){
+    StageHistogram histogram;
+    double add = benchNanoseconds(10000000, [&](unsigned long i){
+        histogram.add(i * 2654435761UL >> (i & 31));
+    });
+    double percentile = benchNanoseconds(1000000, [&](unsigned long i){
+        benchSink += histogram.getPercentile(99);
+    });
+    printf("bench StageHistogram: add %.1f ns, getPercentile %.1f ns (host)\n", add, percentile);
+}
+
+int main(int argc, char **argv){
+    testPercentiles();
+    testSaturationHalvesBuckets();
+    testStageMicroseconds();
+    if(benchRequested(argc, argv)){
+        benchHistogram();
+    }
+    return testSummary("test_profiler");
+}
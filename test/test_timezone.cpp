@@ -0,0 +1,241 @@
+/**
+ * @file test_timezone.cpp
+ * @brief Host tests of TimeZone: parsing of POSIX TZ strings, offsets and transitions compared
+ * with localtime_r() of the host C library (glibc reads the same TZ format)
+ *
+ */
+
+#include "testing.h"
+#include <stdlib.h>
+#include <time.h>
+#include <random>
+#include "timezone.h"
+
+// 1. Jan. 2100 00:00 UTC
+static const int64_t endOfTest = 4102444800LL;
+
+/**
+ * @brief Zones compared with the host C library
+ *
+ */
+static const char *const hostZones[] = {
+    "CET-1CEST,M3.5.0,M10.5.0/3",                       // central Europe
+    "EST5EDT,M3.2.0,M11.1.0",                           // US Eastern
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",                     // Sydney, daylight saving time over new year
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "<+0530>-5:30",                                     // India, without daylight saving time
+    "HST10",
+    "UTC0",
+    "<+01>-1<+02>,M3.5.0/2,M10.5.0/3",                  // quoted names
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",                 // negative transition times
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45",     // Chatham Islands, offsets with minutes
+    "IST-1GMT0,M10.5.0,M3.5.0/1",                       // Ireland: "winter time" as daylight saving time
+    "XXX3YYY,J60/2,J300/2",                             // Julian days, 29. Feb. is never counted
+    "AAA3BBB,59/2,300/2",                               // zero based days, 29. Feb. is counted
+    "AAA-5:30BBB-6:45,M4.5.6/23:59:59,M9.1.1/0:00:01",
+};
+
+static unsigned long compareFailures = 0;
+
+/**
+ * @brief Compare offset and daylight saving time at one instant with localtime_r() (TZ has to be set)
+ *
+ */
+static void compareWithHost(TimeZone &zone, const char *tz, int64_t utc){
+    time_t t = (time_t)utc;
+    struct tm local;
+    localtime_r(&t, &local);
+    long offset = zone.getOffset(utc);
+    bool dst = zone.isDST(utc);
+    if(offset != local.tm_gmtoff || dst != (local.tm_isdst > 0)){
+        if(compareFailures++ < 10){
+            printf("%s at %lld: offset %ld dst %d, host %ld dst %d\n", tz, (long long)utc, offset, dst, (long)local.tm_gmtoff, local.tm_isdst);
+        }
+    }
+}
+
+/**
+ * @brief Every transition up to 2100 (walked with getNextTransition()), random instants in random order
+ * (the cache has to follow jumps backwards) and every hour of 2020-2030 (no transition is missed)
+ *
+ */
+static void testZonesMatchHost(){
+    std::mt19937_64 random(1);
+    for(const char *tz : hostZones){
+        setenv("TZ", tz, 1);
+        tzset();
+        TimeZone zone;
+        CHECK(zone.parse(tz));
+        unsigned long failuresBefore = compareFailures;
+
+        int64_t utc = 0;
+        while(utc < endOfTest){
+            compareWithHost(zone, tz, utc);
+            int64_t next = zone.getNextTransition(utc);
+            if(next >= endOfTest){
+                break;
+            }
+            CHECK(next > utc);
+            compareWithHost(zone, tz, next - 1);
+            compareWithHost(zone, tz, next);
+            utc = next;
+        }
+        for(int i = 0; i < 100000; i++){
+            compareWithHost(zone, tz, (int64_t)(random() % endOfTest));
+        }
+        for(int64_t hour = 1577836800; hour < 1893456000; hour += 3600){
+            compareWithHost(zone, tz, hour);
+        }
+        if(compareFailures != failuresBefore){
+            printf("zone %s differs from the host\n", tz);
+        }
+    }
+    unsetenv("TZ");
+    tzset();
+    CHECK_EQUAL(compareFailures, 0);
+}
+
+/**
+ * @brief Offset, daylight saving time and next transition at instants around the change of the year
+ *
+ */
+static void testTransitionsAcrossYears(){
+    struct TransitionCase {
+        const char *tz;
+        int64_t utc;
+        long offset;
+        bool dst;
+        int64_t next;
+    };
+    static const TransitionCase cases[] = {
+        // 31.12.2025 23:00 UTC, summer in Sydney: daylight saving time until 5.4.2026 03:00 local time
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 1767222000, 39600, true, 1775318400},
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 1775318400, 36000, false, 1791043200},
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 1775318399, 39600, true, 1775318400},
+        // 1.1.2026 00:30 local time in Berlin: next transition 29.3.2026 01:00 UTC
+        {"CET-1CEST,M3.5.0,M10.5.0/3", 1767223800, 3600, false, 1774746000},
+        {"CET-1CEST,M3.5.0,M10.5.0/3", 1774746000, 7200, true, 1792890000},
+        // 1.11.2026 01:59:59 EDT, one second before the end of daylight saving time
+        {"EST5EDT,M3.2.0,M11.1.0", 1793512799, -14400, true, 1793512800},
+        {"EST5EDT,M3.2.0,M11.1.0", 1793512800, -18000, false, 1805007600},
+        // start at 31.12. 25:00 is 1.1. 01:00 of the next year (glibc evaluates the rules per year and
+        // shows daylight saving time from 1.1. 00:00 to 01:00, so this zone is not compared with the host)
+        {"AAA0BBB,J365/25,J90", 1767182400, 0, false, 1767229200},
+        {"AAA0BBB,J365/25,J90", 1767229200, 3600, true, 1774918800},
+        // J60 is always 1. March, 59 is 29. Feb. in leap years
+        {"AAA0BBB,J60/0,J300/0", 1705276800, 0, false, 1709251200},
+        {"AAA0BBB,59/0,300/0", 1705276800, 0, false, 1709164800},
+        {"AAA0BBB,59/0,300/0", 1673740800, 0, false, 1677628800},
+        // without daylight saving time there is no transition
+        {"<+0530>-5:30", 1767222000, 19800, false, INT64_MAX},
+        {"<+01>-1", 1767222000, 3600, false, INT64_MAX},
+    };
+    for(const TransitionCase &c : cases){
+        TimeZone zone;
+        CHECK(zone.parse(c.tz));
+        CHECK_EQUAL(zone.getNextTransition(c.utc), c.next);
+        CHECK_EQUAL(zone.getOffset(c.utc), c.offset);
+        CHECK_EQUAL(zone.isDST(c.utc), c.dst);
+    }
+}
+
+/**
+ * @brief Invalid strings are rejected and leave the time zone unchanged
+ *
+ */
+static void testInvalidStrings(){
+    static const char *const invalid[] = {
+        "",
+        "CE-1",                                     // name shorter than 3 letters
+        "CET",                                      // no offset
+        "<AB>1",                                    // quoted name shorter than 3 characters
+        "<+01-1",                                   // quote not closed
+        "CET25",                                    // offset > 24 h
+        "CET-1:60",
+        "CET-1CEST,M3.5.0",                         // end rule missing
+        "CET-1CEST,M13.5.0,M10.5.0",                // month 13
+        "CET-1CEST,M3.6.0,M10.5.0",                 // week 6
+        "CET-1CEST,M3.5.7,M10.5.0",                 // weekday 7
+        "CET-1CEST,J0,J365",                        // Julian days start at 1
+        "CET-1CEST,J1,J366",
+        "CET-1CEST,366,1",                          // zero based days end at 365
+        "CET-1CEST,M3.5.0/168,M10.5.0",             // transition time > 167 h
+        "CET-1CEST,M3.5.0,M10.5.0x",                // trailing characters
+        "CET-1CEST,M3.5.0,M10.5.0/3 ",
+        "CET-1\"X\"",
+        "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA1",     // longer than TZ_MAX_LENGTH
+    };
+    for(const char *tz : invalid){
+        TimeZone zone;
+        CHECK(zone.parse("CET-1"));
+        if(!testCheck(!zone.parse(tz), "invalid TZ string rejected", __FILE__, __LINE__)){
+            printf("    accepted \"%s\"\n", tz);
+        }
+        CHECK(strcmp(zone.getString(), "CET-1") == 0);
+        CHECK_EQUAL(zone.getOffset(0), 3600);
+    }
+    TimeZone zone;
+    CHECK(!zone.parse(nullptr));
+    CHECK(strcmp(zone.getString(), "UTC0") == 0);
+}
+
+/**
+ * @brief Default rules (US) without rules, all year daylight saving time and fixed offsets
+ *
+ */
+static void testSpecialZones(){
+    std::mt19937_64 random(2);
+    TimeZone withoutRules, usRules;
+    CHECK(withoutRules.parse("PST8PDT"));
+    CHECK(usRules.parse("PST8PDT,M3.2.0,M11.1.0"));
+    unsigned long differences = 0;
+    for(int i = 0; i < 100000; i++){
+        int64_t utc = (int64_t)(random() % endOfTest);
+        differences += withoutRules.getOffset(utc) != usRules.getOffset(utc);
+    }
+    CHECK_EQUAL(differences, 0);
+
+    // end of daylight saving time (31.12. 25:00) is after the start (1.1. 00:00): all year daylight saving time (RFC 8536)
+    TimeZone always;
+    CHECK(always.parse("EST5EDT,0/0,J365/25"));
+    unsigned long standardTime = 0;
+    for(int i = 0; i < 100000; i++){
+        int64_t utc = (int64_t)(random() % endOfTest);
+        standardTime += always.getOffset(utc) != -14400 || !always.isDST(utc);
+    }
+    CHECK_EQUAL(standardTime, 0);
+
+    TimeZone fixed;
+    fixed.setFixedOffset(-(5 * 3600 + 30 * 60));
+    CHECK(strcmp(fixed.getString(), "<-0530>+5:30:00") == 0);
+    CHECK_EQUAL(fixed.getOffset(0), -19800);
+    fixed.setFixedOffset(3600);
+    CHECK_EQUAL(fixed.getOffset(1767222000), 3600);
+    CHECK(!fixed.isDST(1767222000));
+    CHECK_EQUAL(fixed.getNextTransition(0), INT64_MAX);
+}
+
+static void benchGetOffset(){
+    TimeZone zone;
+    zone.parse("CET-1CEST,M3.5.0,M10.5.0/3");
+    // one call per second as in the clock: the cached range is hit
+    double cached = benchNanoseconds(10000000, [&](unsigned long i){
+        benchSink += zone.getOffset(1767222000 + i);
+    });
+    // alternating years: each call calculates the transitions
+    double uncached = benchNanoseconds(1000000, [&](unsigned long i){
+        benchSink += zone.getOffset(1767222000 + (int64_t)(i & 1) * 31536000 * 3);
+    });
+    printf("bench TimeZone::getOffset: cached %.2f ns, recalculated %.1f ns per call (host)\n", cached, uncached);
+}
+
+int main(int argc, char **argv){
+    testZonesMatchHost();
+    testTransitionsAcrossYears();
+    testInvalidStrings();
+    testSpecialZones();
+    if(benchRequested(argc, argv)){
+        benchGetOffset();
+    }
+    return testSummary("test_timezone");
+}
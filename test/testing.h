@@ -0,0 +1,75 @@
+/**
+ * @file testing.h
+ * @brief Minimal check macros for the host tests
+ *
+ * A failed check prints its location and the test continues, testSummary() returns the exit code.
+ * Benchmarks only run if the test is started with the argument "--bench" (make bench).
+ *
+ */
+
+#ifndef testing_h
+#define testing_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static unsigned long testChecks = 0;
+static unsigned long testFailures = 0;
+
+#define CHECK(condition) testCheck((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(actual, expected) \
+    do { \
+        long long _actual = (long long)(actual); \
+        long long _expected = (long long)(expected); \
+        if(!testCheck(_actual == _expected, #actual " == " #expected, __FILE__, __LINE__)){ \
+            printf("    actual %lld, expected %lld\n", _actual, _expected); \
+        } \
+    } while(0)
+
+static inline bool testCheck(bool ok, const char *condition, const char *file, int line){
+    testChecks++;
+    if(!ok){
+        testFailures++;
+        printf("%s:%d: check failed: %s\n", file, line, condition);
+    }
+    return ok;
+}
+
+/**
+ * @brief Print the result of all checks
+ *
+ * @param name name of the test
+ * @return int exit code of the test (0 = all checks passed)
+ */
+static inline int testSummary(const char *name){
+    printf("%s: %lu checks, %lu failed\n", name, testChecks, testFailures);
+    return testFailures == 0 ? 0 : 1;
+}
+
+static inline bool benchRequested(int argc, char **argv){
+    return argc > 1 && strcmp(argv[1], "--bench") == 0;
+}
+
+/**
+ * @brief Measure the time of a function on the host
+ *
+ * @param function called `iterations` times
+ * @return double nanoseconds per call
+ */
+template<class Function>
+static double benchNanoseconds(unsigned long iterations, Function function){
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < iterations; i++){
+        function(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// keeps the compiler from removing the benchmarked calculation
+static volatile uint32_t benchSink;
+
+#endif
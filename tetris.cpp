@@ -75,7 +75,7 @@ void Tetris::loopCycle(){
             // at game end show all bricks on field in red color for 1.5 seconds, then show score
             if (_tetrisGameOver == true) {
                 _tetrisGameOver = false;
-                (*_logger).logString("Tetris: end");
+                LOG_INFO(*_logger, "Tetris: end");
                 everythingRed();
                 _tetrisshowscore = millis();
             }
@@ -111,12 +111,12 @@ void Tetris::ctrlPlayPause() {
     {
         _lastButtonClick = millis();
         if (_gameStatet == GAME_STATE_PAUSEDt) {
-            (*_logger).logString("Tetris: continue");
+            LOG_INFO(*_logger, "Tetris: continue");
 
             _gameStatet = GAME_STATE_RUNNINGt;
 
         } else if (_gameStatet == GAME_STATE_RUNNINGt) {
-            (*_logger).logString("Tetris: pause");
+            LOG_INFO(*_logger, "Tetris: pause");
 
             _gameStatet = GAME_STATE_PAUSEDt;
         }
@@ -181,7 +181,7 @@ void Tetris::ctrlDown() {
  * @param i new speed value
  */
 void Tetris::setSpeed(int32_t i) {
-    (*_logger).logString("setSpeed: " + String(i));
+    LOG_DEBUG(*_logger, "setSpeed: %d", (int)i);
     _speedtetris = -10 * i + 150;
 }
 
@@ -200,7 +200,7 @@ void Tetris::resetLEDs()
  * 
  */
 void Tetris::tetrisInit() {
-    (*_logger).logString("Tetris: init");
+    LOG_INFO(*_logger, "Tetris: init");
     
     clearField();
     _brickSpeed = INIT_SPEED;
@@ -231,7 +231,7 @@ void Tetris::printField() {
                 }
             }
             if (_field.pix[x][y] == 1) {
-                (*_ledmatrix).gridAddPixel(x, y, _field.color[x][y]);
+                (*_ledmatrix).gridAddPixel(x, y, _brickLib[_field.brickType[x][y]].col);
             } else if (activeBrickPix == 1) {
                 (*_ledmatrix).gridAddPixel(x, y, _activeBrick.col);
             } else {
@@ -271,6 +271,7 @@ void Tetris::newActiveBrick() {
     _activeBrick.enabled = true;
 
     // Set color of brick
+    _activeBrick.type = selectedBrick;
     _activeBrick.col = selectedCol;
     // _activeBrick.color = _colorLib[1];
 
@@ -393,7 +394,7 @@ void Tetris::rotateActiveBrick() {
         tmpBrick.pix[3][2] = _activeBrick.pix[2][0];
         tmpBrick.pix[3][3] = _activeBrick.pix[3][0];
     } else {
-        (*_logger).logString("Tetris: Brick size error");
+        LOG_ERROR(*_logger, "Tetris: Brick size error");
     }
 
     // Now validate by checking collision.
@@ -459,7 +460,7 @@ void Tetris::addActiveBrickToField() {
             if (fx >= 0 && fy >= 0 && fx < WIDTH && fy < HEIGHT && _activeBrick.pix[bx][by]) { // Check if inside playing field
                 // _field.pix[fx][fy] = _field.pix[fx][fy] || _activeBrick.pix[bx][by];
                 _field.pix[fx][fy] = _activeBrick.pix[bx][by];
-                _field.color[fx][fy] = _activeBrick.col;
+                _field.brickType[fx][fy] = _activeBrick.type;
             }
         }
     }
@@ -478,7 +479,7 @@ void Tetris::moveFieldDownOne(uint8_t startRow) {
     for (y = startRow - 1; y > 0; y--) {
         for (x = 0; x < WIDTH; x++) {
             _field.pix[x][y + 1] = _field.pix[x][y];
-            _field.color[x][y + 1] = _field.color[x][y];
+            _field.brickType[x][y + 1] = _field.brickType[x][y];
         }
     }
 }
@@ -532,7 +533,7 @@ void Tetris::clearField() {
     for (y = 0; y < HEIGHT; y++) {
         for (x = 0; x < WIDTH; x++) {
             _field.pix[x][y] = 0;
-            _field.color[x][y] = 0;
+            _field.brickType[x][y] = 0;
         }
     }
     for (x = 0; x < WIDTH; x++) { //This last row is invisible to the player and only used for the collision detection routine
@@ -57,7 +57,7 @@ class Tetris{
     // Playing field
     struct Field {
         uint8_t pix[WIDTH][HEIGHT + 1]; //Make field one larger so that collision detection with bottom of field can be done in a uniform way
-        uint32_t color[WIDTH][HEIGHT];
+        uint8_t brickType[WIDTH][HEIGHT]; // index into _brickLib, color is taken from there (saves 3 bytes per pixel)
     };
 
 
@@ -69,6 +69,7 @@ class Tetris{
         uint8_t siz;
         uint8_t pix[MAX_BRICK_SIZE][MAX_BRICK_SIZE];
 
+        uint8_t type;//Index into _brickLib
         uint32_t col;
     };
 
@@ -0,0 +1,373 @@
+#include "timezone.h"
+#include <string.h>
+#include <stdio.h>
+
+static const long secondsPerDay = 86400;
+static const int64_t timeMin = INT64_MIN;
+static const int64_t timeMax = INT64_MAX;
+
+/**
+ * @brief Days since 1. Jan. 1970 of a date of the gregorian calendar
+ * (algorithm "days_from_civil" by Howard Hinnant, inverse of NTPClientPlus::civilFromDays())
+ *
+ * @param year
+ * @param month 1-12
+ * @param day 1-31
+ * @return long days since 1. Jan. 1970 (negative before)
+ */
+static long daysFromCivil(long year, unsigned int month, unsigned int day){
+    year -= month <= 2 ? 1 : 0;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned long yearOfEra = (unsigned long)(year - era * 400);                            // [0, 399]
+    unsigned long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365], from 1. March
+    unsigned long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;  // [0, 146096]
+    return era * 146097 + (long)dayOfEra - 719468;
+}
+
+static bool isLeapYear(long year){
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/**
+ * @brief Year (gregorian calendar, UTC) of a time
+ *
+ * @param utc seconds since 1. Jan. 1970
+ * @return long year
+ */
+static long yearOfTime(int64_t utc){
+    long days = (long)(utc >= 0 ? utc / secondsPerDay : (utc - secondsPerDay + 1) / secondsPerDay);
+    // estimate with the mean length of a year, then correct
+    long year = 1970 + (long)((int64_t)days * 400 / 146097);
+    while(daysFromCivil(year + 1, 1, 1) <= days){
+        year++;
+    }
+    while(daysFromCivil(year, 1, 1) > days){
+        year--;
+    }
+    return year;
+}
+
+/**
+ * @brief Parse an unsigned decimal number
+ *
+ * @param p read position, moved behind the number
+ * @param value parsed number
+ * @param max largest allowed value
+ * @return true if a number <= max was found
+ */
+static bool parseNumber(const char *&p, long &value, long max){
+    if(*p < '0' || *p > '9'){
+        return false;
+    }
+    value = 0;
+    while(*p >= '0' && *p <= '9'){
+        value = value * 10 + (*p - '0');
+        if(value > max){
+            return false;
+        }
+        p++;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a time or offset [+|-]hh[:mm[:ss]]
+ *
+ * @param p read position, moved behind the time
+ * @param seconds parsed time in seconds
+ * @param maxHours largest allowed number of hours
+ * @return true if valid
+ */
+static bool parseTime(const char *&p, long &seconds, long maxHours){
+    long sign = 1;
+    if(*p == '+' || *p == '-'){
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+    long hours = 0, minutes = 0, secs = 0;
+    if(!parseNumber(p, hours, maxHours)){
+        return false;
+    }
+    if(*p == ':'){
+        p++;
+        if(!parseNumber(p, minutes, 59)){
+            return false;
+        }
+        if(*p == ':'){
+            p++;
+            if(!parseNumber(p, secs, 59)){
+                return false;
+            }
+        }
+    }
+    seconds = sign * (hours * 3600 + minutes * 60 + secs);
+    return true;
+}
+
+/**
+ * @brief Parse the name of a zone, at least 3 letters or quoted in <>
+ *
+ * @param p read position, moved behind the name
+ * @return true if valid
+ */
+static bool parseName(const char *&p){
+    const char *start;
+    if(*p == '<'){
+        start = ++p;
+        while((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9') || *p == '+' || *p == '-'){
+            p++;
+        }
+        if(*p != '>' || p - start < 3){
+            return false;
+        }
+        p++;
+        return true;
+    }
+    start = p;
+    while((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')){
+        p++;
+    }
+    return p - start >= 3;
+}
+
+/**
+ * @brief Parse a transition rule Mm.w.d[/time], Jn[/time] or n[/time]
+ *
+ * @param p read position, moved behind the rule
+ * @param rule parsed rule
+ * @return true if valid
+ */
+static bool parseRule(const char *&p, TimeZoneRule &rule){
+    long month = 0, week = 0, weekday = 0, day = 0;
+    if(*p == 'M'){
+        p++;
+        if(!parseNumber(p, month, 12) || month < 1 || *p++ != '.' || !parseNumber(p, week, 5) || week < 1
+            || *p++ != '.' || !parseNumber(p, weekday, 6)){
+            return false;
+        }
+        rule.type = rule_month;
+    }
+    else if(*p == 'J'){
+        p++;
+        if(!parseNumber(p, day, 365) || day < 1){
+            return false;
+        }
+        rule.type = rule_julian;
+    }
+    else{
+        if(!parseNumber(p, day, 365)){
+            return false;
+        }
+        rule.type = rule_day;
+    }
+    rule.month = month;
+    rule.week = week;
+    rule.weekday = weekday;
+    rule.day = day;
+    rule.time = 7200;
+    if(*p == '/'){
+        p++;
+        // extension of RFC 8536: hours may be negative or up to 167
+        return parseTime(p, rule.time, 167);
+    }
+    return true;
+}
+
+/**
+ * @brief Construct a new TimeZone object (UTC)
+ *
+ */
+TimeZone::TimeZone(){
+    parse("UTC0");
+}
+
+/**
+ * @brief Set time zone from POSIX TZ string, an invalid string leaves the time zone unchanged
+ *
+ * @param tz TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+ * @return true if the string is valid
+ */
+bool TimeZone::parse(const char *tz){
+    if(tz == nullptr || strlen(tz) >= TZ_MAX_LENGTH){
+        return false;
+    }
+    const char *p = tz;
+    long stdOffset = 0, dstOffset = 0;
+    bool hasDST = false;
+    // without rules the US rules apply (like glibc)
+    TimeZoneRule start = {rule_month, 3, 2, 0, 0, 7200};
+    TimeZoneRule end = {rule_month, 11, 1, 0, 0, 7200};
+
+    if(!parseName(p) || !parseTime(p, stdOffset, 24)){
+        return false;
+    }
+    // TZ offsets are positive west of Greenwich
+    stdOffset = -stdOffset;
+    if(*p != '\0'){
+        hasDST = true;
+        if(!parseName(p)){
+            return false;
+        }
+        dstOffset = stdOffset + 3600;
+        if(*p != ',' && *p != '\0'){
+            if(!parseTime(p, dstOffset, 24)){
+                return false;
+            }
+            dstOffset = -dstOffset;
+        }
+        if(*p == ','){
+            p++;
+            if(!parseRule(p, start) || *p++ != ',' || !parseRule(p, end)){
+                return false;
+            }
+        }
+        if(*p != '\0'){
+            return false;
+        }
+    }
+
+    strcpy(_string, tz);
+    _stdOffset = stdOffset;
+    _dstOffset = dstOffset;
+    _hasDST = hasDST;
+    _start = start;
+    _end = end;
+    // empty range -> calculated on next access
+    _validFrom = 0;
+    _validUntil = 0;
+    return true;
+}
+
+/**
+ * @brief Set a time zone with a fixed offset and without daylight saving time
+ *
+ * @param offset offset to UTC in seconds (east of Greenwich is positive)
+ */
+void TimeZone::setFixedOffset(long offset){
+    char tz[TZ_MAX_LENGTH];
+    long absOffset = offset < 0 ? -offset : offset;
+    snprintf(tz, sizeof(tz), "<%c%02ld%02ld>%c%ld:%02ld:%02ld", offset < 0 ? '-' : '+', absOffset / 3600, absOffset / 60 % 60,
+             offset < 0 ? '+' : '-', absOffset / 3600, absOffset / 60 % 60, absOffset % 60);
+    parse(tz);
+}
+
+/**
+ * @brief Get offset of local time to UTC, only compares with the cached range until the next transition
+ *
+ * @param utc seconds since 1. Jan. 1970 (UTC)
+ * @return long offset in seconds (local time = utc + offset)
+ */
+long TimeZone::getOffset(int64_t utc){
+    if(utc < _validFrom || utc >= _validUntil){
+        updateCache(utc);
+    }
+    return _currentOffset;
+}
+
+/**
+ * @brief Check if daylight saving time is active
+ *
+ * @param utc seconds since 1. Jan. 1970 (UTC)
+ * @return true if daylight saving time
+ */
+bool TimeZone::isDST(int64_t utc){
+    if(utc < _validFrom || utc >= _validUntil){
+        updateCache(utc);
+    }
+    return _currentDST;
+}
+
+/**
+ * @brief Get the instant of the next change of the offset
+ *
+ * @param utc seconds since 1. Jan. 1970 (UTC)
+ * @return int64_t next transition (UTC), INT64_MAX without daylight saving time
+ */
+int64_t TimeZone::getNextTransition(int64_t utc){
+    if(utc < _validFrom || utc >= _validUntil){
+        updateCache(utc);
+    }
+    return _validUntil;
+}
+
+/**
+ * @brief (private) Calculate the offset at the given time and the range in which it is valid
+ *
+ * @param utc seconds since 1. Jan. 1970 (UTC)
+ */
+void TimeZone::updateCache(int64_t utc){
+    if(!_hasDST){
+        _validFrom = timeMin;
+        _validUntil = timeMax;
+        _currentOffset = _stdOffset;
+        _currentDST = false;
+        return;
+    }
+
+    // transitions of previous, current and next year (the order differs on the southern hemisphere)
+    long year = yearOfTime(utc);
+    int64_t times[6];
+    bool toDST[6];
+    uint8_t count = 0;
+    for(long y = year - 1; y <= year + 1; y++){
+        // start is given in standard time, end in daylight saving time
+        times[count] = transitionTime(_end, y, _dstOffset);
+        toDST[count++] = false;
+        times[count] = transitionTime(_start, y, _stdOffset);
+        toDST[count++] = true;
+    }
+    // insertion sort, at the same instant the end comes before the start (all year daylight saving time)
+    for(uint8_t i = 1; i < count; i++){
+        for(uint8_t j = i; j > 0 && (times[j] < times[j - 1] || (times[j] == times[j - 1] && !toDST[j] && toDST[j - 1])); j--){
+            int64_t t = times[j];
+            times[j] = times[j - 1];
+            times[j - 1] = t;
+            bool d = toDST[j];
+            toDST[j] = toDST[j - 1];
+            toDST[j - 1] = d;
+        }
+    }
+
+    uint8_t next = 0;
+    while(next < count && times[next] <= utc){
+        next++;
+    }
+    _currentDST = (next > 0) ? toDST[next - 1] : !toDST[0];
+    _validFrom = (next > 0) ? times[next - 1] : utc;
+    _validUntil = (next < count) ? times[next] : utc + 1;
+    _currentOffset = _currentDST ? _dstOffset : _stdOffset;
+}
+
+/**
+ * @brief (private) Calculate the instant of a transition
+ *
+ * @param rule day and local time of the transition
+ * @param year
+ * @param offset offset of the local time before the transition
+ * @return int64_t transition (UTC) in seconds since 1. Jan. 1970
+ */
+int64_t TimeZone::transitionTime(const TimeZoneRule &rule, long year, long offset) const{
+    long day;
+    switch(rule.type){
+        case rule_month:
+        {
+            long first = daysFromCivil(year, rule.month, 1);
+            long weekdayOfFirst = ((first + 4) % 7 + 7) % 7;   // 1. Jan. 1970 was a Thursday
+            long nextMonth = (rule.month == 12) ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, rule.month + 1, 1);
+            day = first + (rule.weekday - weekdayOfFirst + 7) % 7 + (rule.week - 1) * 7;
+            // week 5 is the last week of the month
+            while(day >= nextMonth){
+                day -= 7;
+            }
+            break;
+        }
+        case rule_julian:
+            // 29. Feb. is never counted
+            day = daysFromCivil(year, 1, 1) + rule.day - 1 + ((isLeapYear(year) && rule.day >= 60) ? 1 : 0);
+            break;
+        default:
+            day = daysFromCivil(year, 1, 1) + rule.day;
+            break;
+    }
+    return (int64_t)day * secondsPerDay + rule.time - offset;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file timezone.h
+ * @brief Time zone with daylight saving time rules given as POSIX TZ string
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * Format: std offset [dst [offset] [,start[/time],end[/time]]], e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+ * - std, dst: names of the zones, at least 3 letters or quoted like <+03>
+ * - offset: [+|-]hh[:mm[:ss]] to add to the local time to get UTC (west of Greenwich is positive)
+ * - start, end: Mm.w.d (day d (0 = Sunday) of week w (5 = last) of month m), Jn (day 1..365, 29. Feb.
+ *   is never counted) or n (day 0..365), time is local time [+|-]hh[:mm[:ss]] (default 02:00:00)
+ *
+ * The instants of the last and the next transition are calculated once, until the next transition
+ * getOffset() only compares the given time with the cached range.
+ *
+ */
+
+#ifndef timezone_h
+#define timezone_h
+
+#include <stdint.h>
+
+// max length of the TZ string including '\0'
+#define TZ_MAX_LENGTH 48
+
+enum TimeZoneRuleType {rule_month, rule_julian, rule_day};
+
+/**
+ * @brief Day and local time of a daylight saving time transition
+ *
+ */
+struct TimeZoneRule {
+    TimeZoneRuleType type;
+    uint8_t month;          // rule_month: 1-12
+    uint8_t week;           // rule_month: 1-5 (5 = last)
+    uint8_t weekday;        // rule_month: 0-6 (0 = Sunday)
+    uint16_t day;           // rule_julian: 1-365, rule_day: 0-365
+    long time;              // seconds after local midnight (may be negative or more than 24h)
+};
+
+class TimeZone{
+
+    public:
+        TimeZone();
+        bool parse(const char *tz);
+        void setFixedOffset(long offset);
+        const char *getString() const { return _string; }
+        long getOffset(int64_t utc);
+        bool isDST(int64_t utc);
+        int64_t getNextTransition(int64_t utc);
+    private:
+        char _string[TZ_MAX_LENGTH];
+        long _stdOffset = 0;            // seconds east of UTC
+        long _dstOffset = 0;
+        bool _hasDST = false;
+        TimeZoneRule _start;
+        TimeZoneRule _end;
+
+        // cached range [_validFrom, _validUntil) with constant offset
+        int64_t _validFrom = 0;
+        int64_t _validUntil = 0;
+        long _currentOffset = 0;
+        bool _currentDST = false;
+
+        void updateCache(int64_t utc);
+        int64_t transitionTime(const TimeZoneRule &rule, long year, long offset) const;
+};
+
+#endif
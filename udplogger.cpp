@@ -1,38 +1,404 @@
 #include "udplogger.h"
 
+// level byte of a record which marks that the next record starts at the beginning of the ring buffer
+#define UDPLOGGER_WRAP_MARKER 0xff
+// bytes in front of the text of a record in the ring buffer (level, length, sequence number)
+#define UDPLOGGER_RECORD_HEADER 4
+
 UDPLogger::UDPLogger(){
 
 }
 
 UDPLogger::UDPLogger(IPAddress interfaceAddr, IPAddress multicastAddr, int port){
+    begin(interfaceAddr, multicastAddr, port);
+}
+
+/**
+ * @brief Start the multicast UDP connection. Messages logged before are kept in the queue.
+ *
+ * @param interfaceAddr ip address of the network interface
+ * @param multicastAddr multicast group address
+ * @param port destination port
+ */
+void UDPLogger::begin(IPAddress interfaceAddr, IPAddress multicastAddr, int port){
     _multicastAddr = multicastAddr;
     _port = port;
     _interfaceAddr = interfaceAddr;
-    _name = "Log";
     _Udp.beginMulticast(_interfaceAddr, _multicastAddr, _port);
 }
 
-void UDPLogger::setName(String name){
-    _name = name;
+void UDPLogger::setName(const char *name){
+    strncpy(_name, name, UDPLOGGER_MAX_NAME - 1);
+    _name[UDPLOGGER_MAX_NAME - 1] = '\0';
+}
+
+/**
+ * @brief Set the minimum level of messages which are logged (runtime),
+ * levels below UDPLOGGER_LEVEL are not compiled in anyway
+ *
+ * @param level LOG_LEVEL_xxx
+ */
+void UDPLogger::setLevel(uint8_t level){
+    _level = level;
+}
+
+/**
+ * @brief Format a message into the ring buffer, it is sent by handle(). Prefer the LOG_xxx macros.
+ *
+ * @param level LOG_LEVEL_xxx
+ * @param format printf format string in flash (PSTR)
+ */
+void UDPLogger::logf_P(uint8_t level, const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    vlogf_P(level, format, args);
+    va_end(args);
 }
 
-void UDPLogger::logString(String logmessage){
-    // wait 5 milliseconds if last send was less than 5 milliseconds before 
-    if(millis() < (_lastSend + 5)){
-        delay(5);
+/**
+ * @brief Format a message into the ring buffer, it is sent by handle()
+ *
+ * @param level LOG_LEVEL_xxx
+ * @param format printf format string in flash (PSTR)
+ * @param args arguments of the format string
+ */
+void UDPLogger::vlogf_P(uint8_t level, const char *format, va_list args){
+    if(!isEnabled(level)){
+        return;
+    }
+#if UDPLOGGER_BINARY
+    int16_t formatId = getFormatId(format);
+    if(formatId < 0 || !announceFormat(formatId)){
+        // no format id left or queue full
+        _nextSequence++;
+        _dropped++;
+        return;
+    }
+#endif
+    char *record = reserveRecord();
+    if(record == nullptr){
+        // queue full, the gap in the sequence numbers shows the loss at the receiver
+        _nextSequence++;
+        _dropped++;
+        return;
+    }
+    char *payload = record + UDPLOGGER_RECORD_HEADER;
+#if UDPLOGGER_BINARY
+    uint32_t timestamp = millis();
+    payload[0] = record_message;
+    for(uint8_t i = 0; i < 4; i++){
+        payload[1 + i] = timestamp >> (8 * i);
+    }
+    payload[5] = formatId & 0xff;
+    payload[6] = formatId >> 8;
+    uint8_t length = LOGFORMAT_MESSAGE_HEADER + encodeArguments((uint8_t *)payload + LOGFORMAT_MESSAGE_HEADER,
+                                                                UDPLOGGER_MAX_MESSAGE - LOGFORMAT_MESSAGE_HEADER, format, args);
+#else
+    // vsnprintf writes the terminating '\0' behind the text, it is not part of the record
+    int length = vsnprintf_P(payload, UDPLOGGER_MAX_MESSAGE + 1, format, args);
+    if(length < 0){
+        return;
+    }
+    if(length > UDPLOGGER_MAX_MESSAGE){
+        length = UDPLOGGER_MAX_MESSAGE;
     }
-    logmessage = _name + ": " + logmessage;
-    Serial.println(logmessage);
-    _Udp.beginPacketMulticast(_multicastAddr, _port, _interfaceAddr);
-    logmessage.toCharArray(_packetBuffer, 100);
-    _Udp.print(_packetBuffer);
-    _Udp.endPacket();
-    _lastSend=millis();
+    // remove trailing newlines, each message is sent as one line
+    while(length > 0 && payload[length - 1] == '\n'){
+        length--;
+    }
+#endif
+    commitRecord(record, level, length);
+}
+
+/**
+ * @brief Log a String with level info (allocates, prefer the LOG_xxx macros)
+ *
+ * @param logmessage message
+ */
+void UDPLogger::logString(const String &logmessage){
+    logf_P(LOG_LEVEL_INFO, PSTR("%s"), logmessage.c_str());
 }
 
 void UDPLogger::logColor24bit(uint32_t color){
   uint8_t resultRed = color >> 16 & 0xff;
   uint8_t resultGreen = color >> 8 & 0xff;
   uint8_t resultBlue = color & 0xff;
-  logString(String(resultRed) + ", " + String(resultGreen) + ", " + String(resultBlue));
-}
\ No newline at end of file
+  LOG_INFO(*this, "%u, %u, %u", resultRed, resultGreen, resultBlue);
+}
+
+/**
+ * @brief (private) Get contiguous space for one record of max length at the head of the ring buffer
+ *
+ * @return char* start of the record, nullptr if the ring buffer is full
+ */
+char *UDPLogger::reserveRecord(){
+    // + 1 for the '\0' of vsnprintf, head must never reach tail (-> empty)
+    const uint16_t needed = UDPLOGGER_RECORD_HEADER + UDPLOGGER_MAX_MESSAGE + 1;
+    if(_head == _tail){
+        // empty -> start at the beginning
+        _head = 0;
+        _tail = 0;
+    }
+    if(_head >= _tail){
+        if(UDPLOGGER_RING_SIZE - _head >= needed){
+            return &_ring[_head];
+        }
+        if(_tail > needed){
+            _ring[_head] = UDPLOGGER_WRAP_MARKER;
+            _head = 0;
+            return &_ring[_head];
+        }
+        return nullptr;
+    }
+    if(_tail - _head > needed){
+        return &_ring[_head];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief (private) Finish a record which was reserved with reserveRecord(), it is sent with the next datagram
+ *
+ * @param record start of the record
+ * @param level LOG_LEVEL_xxx
+ * @param length length of the payload
+ */
+void UDPLogger::commitRecord(char *record, uint8_t level, uint8_t length){
+    uint16_t sequence = _nextSequence++;
+    record[0] = level;
+    record[1] = length;
+    record[2] = sequence >> 8;
+    record[3] = sequence & 0xff;
+    _head += UDPLOGGER_RECORD_HEADER + length;
+}
+
+#if UDPLOGGER_BINARY
+/**
+ * @brief (private) Get the id of a format string, new format strings get the next free id.
+ * The table is hashed by the address of the format string, so no string is compared.
+ *
+ * @param format format string in flash
+ * @return int16_t format id, -1 if the table is full
+ */
+int16_t UDPLogger::getFormatId(const char *format){
+    uint16_t start = ((uintptr_t)format >> 2) % UDPLOGGER_MAX_FORMATS;
+    for(uint16_t i = 0; i < UDPLOGGER_MAX_FORMATS; i++){
+        uint16_t id = (start + i) % UDPLOGGER_MAX_FORMATS;
+        if(_formats[id] == format){
+            return id;
+        }
+        if(_formats[id] == nullptr){
+            _formats[id] = format;
+            return id;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief (private) Queue a format record if the format string was not sent in the current announce period
+ *
+ * @param formatId format id
+ * @return false if the queue is full
+ */
+bool UDPLogger::announceFormat(uint16_t formatId){
+    if((_announced[formatId >> 5] >> (formatId & 31)) & 1){
+        return true;
+    }
+    char *record = reserveRecord();
+    if(record == nullptr){
+        return false;
+    }
+    char *payload = record + UDPLOGGER_RECORD_HEADER;
+    const char *format = _formats[formatId];
+    uint8_t length = strlen_P(format) < UDPLOGGER_MAX_MESSAGE - LOGFORMAT_FORMAT_HEADER ? strlen_P(format) : UDPLOGGER_MAX_MESSAGE - LOGFORMAT_FORMAT_HEADER;
+    payload[0] = record_format;
+    payload[1] = formatId & 0xff;
+    payload[2] = formatId >> 8;
+    memcpy_P(payload + LOGFORMAT_FORMAT_HEADER, format, length);
+    commitRecord(record, LOG_LEVEL_NONE, LOGFORMAT_FORMAT_HEADER + length);
+    _announced[formatId >> 5] |= (1UL << (formatId & 31));
+    return true;
+}
+
+/**
+ * @brief (private) Write the arguments of a message in binary form (see logformat.h)
+ *
+ * @param out destination
+ * @param capacity size of destination, following arguments are cut off
+ * @param format format string in flash
+ * @param args arguments of the format string
+ * @return uint8_t number of bytes written
+ */
+uint8_t UDPLogger::encodeArguments(uint8_t *out, uint8_t capacity, const char *format, va_list args){
+    uint8_t length = 0;
+    for(uint16_t i = 0; pgm_read_byte(format + i) != '\0'; i++){
+        if(pgm_read_byte(format + i) != '%'){
+            continue;
+        }
+        const char *specStart = format + i;
+        LogFormatSpec spec = parseLogFormatSpec([specStart](uint8_t index){ return (char)pgm_read_byte(specStart + index); });
+        i += spec.length - 1;
+
+        uint64_t value = 0;
+        uint8_t size = 4;
+        for(uint8_t s = 0; s < spec.starArgs; s++){
+            uint32_t star = va_arg(args, int);
+            if(length + 4 > capacity){
+                return length;
+            }
+            memcpy(out + length, &star, 4);
+            length += 4;
+        }
+        switch(spec.type){
+            case arg_none:
+                continue;
+            case arg_int32:
+                if(spec.conversion == 'p'){
+                    value = (uintptr_t)va_arg(args, void *);
+                }
+                else if(spec.longs == 1){
+                    value = (uint32_t)va_arg(args, long);
+                }
+                else{
+                    value = (uint32_t)va_arg(args, int);
+                }
+                break;
+            case arg_int64:
+                value = va_arg(args, long long);
+                size = 8;
+                break;
+            case arg_float:
+                {
+                    float f = va_arg(args, double);
+                    memcpy(&value, &f, 4);
+                }
+                break;
+            case arg_string:
+                {
+                    const char *str = va_arg(args, const char *);
+                    if(length + 1 > capacity){
+                        return length;
+                    }
+                    size_t strLength = (str == nullptr) ? 0 : strlen(str);
+                    uint8_t maxLength = (capacity - length - 1 < 255) ? capacity - length - 1 : 255;
+                    if(strLength > maxLength){
+                        strLength = maxLength;
+                    }
+                    out[length++] = strLength;
+                    memcpy(out + length, str, strLength);
+                    length += strLength;
+                }
+                continue;
+        }
+        if(length + size > capacity){
+            return length;
+        }
+        // little endian
+        for(uint8_t b = 0; b < size; b++){
+            out[length++] = value >> (8 * b);
+        }
+    }
+    return length;
+}
+#endif
+
+/**
+ * @brief Send queued messages, at most UDPLOGGER_DATAGRAMS_PER_HANDLE datagrams. Has to be called regularly from loop().
+ *
+ */
+void UDPLogger::handle(){
+#if UDPLOGGER_BINARY
+    if(millis() - _lastAnnounceReset > UDPLOGGER_ANNOUNCE_PERIOD){
+        memset(_announced, 0, sizeof(_announced));
+        _lastAnnounceReset = millis();
+    }
+#endif
+    for(uint8_t i = 0; i < UDPLOGGER_DATAGRAMS_PER_HANDLE; i++){
+        if(!sendDatagram()){
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Send all queued messages (blocking), e.g. before a restart
+ *
+ */
+void UDPLogger::flush(){
+    while(sendDatagram()){
+    }
+}
+
+/**
+ * @brief (private) Pack as many records of the ring buffer as fit into one UDP datagram and send it
+ * (text lines or binary records, see logformat.h)
+ *
+ * @return true if a datagram was sent, false if the queue was empty
+ */
+bool UDPLogger::sendDatagram(){
+    const uint8_t nameLength = strlen(_name);
+    uint16_t datagramLength = 0;
+    bool packetStarted = false;
+    while(_tail != _head){
+        if((uint8_t)_ring[_tail] == UDPLOGGER_WRAP_MARKER){
+            _tail = 0;
+            continue;
+        }
+        uint8_t level = _ring[_tail];
+        uint8_t length = _ring[_tail + 1];
+        uint16_t sequence = ((uint8_t)_ring[_tail + 2] << 8) | (uint8_t)_ring[_tail + 3];
+        const uint8_t *text = (const uint8_t *)&_ring[_tail + UDPLOGGER_RECORD_HEADER];
+
+#if UDPLOGGER_BINARY
+        uint16_t recordLength = LOGFORMAT_RECORD_HEADER + length;
+        if(packetStarted && datagramLength + recordLength > UDPLOGGER_MAX_DATAGRAM){
+            break;
+        }
+        if(!packetStarted){
+            const uint8_t header[4] = {LOGFORMAT_MAGIC_0, LOGFORMAT_MAGIC_1, LOGFORMAT_VERSION, nameLength};
+            const uint8_t dropped[4] = {(uint8_t)_dropped, (uint8_t)(_dropped >> 8), (uint8_t)(_dropped >> 16), (uint8_t)(_dropped >> 24)};
+            _Udp.beginPacketMulticast(_multicastAddr, _port, _interfaceAddr);
+            _Udp.write(header, sizeof(header));
+            _Udp.write((const uint8_t *)_name, nameLength);
+            _Udp.write(dropped, sizeof(dropped));
+            datagramLength = sizeof(header) + nameLength + sizeof(dropped);
+            packetStarted = true;
+        }
+        const uint8_t recordHeader[LOGFORMAT_RECORD_HEADER] = {(uint8_t)sequence, (uint8_t)(sequence >> 8), level, length};
+        _Udp.write(recordHeader, sizeof(recordHeader));
+        _Udp.write(text, length);
+        datagramLength += recordLength;
+#else
+        (void)level;
+        // line: "<seq> <name>: <text>\n"
+        char sequenceString[7];
+        uint8_t sequenceLength = snprintf_P(sequenceString, sizeof(sequenceString), PSTR("%u "), sequence);
+        uint16_t lineLength = sequenceLength + nameLength + 2 + length + 1;
+        if(packetStarted && datagramLength + lineLength > UDPLOGGER_MAX_DATAGRAM){
+            break;
+        }
+        if(!packetStarted){
+            _Udp.beginPacketMulticast(_multicastAddr, _port, _interfaceAddr);
+            packetStarted = true;
+        }
+        _Udp.write((const uint8_t *)sequenceString, sequenceLength);
+        _Udp.write((const uint8_t *)_name, nameLength);
+        _Udp.write((const uint8_t *)": ", 2);
+        _Udp.write(text, length);
+        _Udp.write('\n');
+        datagramLength += lineLength;
+
+        Serial.print(_name);
+        Serial.print(": ");
+        Serial.write(text, length);
+        Serial.println();
+#endif
+
+        _tail += UDPLOGGER_RECORD_HEADER + length;
+    }
+    if(packetStarted){
+        _Udp.endPacket();
+    }
+    return packetStarted;
+}
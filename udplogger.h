@@ -1,12 +1,25 @@
 /**
  * @file udplogger.h
  * @author techniccontroller (mail[at]techniccontroller.com)
- * @brief Class for sending logging Strings as multicast messages 
- * @version 0.1
+ * @brief Class for sending logging Strings as multicast messages
+ * @version 0.2
  * @date 2022-03-21
- * 
+ *
  * @copyright Copyright (c) 2022
- * 
+ *
+ * Messages are formatted printf-style (format string in flash) directly into a preallocated
+ * ring buffer, no Strings are created. Use the LOG_xxx macros: messages below UDPLOGGER_LEVEL
+ * are removed at compile time, the runtime level is checked before formatting.
+ *
+ * Sending is decoupled from logging: handle() (called once per loop) packs as many queued
+ * messages as fit into one UDP datagram, one line per message: "<seq> <name>: <text>\n".
+ * Each message gets a 16bit sequence number, messages dropped because the queue was full
+ * use up their number too, so the receiver can detect losses and reorder datagrams.
+ *
+ * With UDPLOGGER_BINARY = 1 the messages are not formatted on the device: the id of the format
+ * string and the raw arguments are sent (see logformat.h), receiver/log_receiver.cpp decodes them.
+ * In this mode nothing is printed on the serial port.
+ *
  */
 
 #ifndef udplogger_h
@@ -14,24 +27,97 @@
 
 #include <Arduino.h>
 #include <WiFiUdp.h>
+#include <stdarg.h>
+#include "logformat.h"
 
+// log levels
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// messages with a lower level are not compiled in
+#ifndef UDPLOGGER_LEVEL
+#define UDPLOGGER_LEVEL LOG_LEVEL_INFO
+#endif
+
+// size of the ring buffer for formatted messages (bytes)
+#define UDPLOGGER_RING_SIZE 2048
+// max length of one message, longer messages are truncated
+#define UDPLOGGER_MAX_MESSAGE 200
+// max length of the name of the logger
+#define UDPLOGGER_MAX_NAME 24
+// max payload of one UDP datagram (below ethernet MTU, no IP fragmentation)
+#define UDPLOGGER_MAX_DATAGRAM 1400
+// number of datagrams sent per call of handle()
+#define UDPLOGGER_DATAGRAMS_PER_HANDLE 1
+
+// 1 = send binary records (format id + arguments) instead of text lines
+#ifndef UDPLOGGER_BINARY
+#define UDPLOGGER_BINARY 0
+#endif
+// number of different format strings in binary mode (messages with more formats are dropped)
+#define UDPLOGGER_MAX_FORMATS 128
+// period (ms) after which all format strings are sent again, so a restarted receiver learns them
+#define UDPLOGGER_ANNOUNCE_PERIOD 60000
+
+#define LOG_AT_LEVEL(logger, level, format, ...) \
+    do { \
+        if((level) >= UDPLOGGER_LEVEL && (logger).isEnabled(level)){ \
+            (logger).logf_P((level), PSTR(format), ##__VA_ARGS__); \
+        } \
+    } while(0)
+
+#define LOG_DEBUG(logger, format, ...) LOG_AT_LEVEL(logger, LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#define LOG_INFO(logger, format, ...) LOG_AT_LEVEL(logger, LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_WARNING(logger, format, ...) LOG_AT_LEVEL(logger, LOG_LEVEL_WARNING, format, ##__VA_ARGS__)
+#define LOG_ERROR(logger, format, ...) LOG_AT_LEVEL(logger, LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
 
 class UDPLogger{
 
     public:
         UDPLogger();
         UDPLogger(IPAddress interfaceAddr, IPAddress multicastAddr, int port);
-        void setName(String name);
-        void logString(String logmessage);
+        void begin(IPAddress interfaceAddr, IPAddress multicastAddr, int port);
+        void setName(const char *name);
+        void setLevel(uint8_t level);
+        bool isEnabled(uint8_t level) const { return level >= _level; }
+        void logf_P(uint8_t level, const char *format, ...);
+        void vlogf_P(uint8_t level, const char *format, va_list args);
+        void logString(const String &logmessage);
         void logColor24bit(uint32_t color);
+        void handle();
+        void flush();
+        uint32_t getDroppedMessages() const { return _dropped; }
     private:
-        String _name;
+        char _name[UDPLOGGER_MAX_NAME] = "Log";
+        uint8_t _level = UDPLOGGER_LEVEL;
         IPAddress _multicastAddr;
         IPAddress _interfaceAddr;
         int _port;
         WiFiUDP _Udp;
-        char _packetBuffer[100];
-        long _lastSend;
+        // records: level (1 byte), length (1 byte), sequence number (2 bytes), text (without '\0')
+        char _ring[UDPLOGGER_RING_SIZE];
+        uint16_t _head = 0;
+        uint16_t _tail = 0;
+        uint16_t _nextSequence = 0;
+        uint32_t _dropped = 0;
+
+#if UDPLOGGER_BINARY
+        // format strings (in flash) by format id, hashed by address
+        const char *_formats[UDPLOGGER_MAX_FORMATS] = {nullptr};
+        // one bit per format id which was sent to the receiver
+        uint32_t _announced[UDPLOGGER_MAX_FORMATS / 32] = {0};
+        unsigned long _lastAnnounceReset = 0;
+
+        int16_t getFormatId(const char *format);
+        bool announceFormat(uint16_t formatId);
+        uint8_t encodeArguments(uint8_t *out, uint8_t capacity, const char *format, va_list args);
+#endif
+        char *reserveRecord();
+        void commitRecord(char *record, uint8_t level, uint8_t length);
+        bool sendDatagram();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -42,13 +42,18 @@
 #include "tetris.h"
 #include "snake.h"
 #include "pong.h"
+#include "profiler.h"
+#include "clockface.h"
+#include "framestream.h"
+#include "commandrouter.h"
+#include "jsonwriter.h"
 
 
 // ----------------------------------------------------------------------------------
 //                                        CONSTANTS
 // ----------------------------------------------------------------------------------
 
-#define EEPROM_SIZE 30      // size of EEPROM to save persistent variables
+#define EEPROM_SIZE 80      // size of EEPROM to save persistent variables
 #define ADR_NM_START_H 0
 #define ADR_NM_END_H 4
 #define ADR_NM_START_M 8
@@ -57,9 +62,13 @@
 #define ADR_MC_RED 20
 #define ADR_MC_GREEN 22
 #define ADR_MC_BLUE 24
+#define ADR_LANGUAGE 25
+#define ADR_TIMEZONE 26     // TZ string, TZ_MAX_LENGTH bytes
 
 
 #define NEOPIXELPIN 5       // pin to which the NeoPixels are attached
+#define LED_OUTPUT_UART1 0  // 1 = send LED data in background via UART1 (NeoPixels need to be attached to GPIO2 instead of NEOPIXELPIN)
+#define LED_DITHERING 0     // 1 = temporal dithering at low brightness (frames are sent every PERIOD_MATRIXUPDATE, best with LED_OUTPUT_UART1)
 #define NUMPIXELS 125       // number of pixels attached to Attiny85
 #define BUTTONPIN 14        // pin to which the button is attached
 #define LEFT 1
@@ -74,17 +83,17 @@
 #define PERIOD_PONG 10
 #define TIMEOUT_LEDDIRECT 5000
 #define PERIOD_STATECHANGE 10000
-#define PERIOD_NTPUPDATE 30000
+#define PERIOD_NTPRETRY 10000
 #define PERIOD_TIMEVISUUPDATE 1000
 #define PERIOD_MATRIXUPDATE 100
-#define PERIOD_NIGHTMODECHECK 20000
 
 #define SHORTPRESS 100
 #define LONGPRESS 2000
 
 #define CURRENT_LIMIT_LED 2500 // limit the total current sonsumed by LEDs (mA)
 
-#define DEFAULT_SMOOTHING_FACTOR 0.5
+#define DEFAULT_TRANSITION_DURATION 500 // duration of led transitions (ms), independent of PERIOD_MATRIXUPDATE
+#define NIGHTMODE_TRANSITION_DURATION 1000 // duration of fade when nightmode is switched on/off (ms)
 
 // number of colors in colors array
 #define NUM_COLORS 7
@@ -101,6 +110,8 @@ enum direction {right, left, up, down};
 #define NUM_STATES 6
 enum ClockState {st_clock, st_diclock, st_spiral, st_tetris, st_snake, st_pingpong};
 const String stateNames[] = {"Clock", "DiClock", "Sprial", "Tetris", "Snake", "PingPong"};
+// names of the states for /cmd?mode=...
+const char *const modeNames[] = {"clock", "diclock", "spiral", "tetris", "snake", "pingpong"};
 // PERIODS for each state (different for stateAutoChange or Manual mode)
 const uint16_t PERIODS[2][NUM_STATES] = { { PERIOD_TIMEVISUUPDATE, // stateAutoChange = 0
                                             PERIOD_TIMEVISUUPDATE, 
@@ -175,27 +186,39 @@ long lastheartbeat = millis();      // time of last heartbeat sending
 long lastStep = millis();           // time of last animation step
 long lastLEDdirect = 0;             // time of last direct LED command (=> fall back to normal mode after timeout)
 long lastStateChange = millis();    // time of last state change
-long lastNTPUpdate = millis() - (PERIOD_NTPUPDATE-5000);  // time of last NTP update
+long lastNTPUpdate = millis();      // time of last NTP update (or failed attempt)
+unsigned long periodNTPUpdate = 5000; // time until next NTP update (poll interval of ntp or retry period)
 long lastAnimationStep = millis();  // time of last Matrix update
-long lastNightmodeCheck = millis(); // time of last nightmode check
 long buttonPressStart = 0;          // time of push button press start 
 
 // Create necessary global objects
 UDPLogger logger;
 WiFiUDP NTPUDP;
+WiFiUDP frameUDP;                   // receives LED frames (DDP) from external controllers
+FrameStreamDecoder frameDecoder(NUM_LEDS);
+CommandRouter commandRouter;        // commands of the webserver (/cmd)
 NTPClientPlus ntp = NTPClientPlus(NTPUDP, "pool.ntp.org", 1, true);
 LEDMatrix ledmatrix = LEDMatrix(&matrix, brightness, &logger);
+Profiler profiler;
 Tetris mytetris = Tetris(&ledmatrix, &logger);
 Snake mysnake = Snake(&ledmatrix, &logger);
 Pong mypong = Pong(&ledmatrix, &logger);
+#if LED_OUTPUT_UART1
+UART1Output uart1Output;
+#endif
 
-float filterFactor = DEFAULT_SMOOTHING_FACTOR;// stores smoothing factor for led transition
+uint16_t transitionDuration = DEFAULT_TRANSITION_DURATION;// stores duration of led transitions (ms)
 uint8_t currentState = st_clock;              // stores current state
 bool stateAutoChange = false;                 // stores state of automatic state change
 bool nightMode = false;                       // stores state of nightmode
+bool clockNeedsUpdate = true;                 // clock modes redraw only if set (minute change, color, state change)
 uint32_t maincolor_clock = colors24bit[2];    // color of the clock and digital clock
+uint8_t clockLanguage = lang_german;          // language of the clock face (ClockLanguage), has to match the frontplate
 uint32_t maincolor_snake = colors24bit[1];    // color of the random snake animation
 bool apmode = false;                          // stores if WiFi AP mode is active
+bool eepromCommitDeferred = false;            // several settings are changed at once -> one EEPROM commit at the end
+bool eepromCommitPending = false;             // EEPROM was changed while the commit was deferred
+bool commandBatchActive = false;              // handleBatch() executes commands -> only the batch is logged, not each command
 
 // nightmode settings
 int nightModeStartHour = 22;
@@ -203,7 +226,7 @@ int nightModeStartMin = 0;
 int nightModeEndHour = 7;
 int nightModeEndMin = 0;
 
-// Watchdog counter to trigger restart if NTP update was not possible 30 times in a row (5min)
+// Watchdog counter to trigger restart if NTP update was not possible 30 times in a row (about 8min, each update sends a burst of requests)
 int watchdogCounter = 30;
 
 // ----------------------------------------------------------------------------------
@@ -223,6 +246,8 @@ void setup() {
 
   // Load color for clock from EEPROM
   loadMainColor();
+  loadLanguage();
+  loadTimeZone();
 
   // configure button pin as input
   pinMode(BUTTONPIN, INPUT_PULLUP);
@@ -230,6 +255,12 @@ void setup() {
   // setup Matrix LED functions
   ledmatrix.setupMatrix();
   ledmatrix.setCurrentLimit(CURRENT_LIMIT_LED);
+#if LED_OUTPUT_UART1
+  ledmatrix.setOutput(&uart1Output);
+#endif
+  ledmatrix.setDithering(LED_DITHERING);
+  ledmatrix.setTransition(transitionDuration, ease_inout);
+  ledmatrix.setProfiler(&profiler);
 
   // Turn on minutes leds (blue)
   ledmatrix.setMinIndicator(15, colors24bit[6]);
@@ -322,23 +353,27 @@ void setup() {
   // setup OTA
   setupOTA(hostname);
 
+  setupCommands();
   server.on("/cmd", handleCommand); // process commands
+  server.on("/batch", handleBatch); // process several commands at once
   server.on("/data", handleDataRequest); // process datarequests
   server.on("/leddirect", HTTP_POST, handleLEDDirect); // Call the 'handleLEDDirect' function when a POST request is made to URI "/leddirect"
   server.begin();
+
+  // receive LED frames streamed via UDP (DDP)
+  frameUDP.begin(FRAMESTREAM_PORT);
   
   // create UDP Logger to send logging messages via UDP multicast
-  logger = UDPLogger(WiFi.localIP(), logMulticastIP, logMulticastPort);
+  // (messages are queued and sent in loop(), so no delays are needed between them)
+  logger.begin(WiFi.localIP(), logMulticastIP, logMulticastPort);
   logger.setName("Wordclock 2.0");
   logger.logString("Start program\n");
-  delay(10);
   logger.logString("Sketchname: "+ String(__FILE__));
-  delay(10);
   logger.logString("Build: " + String(__TIMESTAMP__));
-  delay(10);
   logger.logString("IP: " + WiFi.localIP().toString());
-  delay(10);
   logger.logString("Reset Reason: " + ESP.getResetReason());
+  // memory report of the static framebuffers (LEDMATRIX_PALETTE_TARGET = 1 saves RAM for the target colors)
+  logger.logString("RAM (bytes) LEDMatrix: " + String(sizeof(ledmatrix)) + ", Tetris: " + String(sizeof(mytetris)) + ", Snake: " + String(sizeof(mysnake)) + ", Pong: " + String(sizeof(mypong)) + ", Palette target: " + String(LEDMATRIX_PALETTE_TARGET));
 
   if(!ESP.getResetReason().equals("Software/System restart")){
     // test quickly each LED
@@ -346,14 +381,14 @@ void setup() {
         for(int c = 0; c < WIDTH; c++){
         matrix.fillScreen(0);
         matrix.drawPixel(c, r, LEDMatrix::color24to16bit(colors24bit[2]));
-        matrix.show();
+        ledmatrix.showStrip();
         delay(10); 
         }
     }
     
     // clear Matrix
     matrix.fillScreen(0);
-    matrix.show();
+    ledmatrix.showStrip();
     delay(200);
 
     // display IP
@@ -376,14 +411,16 @@ void setup() {
   logger.logString("NTP running");
   logger.logString("Time: " +  ntp.getFormattedTime());
   logger.logString("TimeOffset (seconds): " + String(ntp.getTimeOffset()));
+  logger.logString("TimeZone: " + String(ntp.getTimeZone()));
+  ntp.setTimeEventCallback(event_minute, onMinuteChange);
+  ntp.setTimeEventCallback(event_day, onDayChange);
 
   // show the current time for short time in words
   int hours = ntp.getHours24();
   int minutes = ntp.getMinutes();
-  String timeMessage = timeToString(hours, minutes);
-  showStringOnClock(timeMessage, maincolor_clock);
+  showTimeOnClock(hours, minutes, maincolor_clock);
   drawMinuteIndicator(minutes, maincolor_clock);
-  ledmatrix.drawOnMatrixSmooth(filterFactor);
+  ledmatrix.drawOnMatrixSmooth();
 
 
   // init all animation modes
@@ -411,7 +448,9 @@ void setup() {
   if(brightness < 10) brightness = 10;
   logger.logString("Brightness: " + String(brightness));
   ledmatrix.setBrightness(brightness);
-  
+
+  // send all log messages of setup
+  logger.flush();
 }
 
 
@@ -424,39 +463,58 @@ void loop() {
   handleOTA();
   
   // handle Webserver
+  profiler.start(stage_webserver);
   server.handleClient();
+  profiler.stop(stage_webserver);
+
+  // show LED frames streamed via UDP
+  handleFrameStream();
 
   // send regularly heartbeat messages via UDP multicast
   if(millis() - lastheartbeat > PERIOD_HEARTBEAT){
-    logger.logString("Heartbeat, state: " + stateNames[currentState] + ", FreeHeap: " + ESP.getFreeHeap() + ", HeapFrag: " + ESP.getHeapFragmentation() + ", MaxFreeBlock: " + ESP.getMaxFreeBlockSize() + "\n");
+    // two messages, each one has to fit into UDPLOGGER_MAX_MESSAGE
+    LOG_INFO(logger, "Heartbeat, state: %s, FreeHeap: %lu, HeapFrag: %u, MaxFreeBlock: %lu, Frames rendered/skipped: %lu/%lu",
+             stateNames[currentState].c_str(), (unsigned long)ESP.getFreeHeap(), (unsigned)ESP.getHeapFragmentation(), (unsigned long)ESP.getMaxFreeBlockSize(),
+             (unsigned long)ledmatrix.getRenderedFrames(), (unsigned long)ledmatrix.getSkippedFrames());
+    LOG_INFO(logger, "Heartbeat, Current: %umA, Brightness (limited): %u, Limiter activations: %lu, Log dropped: %lu",
+             (unsigned)ledmatrix.getEstimatedCurrent(), (unsigned)ledmatrix.getLimitedBrightness(), (unsigned long)ledmatrix.getLimiterActivations(),
+             (unsigned long)logger.getDroppedMessages());
+    char perf[160];
+    perfReport(perf, sizeof(perf));
+    LOG_INFO(logger, "Perf p50/p99/max (us): %s", perf);
     lastheartbeat = millis();
 
-    // Check wifi status (only if no apmode)
+    // Check wifi status (only if no apmode), indicator pixel in status layer persists while modes redraw the base layer
     if(!apmode && WiFi.status() != WL_CONNECTED){
       Serial.println("connection lost");
-      ledmatrix.gridAddPixel(0, 5, colors24bit[1]);
-      ledmatrix.drawOnMatrixInstant();
+      ledmatrix.layerAddPixel(layer_status, 0, 5, colors24bit[1]);
+    }
+    else{
+      ledmatrix.layerRemovePixel(layer_status, 0, 5);
     }
   }
 
   // handle mode behaviours (trigger loopCycles of different modes depending on current mode)
   if(!nightMode && (millis() - lastStep > PERIODS[stateAutoChange][currentState]) && (millis() - lastLEDdirect > TIMEOUT_LEDDIRECT)){
+    profiler.start(stage_mode);
     switch(currentState){
       // state clock
       case st_clock:
-        {
+        if(clockNeedsUpdate){
           int hours = ntp.getHours24();
           int minutes = ntp.getMinutes();
-          showStringOnClock(timeToString(hours, minutes), maincolor_clock);
+          showTimeOnClock(hours, minutes, maincolor_clock);
           drawMinuteIndicator(minutes, maincolor_clock);
+          clockNeedsUpdate = false;
         }
         break;
       // state diclock
       case st_diclock:
-        {
+        if(clockNeedsUpdate){
           int hours = ntp.getHours24();
           int minutes = ntp.getMinutes();
           showDigitalClock(hours, minutes, maincolor_clock);
+          clockNeedsUpdate = false;
         }
         break;
       // state spiral
@@ -511,13 +569,14 @@ void loop() {
         }
         break;
     }    
+    profiler.stop(stage_mode);
     
     lastStep = millis();
   }
 
   // periodically write colors to matrix
   if(millis() - lastAnimationStep > PERIOD_MATRIXUPDATE){
-    ledmatrix.drawOnMatrixSmooth(filterFactor);
+    ledmatrix.drawOnMatrixSmooth();
     lastAnimationStep = millis();
   }
 
@@ -533,64 +592,24 @@ void loop() {
     lastStateChange = millis();
   }
 
-  // NTP time update
-  if(millis() - lastNTPUpdate > PERIOD_NTPUPDATE){
-    int res = ntp.updateNTP();
-    if(res == 0){
-      ntp.calcDate();
-      logger.logString("NTP-Update successful");
-      logger.logString("Time: " +  ntp.getFormattedTime());
-      logger.logString("Date: " +  ntp.getFormattedDate());
-      logger.logString("Day of Week (Mon=1, Sun=7): " +  String(ntp.getDayOfWeek()));
-      logger.logString("TimeOffset (seconds): " + String(ntp.getTimeOffset()));
-      logger.logString("Summertime: " + String(ntp.updateSWChange()));
-      lastNTPUpdate = millis();
-      watchdogCounter = 30;
-    }
-    else if(res == -1){
-      logger.logString("NTP-Update not successful. Reason: Timeout");
-      lastNTPUpdate += 10000;
-      watchdogCounter--;
-    }
-    else if(res == 1){
-      logger.logString("NTP-Update not successful. Reason: Too large time difference");
-      logger.logString("Time: " +  ntp.getFormattedTime());
-      logger.logString("Date: " +  ntp.getFormattedDate());
-      logger.logString("Day of Week (Mon=1, Sun=7): " +  ntp.getDayOfWeek());
-      logger.logString("TimeOffset (seconds): " + String(ntp.getTimeOffset()));
-      logger.logString("Summertime: " + String(ntp.updateSWChange()));
-      lastNTPUpdate += 10000;
-      watchdogCounter--;
-    }
-    else {
-      logger.logString("NTP-Update not successful. Reason: NTP time not valid (<1970)");
-      lastNTPUpdate += 10000;
-      watchdogCounter--;
-    }
-
-    logger.logString("Watchdog Counter: " + String(watchdogCounter));
-    if(watchdogCounter <= 0){
-        logger.logString("Trigger restart due to watchdog...");
-        delay(100);
-        ESP.restart();
-    }
-    
+  // NTP time update (non-blocking: the request is sent here, the answer is polled in the following loops)
+  if(!ntp.isUpdatePending() && millis() - lastNTPUpdate > periodNTPUpdate){
+    ntp.requestNTP();
   }
-
-  // check if nightmode need to be activated
-  if(millis() - lastNightmodeCheck > PERIOD_NIGHTMODECHECK){
-    int hours = ntp.getHours24();
-    int minutes = ntp.getMinutes();
-    
-    if(hours == nightModeStartHour && minutes == nightModeStartMin){
-      setNightmode(true);
+  if(ntp.isUpdatePending()){
+    profiler.start(stage_ntp);
+    int res = ntp.pollNTP();
+    profiler.stop(stage_ntp);
+    if(res != NTP_UPDATE_PENDING){
+      handleNTPResult(res);
     }
-    else if(hours == nightModeEndHour && minutes == nightModeEndMin){
-      setNightmode(false);
-    }
-    
-    lastNightmodeCheck = millis();
   }
+
+  // fire minute/hour/day callbacks (only compares millis() with the next minute deadline in between)
+  ntp.handleTimeEvents();
+
+  // send queued log messages (one datagram per loop)
+  logger.handle();
  
 }
 
@@ -599,13 +618,86 @@ void loop() {
 //                                        OTHER FUNCTIONS
 // ----------------------------------------------------------------------------------
 
+/**
+ * @brief Handle the result of a NTP update (log, retry and watchdog)
+ * 
+ * @param res result of ntp.pollNTP()
+ */
+void handleNTPResult(int res){
+  if(res == NTP_UPDATE_SUCCESS){
+    ntp.calcDate();
+    LOG_INFO(logger, "NTP-Update successful");
+    logNTPState();
+    lastNTPUpdate = millis();
+    periodNTPUpdate = ntp.getPollInterval();
+    watchdogCounter = 30;
+  }
+  else if(res == NTP_UPDATE_TIMEOUT){
+    LOG_WARNING(logger, "NTP-Update not successful. Reason: Timeout");
+    lastNTPUpdate = millis();
+    periodNTPUpdate = PERIOD_NTPRETRY;
+    watchdogCounter--;
+  }
+  else if(res == NTP_UPDATE_DIFFERENCE){
+    LOG_WARNING(logger, "NTP-Update not successful. Reason: Too large time difference");
+    logNTPState();
+    lastNTPUpdate = millis();
+    periodNTPUpdate = PERIOD_NTPRETRY;
+    watchdogCounter--;
+  }
+  else {
+    LOG_WARNING(logger, "NTP-Update not successful. Reason: Invalid answer (time <1970 or kiss-o'-death)");
+    lastNTPUpdate = millis();
+    periodNTPUpdate = PERIOD_NTPRETRY;
+    watchdogCounter--;
+  }
+
+  LOG_INFO(logger, "Watchdog Counter: %d", watchdogCounter);
+  if(watchdogCounter <= 0){
+    LOG_ERROR(logger, "Trigger restart due to watchdog...");
+    logger.flush();
+    delay(100);
+    ESP.restart();
+  }
+}
+
+/**
+ * @brief Callback of ntp on each minute boundary: trigger clock redraw and check nightmode
+ * 
+ * @param epochTime local epoch time (s)
+ */
+void onMinuteChange(unsigned long epochTime){
+  int hours = (epochTime % 86400) / 3600;
+  int minutes = (epochTime % 3600) / 60;
+  clockNeedsUpdate = true;
+
+  // check if nightmode need to be activated
+  if(hours == nightModeStartHour && minutes == nightModeStartMin){
+    setNightmode(true);
+  }
+  else if(hours == nightModeEndHour && minutes == nightModeEndMin){
+    setNightmode(false);
+  }
+}
+
+/**
+ * @brief Callback of ntp on each day boundary: update date and summer/winter time
+ * 
+ * @param epochTime local epoch time (s)
+ */
+void onDayChange(unsigned long epochTime){
+  ntp.calcDate();
+  LOG_INFO(logger, "Date: %s", ntp.getFormattedDate().c_str());
+}
+
 /**
  * @brief call entry action of given state
  * 
  * @param state 
  */
 void entryAction(uint8_t state){
-  filterFactor = 0.5;
+  transitionDuration = DEFAULT_TRANSITION_DURATION;
+  clockNeedsUpdate = true;
   switch(state){
     case st_spiral:
       // Init spiral with normal drawing mode
@@ -613,7 +705,7 @@ void entryAction(uint8_t state){
       spiral(true, sprialDir, WIDTH-6);
       break;
     case st_tetris:
-      filterFactor = 1.0; // no smoothing
+      transitionDuration = 0; // no smoothing
       if(stateAutoChange){
         randomtetris(true);
       }
@@ -626,7 +718,7 @@ void entryAction(uint8_t state){
         randomsnake(true, 8, colors24bit[1], -1);
       }
       else{
-        filterFactor = 1.0; // no smoothing
+        transitionDuration = 0; // no smoothing
         mysnake.initGame();
       }
       break;
@@ -635,11 +727,12 @@ void entryAction(uint8_t state){
         mypong.initGame(2);
       }
       else{
-        filterFactor = 1.0; // no smoothing
+        transitionDuration = 0; // no smoothing
         mypong.initGame(1);
       }
       break;
   }
+  ledmatrix.setTransition(transitionDuration, ease_inout);
 }
 
 /**
@@ -657,9 +750,10 @@ void stateChange(uint8_t newState){
   // set new state
   currentState = newState;
   entryAction(currentState);
-  logger.logString("State change to: " + stateNames[currentState]);
-  delay(5);
-  logger.logString("FreeMemory=" + String(ESP.getFreeHeap()));
+  if(!commandBatchActive){
+    LOG_INFO(logger, "State change to: %s", stateNames[currentState].c_str());
+    LOG_DEBUG(logger, "FreeMemory=%lu", (unsigned long)ESP.getFreeHeap());
+  }
 }
 
 /**
@@ -667,52 +761,81 @@ void stateChange(uint8_t newState){
  * 
  * Allows the control of all LEDs from external source. 
  * It will overwrite the normal program for 5 seconds.
- * A 11x11 picture can be sent as base64 encoded string to be displayed on matrix.
+ * - binary body (Content-Type: application/octet-stream): 3 bytes (red, green, blue) per LED 
+ *   in the order y * WIDTH + x, followed by the minute indicators (exactly 3 * NUM_LEDS bytes, ESP8266 core 3.x)
+ * - form argument: base64 encoded 11x11 picture with 4 bytes (red, green, blue, unused) per pixel
  * 
  */
 void handleLEDDirect() {
   if (server.method() != HTTP_POST) {
     server.send(405, "text/plain", "Method Not Allowed");
-  } else {
-    String message = "POST data was:\n";
-    /*logger.logString(message);
-    delay(10);
-    for (uint8_t i = 0; i < server.args(); i++) {
-      message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
-      logger.logString(server.arg(i));
-      delay(10);
-    }*/
-    if(server.args() == 1){
-      String data = String(server.arg(0));
-      int dataLength = data.length();
-      //char byteArray[dataLength];
-      //data.toCharArray(byteArray, dataLength);
-
-      // base64 decoding
-      char base64data[dataLength];
-      data.toCharArray(base64data, dataLength);
-      int base64dataLen = dataLength;
-      int decodedLength = Base64.decodedLength(base64data, base64dataLen);
-      char byteArray[decodedLength];
-      Base64.decode(byteArray, base64data, base64dataLen);
-
-      /*for(int i = 0; i < 10; i++){
-        logger.logString(String((int)(byteArray[i])));
-        delay(10);
-      }*/
-
-
-      for(int i = 0; i < dataLength; i += 4) {
-        uint8_t red = byteArray[i]; // red
-        uint8_t green = byteArray[i + 1]; // green
-        uint8_t blue = byteArray[i + 2]; // blue
-        ledmatrix.gridAddPixel((i/4) % WIDTH, (i/4) / HEIGHT, LEDMatrix::Color24bit(red, green, blue));
-      }
-      ledmatrix.drawOnMatrixInstant();
+    return;
+  }
+  if(server.args() != 1){
+    server.send(400, "text/plain", "Bad Request");
+    return;
+  }
 
-      lastLEDdirect = millis();
+  const String &data = server.arg(0);
+  if(server.argName(0) == "plain"){
+    // raw body: taken over directly from the receive buffer of the webserver.
+    // Needs ESP8266 core 3.x, core 2.x cuts the body at the first 0x00 -> rejected as wrong length
+    if(data.length() != 3 * NUM_LEDS){
+      server.send(400, "text/plain", "Bad Request: expected " + String(3 * NUM_LEDS) + " bytes");
+      return;
+    }
+    ledmatrix.gridSetPixels(0, (const uint8_t*)data.c_str(), NUM_LEDS);
+  }
+  else{
+    // base64 decoding into a local buffer, the decoder stops when the picture is complete
+    char byteArray[WIDTH * HEIGHT * 4];
+    Base64Decoder decoder;
+    decoder.begin(byteArray, sizeof(byteArray));
+    decoder.write(data.c_str(), data.length());
+    int decodedLength = decoder.end();
+
+    for(int i = 0; i + 2 < decodedLength; i += 4) {
+      uint8_t red = byteArray[i]; // red
+      uint8_t green = byteArray[i + 1]; // green
+      uint8_t blue = byteArray[i + 2]; // blue
+      ledmatrix.gridAddPixel((i/4) % WIDTH, (i/4) / WIDTH, LEDMatrix::Color24bit(red, green, blue));
     }
-    server.send(200, "text/plain", message);
+  }
+  ledmatrix.drawOnMatrixInstant();
+
+  lastLEDdirect = millis();
+  clockNeedsUpdate = true; // redraw clock after timeout of direct control
+  server.send(200, "text/plain", "OK");
+}
+
+/**
+ * @brief Show LED frames streamed via UDP (DDP). The pixel data of all received packets is written
+ * directly into the LEDMatrix, the matrix is drawn once if a packet completed a frame.
+ * Like /leddirect it overwrites the normal program until no frame was received for TIMEOUT_LEDDIRECT.
+ * 
+ */
+void handleFrameStream(){
+  static uint8_t packet[FRAMESTREAM_MAX_PACKET];
+  bool push = false;
+  while(frameUDP.parsePacket() > 0){
+    int length = frameUDP.read(packet, sizeof(packet));
+    frameUDP.flush();
+    FramePacket frame;
+    if(length <= 0 || !frameDecoder.decode(packet, length, millis(), frame)){
+      continue;
+    }
+    if(millis() - lastLEDdirect > TIMEOUT_LEDDIRECT){
+      LOG_INFO(logger, "Frame stream from %s started (frames: %lu, lost: %lu, dropped: %lu, invalid: %lu)", frameUDP.remoteIP().toString().c_str(),
+               (unsigned long)frameDecoder.getFrames(), (unsigned long)frameDecoder.getLostPackets(),
+               (unsigned long)frameDecoder.getDroppedPackets(), (unsigned long)frameDecoder.getInvalidPackets());
+    }
+    ledmatrix.gridSetPixels(frame.firstPixel, frame.data, frame.pixels);
+    push |= frame.push;
+    lastLEDdirect = millis();
+    clockNeedsUpdate = true; // redraw clock after timeout of direct control
+  }
+  if(push){
+    ledmatrix.drawOnMatrixInstant();
   }
 }
 
@@ -726,7 +849,7 @@ void handleButton(){
   // check rising edge
   if(buttonPressed == true && lastButtonState == false){
     // button press start
-    logger.logString("Button press started");
+    LOG_DEBUG(logger, "Button press started");
     buttonPressStart = millis();
   }
   // check falling edge
@@ -734,13 +857,13 @@ void handleButton(){
     // button press ended
     if((millis() - buttonPressStart) > LONGPRESS){
       // longpress -> nightmode
-      logger.logString("Button press ended - longpress");
+      LOG_INFO(logger, "Button press ended - longpress");
 
       setNightmode(true);
     }
     else if((millis() - buttonPressStart) > SHORTPRESS){
       // shortpress -> state change 
-      logger.logString("Button press ended - shortpress");
+      LOG_INFO(logger, "Button press ended - shortpress");
 
       if(nightMode){
         setNightmode(false);
@@ -760,10 +883,11 @@ void handleButton(){
 
 void setMainColor(uint8_t red, uint8_t green, uint8_t blue){
   maincolor_clock = LEDMatrix::Color24bit(red, green, blue);
+  clockNeedsUpdate = true;
   EEPROM.put(ADR_MC_RED, red);
   EEPROM.put(ADR_MC_GREEN, green);
   EEPROM.put(ADR_MC_BLUE, blue);
-  EEPROM.commit();
+  commitEEPROM();
 }
 
 /**
@@ -782,233 +906,484 @@ void loadMainColor(){
   }
 }
 
+/**
+ * @brief Set time zone and save it in EEPROM
+ * 
+ * @param timeZone parsed time zone
+ */
+void setTimeZone(const TimeZone &timeZone){
+  ntp.setTimeZone(timeZone);
+  clockNeedsUpdate = true;
+  char buffer[TZ_MAX_LENGTH] = {0};
+  strncpy(buffer, timeZone.getString(), TZ_MAX_LENGTH - 1);
+  EEPROM.put(ADR_TIMEZONE, buffer);
+  commitEEPROM();
+}
+
+/**
+ * @brief Load time zone from EEPROM
+ * 
+ */
+void loadTimeZone(){
+  char tz[TZ_MAX_LENGTH];
+  EEPROM.get(ADR_TIMEZONE, tz);
+  tz[TZ_MAX_LENGTH - 1] = '\0';
+  // EEPROM not initialized -> keep time zone of constructor (CET/CEST)
+  ntp.setTimeZone(tz);
+}
+
+/**
+ * @brief Register the commands of the webserver ("/cmd?name=value")
+ * 
+ */
+void setupCommands(){
+  commandRouter.add("led", cmdLED);
+  commandRouter.add("mode", cmdMode);
+  commandRouter.add("nightmode", cmdNightmode);
+  commandRouter.add("setting", cmdSetting);
+  commandRouter.add("resetwifi", cmdResetWifi);
+  commandRouter.add("language", cmdLanguage);
+  commandRouter.add("timezone", cmdTimeZone);
+  commandRouter.add("stateautochange", cmdStateAutoChange);
+  commandRouter.add("tetris", cmdTetris);
+  commandRouter.add("snake", cmdSnake);
+  commandRouter.add("pong", cmdPong);
+}
+
 /**
  * @brief Handler for handling commands sent to "/cmd" url
  * 
  */
 void handleCommand() {
-  // receive command and handle accordingly
-  for (uint8_t i = 0; i < server.args(); i++) {
-    Serial.print(server.argName(i));
-    Serial.print(F(": "));
-    Serial.println(server.arg(i));
+  const String &name = server.argName(0);
+  const String &value = server.arg(0);
+  LOG_DEBUG(logger, "Command via Webserver: %s=%s", name.c_str(), value.c_str());
+
+  // the setting command writes several values -> one commit
+  deferEEPROMCommit(true);
+  CommandResult result = commandRouter.dispatch(name.c_str(), value.c_str());
+  deferEEPROMCommit(false);
+  if(result == cmd_unknown){
+    LOG_WARNING(logger, "Unknown command: %s", name.c_str());
+    server.send(400, "text/plain", "Unknown command");
   }
-  
-  if (server.argName(0) == "led") // the parameter which was sent to this server is led color
-  {
-    String colorstr = server.arg(0) + "-";
-    String redstr = split(colorstr, '-', 0);
-    String greenstr= split(colorstr, '-', 1);
-    String bluestr = split(colorstr, '-', 2);
-    logger.logString(colorstr);
-    logger.logString("r: " + String(redstr.toInt()));
-    logger.logString("g: " + String(greenstr.toInt()));
-    logger.logString("b: " + String(bluestr.toInt()));
-    // set new main color
-    setMainColor(redstr.toInt(), greenstr.toInt(), bluestr.toInt());
-  }
-  else if (server.argName(0) == "mode") // the parameter which was sent to this server is mode change
-  {
-    String modestr = server.arg(0);
-    logger.logString("Mode change via Webserver to: " + modestr);
-    // set current mode/state accordant sent mode
-    if(modestr == "clock"){
-      stateChange(st_clock);
-    }
-    else if(modestr == "diclock"){
-      stateChange(st_diclock);
-    }
-    else if(modestr == "spiral"){
-      stateChange(st_spiral);
-    }
-    else if(modestr == "tetris"){
-      stateChange(st_tetris);
-    }
-    else if(modestr == "snake"){
-      stateChange(st_snake);
-    }
-    else if(modestr == "pingpong"){
-      stateChange(st_pingpong);
-    } 
-  }
-  else if(server.argName(0) == "nightmode"){
-    String modestr = server.arg(0);
-    logger.logString("Nightmode change via Webserver to: " + modestr);
-    if(modestr == "1") setNightmode(true);
-    else setNightmode(false);
-  }
-  else if(server.argName(0) == "setting"){
-    String timestr = server.arg(0) + "-";
-    logger.logString("Nightmode setting change via Webserver to: " + timestr);
-    nightModeStartHour = split(timestr, '-', 0).toInt();
-    nightModeStartMin = split(timestr, '-', 1).toInt();
-    nightModeEndHour = split(timestr, '-', 2).toInt();
-    nightModeEndMin = split(timestr, '-', 3).toInt();
-    brightness = split(timestr, '-', 4).toInt();
-    if(brightness < 10) brightness = 10;
-    if(nightModeStartHour < 0 || nightModeStartHour > 23) nightModeStartHour = 22;
-    if(nightModeStartMin < 0 || nightModeStartMin > 59) nightModeStartMin = 0;
-    if(nightModeEndHour < 0 || nightModeEndHour > 23) nightModeEndHour = 7;
-    if(nightModeEndMin < 0 || nightModeEndMin > 59) nightModeEndMin = 0;
-    writeIntEEPROM(ADR_NM_START_H, nightModeStartHour);
-    writeIntEEPROM(ADR_NM_START_M, nightModeStartMin);
-    writeIntEEPROM(ADR_NM_END_H, nightModeEndHour);
-    writeIntEEPROM(ADR_NM_END_M, nightModeEndMin);
-    writeIntEEPROM(ADR_BRIGHTNESS, brightness);
-    logger.logString("Nightmode starts at: " + String(nightModeStartHour) + ":" + String(nightModeStartMin));
-    logger.logString("Nightmode ends at: " + String(nightModeEndHour) + ":" + String(nightModeEndMin));
-    logger.logString("Brightness: " + String(brightness));
-    ledmatrix.setBrightness(brightness);
-  }
-  else if (server.argName(0) == "resetwifi"){
-    wifiManager.resetSettings();
-    // run LED test.
-    for(int r = 0; r < HEIGHT; r++){
-      for(int c = 0; c < WIDTH; c++){
-        matrix.fillScreen(0);
-        matrix.drawPixel(c, r, LEDMatrix::color24to16bit(colors24bit[2]));
-        matrix.show();
-        delay(10); 
-        }
-    }
-    
-    // clear Matrix
-    matrix.fillScreen(0);
-    matrix.show();
-    delay(200);
+  else if(result == cmd_invalid){
+    LOG_WARNING(logger, "Invalid value of command %s: %s", name.c_str(), value.c_str());
+    server.send(400, "text/plain", "Invalid value");
   }
-  else if(server.argName(0) == "stateautochange"){
-    String modestr = server.arg(0);
-    logger.logString("stateAutoChange change via Webserver to: " + modestr);
-    if(modestr == "1") stateAutoChange = true;
-    else stateAutoChange = false;
-  }
-  else if(server.argName(0) == "tetris"){
-    String cmdstr = server.arg(0);
-    logger.logString("Tetris cmd via Webserver to: " + cmdstr);
-    if(cmdstr == "up"){
-      mytetris.ctrlUp();
-    }
-    else if(cmdstr == "left"){
-      mytetris.ctrlLeft();
-    }
-    else if(cmdstr == "right"){
-      mytetris.ctrlRight();
-    }
-    else if(cmdstr == "down"){
-      mytetris.ctrlDown();
-    }
-    else if(cmdstr == "play"){
-      mytetris.ctrlStart();
-    }
-    else if(cmdstr == "pause"){
-      mytetris.ctrlPlayPause();
-    }
+  else{
+    server.send(204, "text/plain", "No Content"); // this page doesn't send back content --> 204
   }
-  else if(server.argName(0) == "snake"){
-    String cmdstr = server.arg(0);
-    logger.logString("Snake cmd via Webserver to: " + cmdstr);
-    if(cmdstr == "up"){
-      mysnake.ctrlUp();
-    }
-    else if(cmdstr == "left"){
-      mysnake.ctrlLeft();
-    }
-    else if(cmdstr == "right"){
-      mysnake.ctrlRight();
-    }
-    else if(cmdstr == "down"){
-      mysnake.ctrlDown();
-    }
-    else if(cmdstr == "new"){
-      mysnake.initGame();
+}
+
+/**
+ * @brief Handler for "/batch?name=value&name=value...": executes several commands of "/cmd" in one request 
+ * (GET or POST with form data). All commands are checked first, if one of them is unknown or invalid 
+ * nothing is changed. Otherwise all commands are executed in the given order and the settings are saved 
+ * with one EEPROM commit. The handlers don't log while commandBatchActive is set, only the batch is logged.
+ * 
+ * Response: {"status":"ok","commands":n} or {"status":"unknown"|"invalid","index":i} (400),
+ * {"status":"failed","index":i} (500) if command i fails on execution although it passed the check
+ * (stops there, the commands in front of it stay executed)
+ */
+void handleBatch() {
+  uint8_t numCommands = server.args();
+  for(uint8_t i = 0; i < numCommands; i++){
+    CommandResult result = commandRouter.check(server.argName(i).c_str(), server.arg(i).c_str());
+    if(result != cmd_ok){
+      const char *status = (result == cmd_unknown) ? "unknown" : "invalid";
+      LOG_WARNING(logger, "Batch rejected, %s command %u: %s=%s", status, i, server.argName(i).c_str(), server.arg(i).c_str());
+      server.send(400, "application/json", "{\"status\":\"" + String(status) + "\",\"index\":" + String(i) + "}");
+      return;
     }
   }
-  else if(server.argName(0) == "pong"){
-    String cmdstr = server.arg(0);
-    logger.logString("Pong cmd via Webserver to: " + cmdstr);
-    if(cmdstr == "up"){
-      mypong.ctrlUp(1);
-    }
-    else if(cmdstr == "down"){
-      mypong.ctrlDown(1);
-    }
-    else if(cmdstr == "new"){
-      mypong.initGame(1);
-    }
+
+  deferEEPROMCommit(true);
+  commandBatchActive = true;
+  uint8_t executed = 0;
+  CommandResult result = cmd_ok;
+  while(executed < numCommands && result == cmd_ok){
+    result = commandRouter.dispatch(server.argName(executed).c_str(), server.arg(executed).c_str());
+    executed++;
   }
-  server.send(204, "text/plain", "No Content"); // this page doesn't send back content --> 204
+  commandBatchActive = false;
+  deferEEPROMCommit(false);
+  if(result != cmd_ok){
+    // the handler rejected a value which passed the check, the commands in front of it are executed
+    uint8_t index = executed - 1;
+    LOG_WARNING(logger, "Batch failed at command %u: %s=%s", index, server.argName(index).c_str(), server.arg(index).c_str());
+    server.send(500, "application/json", "{\"status\":\"failed\",\"index\":" + String(index) + "}");
+    return;
+  }
+  LOG_INFO(logger, "Batch of %u commands via Webserver", numCommands);
+  server.send(200, "application/json", "{\"status\":\"ok\",\"commands\":" + String(numCommands) + "}");
 }
 
 /**
- * @brief Splits a string at given character and return specified element
+ * @brief Command led=red-green-blue: set the main color
  * 
- * @param s string to split
- * @param parser separating character
- * @param index index of the element to return
- * @return String 
+ * @param args arguments of the command
+ * @return CommandResult 
  */
-String split(String s, char parser, int index) {
-  String rs="";
-  int parserIndex = index;
-  int parserCnt=0;
-  int rFromIndex=0, rToIndex=-1;
-  while (index >= parserCnt) {
-    rFromIndex = rToIndex+1;
-    rToIndex = s.indexOf(parser,rFromIndex);
-    if (index == parserCnt) {
-      if (rToIndex == 0 || rToIndex == -1) return "";
-      return s.substring(rFromIndex,rToIndex);
-    } else parserCnt++;
-  }
-  return rs;
+CommandResult cmdLED(CommandArgs &args){
+  uint8_t red, green, blue;
+  if(!args.nextColor(red, green, blue) || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  if(!commandBatchActive){
+    LOG_INFO(logger, "Color change via Webserver to: r: %u g: %u b: %u", red, green, blue);
+  }
+  setMainColor(red, green, blue);
+  return cmd_ok;
 }
 
 /**
- * @brief Handler for GET requests
+ * @brief Command mode=clock|diclock|spiral|tetris|snake|pingpong: change the current mode
  * 
+ * @param args arguments of the command
+ * @return CommandResult 
  */
-void handleDataRequest() {
-  // receive data request and handle accordingly
-  for (uint8_t i = 0; i < server.args(); i++) {
-    Serial.print(server.argName(i));
-    Serial.print(F(": "));
-    Serial.println(server.arg(i));
+CommandResult cmdMode(CommandArgs &args){
+  int8_t state = args.nextEnum(modeNames, NUM_STATES);
+  if(state < 0 || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  if(!commandBatchActive){
+    LOG_INFO(logger, "Mode change via Webserver to: %s", modeNames[state]);
+  }
+  stateChange(state);
+  return cmd_ok;
+}
+
+/**
+ * @brief Command nightmode=1|0: switch nightmode on or off
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdNightmode(CommandArgs &args){
+  bool on;
+  if(!args.nextBool(on) || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  if(!commandBatchActive){
+    LOG_INFO(logger, "Nightmode change via Webserver to: %d", on);
+  }
+  setNightmode(on);
+  return cmd_ok;
+}
+
+/**
+ * @brief Command setting=hh-mm-hh-mm-brightness: set start and end of nightmode and the brightness
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdSetting(CommandArgs &args){
+  int startHour, startMin, endHour, endMin;
+  long newBrightness;
+  if(!args.nextTime(startHour, startMin) || !args.nextTime(endHour, endMin) || !args.nextInt(newBrightness, 0, 255) || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  nightModeStartHour = startHour;
+  nightModeStartMin = startMin;
+  nightModeEndHour = endHour;
+  nightModeEndMin = endMin;
+  brightness = (newBrightness < 10) ? 10 : newBrightness;
+  writeIntEEPROM(ADR_NM_START_H, nightModeStartHour);
+  writeIntEEPROM(ADR_NM_START_M, nightModeStartMin);
+  writeIntEEPROM(ADR_NM_END_H, nightModeEndHour);
+  writeIntEEPROM(ADR_NM_END_M, nightModeEndMin);
+  writeIntEEPROM(ADR_BRIGHTNESS, brightness);
+  if(!commandBatchActive){
+    LOG_INFO(logger, "Nightmode starts at: %d:%d", nightModeStartHour, nightModeStartMin);
+    LOG_INFO(logger, "Nightmode ends at: %d:%d", nightModeEndHour, nightModeEndMin);
+    LOG_INFO(logger, "Brightness: %u", brightness);
+  }
+  ledmatrix.setBrightness(brightness);
+  return cmd_ok;
+}
+
+/**
+ * @brief Command resetwifi: delete the WiFi credentials and run a LED test
+ * 
+ * @param args arguments of the command (none)
+ * @return CommandResult 
+ */
+CommandResult cmdResetWifi(CommandArgs &args){
+  if(!args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  wifiManager.resetSettings();
+  // run LED test.
+  for(int r = 0; r < HEIGHT; r++){
+    for(int c = 0; c < WIDTH; c++){
+      matrix.fillScreen(0);
+      matrix.drawPixel(c, r, LEDMatrix::color24to16bit(colors24bit[2]));
+      ledmatrix.showStrip();
+      delay(10); 
+      }
   }
   
+  // clear Matrix
+  matrix.fillScreen(0);
+  ledmatrix.showStrip();
+  delay(200);
+  // strip was modified directly -> ledmatrix needs to write all leds again
+  ledmatrix.forceRedraw();
+  return cmd_ok;
+}
+
+/**
+ * @brief Command language=de|en|it: change the language of the clock
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdLanguage(CommandArgs &args){
+  int8_t language = findLanguage(args.getString());
+  if(language < 0){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  if(!commandBatchActive){
+    LOG_INFO(logger, "Language change via Webserver to: %s", args.getString());
+  }
+  setLanguage(language);
+  return cmd_ok;
+}
+
+/**
+ * @brief Command timezone=<POSIX TZ string>: change the time zone
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdTimeZone(CommandArgs &args){
+  // the same parsed time zone is validated and applied
+  TimeZone timeZone;
+  if(!timeZone.parse(args.getString())){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  setTimeZone(timeZone);
+  if(!commandBatchActive){
+    LOG_INFO(logger, "TimeZone change via Webserver to: %s", args.getString());
+    logNTPState();
+  }
+  return cmd_ok;
+}
+
+/**
+ * @brief Command stateautochange=1|0: switch automatic change of the modes on or off
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdStateAutoChange(CommandArgs &args){
+  bool on;
+  if(!args.nextBool(on) || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  if(!commandBatchActive){
+    LOG_INFO(logger, "stateAutoChange change via Webserver to: %d", on);
+  }
+  stateAutoChange = on;
+  return cmd_ok;
+}
+
+/**
+ * @brief Command tetris=up|left|right|down|play|pause: control of the game
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdTetris(CommandArgs &args){
+  static const char *const controls[] = {"up", "left", "right", "down", "play", "pause"};
+  int8_t control = args.nextEnum(controls, 6);
+  if(control < 0 || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  switch(control){
+    case 0: mytetris.ctrlUp(); break;
+    case 1: mytetris.ctrlLeft(); break;
+    case 2: mytetris.ctrlRight(); break;
+    case 3: mytetris.ctrlDown(); break;
+    case 4: mytetris.ctrlStart(); break;
+    case 5: mytetris.ctrlPlayPause(); break;
+  }
+  if(!commandBatchActive){
+    LOG_DEBUG(logger, "Tetris cmd via Webserver: %s", args.getString());
+  }
+  return cmd_ok;
+}
+
+/**
+ * @brief Command snake=up|left|right|down|new: control of the game
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdSnake(CommandArgs &args){
+  static const char *const controls[] = {"up", "left", "right", "down", "new"};
+  int8_t control = args.nextEnum(controls, 5);
+  if(control < 0 || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  switch(control){
+    case 0: mysnake.ctrlUp(); break;
+    case 1: mysnake.ctrlLeft(); break;
+    case 2: mysnake.ctrlRight(); break;
+    case 3: mysnake.ctrlDown(); break;
+    case 4: mysnake.initGame(); break;
+  }
+  if(!commandBatchActive){
+    LOG_DEBUG(logger, "Snake cmd via Webserver: %s", args.getString());
+  }
+  return cmd_ok;
+}
+
+/**
+ * @brief Command pong=up|down|new: control of the game (player 1)
+ * 
+ * @param args arguments of the command
+ * @return CommandResult 
+ */
+CommandResult cmdPong(CommandArgs &args){
+  static const char *const controls[] = {"up", "down", "new"};
+  int8_t control = args.nextEnum(controls, 3);
+  if(control < 0 || !args.atEnd()){
+    return cmd_invalid;
+  }
+  if(args.isCheckOnly()){
+    return cmd_ok;
+  }
+  switch(control){
+    case 0: mypong.ctrlUp(1); break;
+    case 1: mypong.ctrlDown(1); break;
+    case 2: mypong.initGame(1); break;
+  }
+  if(!commandBatchActive){
+    LOG_DEBUG(logger, "Pong cmd via Webserver: %s", args.getString());
+  }
+  return cmd_ok;
+}
+
+/**
+ * @brief Handler for GET requests, the JSON answer is sent in chunks while it is created
+ * 
+ */
+void handleDataRequest() {
+  // receive data request and handle accordingly
   if (server.argName(0) == "key") // the parameter which was sent to this server is led color
   {
-    String message = "{";
-    String keystr = server.arg(0);
+    LOG_DEBUG(logger, "Data request %s, max free block: %lu", server.arg(0).c_str(), (unsigned long)ESP.getMaxFreeBlockSize());
+    char buffer[JSONWRITER_BUFFER_SIZE];
+    JsonWriter json(buffer, sizeof(buffer), sendJSONChunk);
+    beginJSONResponse();
+    json.beginObject();
+    const String &keystr = server.arg(0);
     if(keystr == "mode"){
-      message += "\"mode\":\"" + stateNames[currentState] + "\"";
-      message += ",";
-      message += "\"modeid\":\"" + String(currentState) + "\"";
-      message += ",";
-      message += "\"stateAutoChange\":\"" + String(stateAutoChange) + "\"";
-      message += ",";
-      message += "\"nightMode\":\"" + String(nightMode) + "\"";
-      message += ",";
-      message += "\"nightModeStart\":\"" + leadingZero2Digit(nightModeStartHour) + "-" + leadingZero2Digit(nightModeStartMin) + "\"";
-      message += ",";
-      message += "\"nightModeEnd\":\"" + leadingZero2Digit(nightModeEndHour) + "-" + leadingZero2Digit(nightModeEndMin) + "\"";
-      message += ",";
-      message += "\"brightness\":\"" + String(brightness) + "\"";
+      json.add("mode", stateNames[currentState].c_str());
+      json.addFormatted("modeid", "%u", currentState);
+      json.addFormatted("stateAutoChange", "%d", stateAutoChange);
+      json.addFormatted("nightMode", "%d", nightMode);
+      json.addFormatted("nightModeStart", "%02d-%02d", nightModeStartHour, nightModeStartMin);
+      json.addFormatted("nightModeEnd", "%02d-%02d", nightModeEndHour, nightModeEndMin);
+      json.addFormatted("brightness", "%u", brightness);
+      json.add("language", getLanguageName(clockLanguage));
+      json.add("timezone", ntp.getTimeZone());
+    }
+    else if(keystr == "perf"){
+      // timing of the stages of the main loop in microseconds
+      for(uint8_t i = 0; i < NUM_PROFILER_STAGES; i++){
+        ProfilerStage stage = (ProfilerStage)i;
+        json.beginObject(Profiler::getStageName(stage));
+        json.addUnsigned("p50", profiler.getPercentile(stage, 50));
+        json.addUnsigned("p99", profiler.getPercentile(stage, 99));
+        json.addUnsigned("max", profiler.getMax(stage));
+        json.addUnsigned("samples", profiler.getSamples(stage));
+        json.endObject();
+      }
+    }
+    json.endObject();
+    endJSONResponse(json);
+    if(json.hasFailed()){
+      LOG_ERROR(logger, "Data request %s: invalid JSON nesting", keystr.c_str());
     }
-    message += "}";
-    server.send(200, "application/json", message);
+    LOG_DEBUG(logger, "Data request %s sent (%lu bytes), max free block: %lu", keystr.c_str(), (unsigned long)json.getLength(), (unsigned long)ESP.getMaxFreeBlockSize());
   }
 }
 
+/**
+ * @brief Start a chunked JSON response (HTTP 200), the content follows with sendJSONChunk()
+ * 
+ */
+void beginJSONResponse(){
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+}
+
+/**
+ * @brief Output function of JsonWriter: send a chunk of the response
+ * 
+ * @param data 
+ * @param length 
+ */
+void sendJSONChunk(const char *data, uint16_t length){
+  server.sendContent(data, length);
+}
+
+/**
+ * @brief Send the rest of the JSON text and finish the chunked response
+ * 
+ * @param json writer of the response
+ */
+void endJSONResponse(JsonWriter &json){
+  json.flush();
+  server.sendContent("");
+}
+
 /**
  * @brief Set the nightmode state
  * 
  * @param on true -> nightmode on
  */
 void setNightmode(bool on){
+  ledmatrix.setTransition(NIGHTMODE_TRANSITION_DURATION, ease_linear);
   ledmatrix.gridFlush();
-  ledmatrix.drawOnMatrixSmooth(0.2);
+  ledmatrix.drawOnMatrixSmooth();
+  ledmatrix.setTransition(transitionDuration, ease_inout);
   nightMode = on;
+  clockNeedsUpdate = true;
 }
 
 /**
@@ -1019,9 +1394,35 @@ void setNightmode(bool on){
  */
 void writeIntEEPROM(int address, int value){
   EEPROM.put(address, value);
+  commitEEPROM();
+}
+
+/**
+ * @brief Commit the changes of the EEPROM to the flash, postponed while deferEEPROMCommit(true) is active
+ * 
+ */
+void commitEEPROM(){
+  if(eepromCommitDeferred){
+    eepromCommitPending = true;
+    return;
+  }
   EEPROM.commit();
 }
 
+/**
+ * @brief Postpone the EEPROM commits while several settings are changed, 
+ * when switched off again all changes are committed at once
+ * 
+ * @param defer true -> postpone commits, false -> commit pending changes
+ */
+void deferEEPROMCommit(bool defer){
+  eepromCommitDeferred = defer;
+  if(!defer && eepromCommitPending){
+    eepromCommitPending = false;
+    EEPROM.commit();
+  }
+}
+
 /**
  * @brief Read value from EEPROM
  * 
@@ -1035,16 +1436,35 @@ int readIntEEPROM(int address){
 }
 
 /**
- * @brief Convert Integer to String with leading zero
+ * @brief Write a short report of the stage timings for the heartbeat, e.g. "webserver 12/80/950, mode 40/300/310, ..."
  * 
- * @param value 
- * @return String 
+ * @param buffer buffer for the report
+ * @param size size of the buffer
  */
-String leadingZero2Digit(int value){
-  String msg = "";
-  if(value < 10){
-    msg = "0";
+void perfReport(char *buffer, size_t size){
+  size_t length = 0;
+  buffer[0] = '\0';
+  for(uint8_t i = 0; i < NUM_PROFILER_STAGES && length < size; i++){
+    ProfilerStage stage = (ProfilerStage)i;
+    int written = snprintf_P(buffer + length, size - length, PSTR("%s%s %lu/%lu/%lu"), (i > 0) ? ", " : "", Profiler::getStageName(stage),
+                             (unsigned long)profiler.getPercentile(stage, 50), (unsigned long)profiler.getPercentile(stage, 99), (unsigned long)profiler.getMax(stage));
+    if(written < 0){
+      break;
+    }
+    length += written;
   }
-  msg += String(value);
-  return msg;
+}
+
+/**
+ * @brief Log time, date and summer/winter time state of ntp
+ * 
+ */
+void logNTPState(){
+  LOG_INFO(logger, "Time: %02d:%02d:%02d", ntp.getHours24(), ntp.getMinutes(), ntp.getSeconds());
+  LOG_INFO(logger, "Date: %s", ntp.getFormattedDate().c_str());
+  LOG_INFO(logger, "Day of Week (Mon=1, Sun=7): %u", ntp.getDayOfWeek());
+  LOG_INFO(logger, "TimeOffset (seconds): %ld", ntp.getTimeOffset());
+  LOG_INFO(logger, "TimeZone: %s, daylight saving time: %d", ntp.getTimeZone(), (int)ntp.isDST());
+  LOG_INFO(logger, "NTP offset: %ld ms, delay: %ld ms, drift: %ld ppb, poll interval: %lu s",
+           ntp.getLastOffset(), ntp.getLastDelay(), ntp.getDrift(), ntp.getPollInterval() / 1000);
 }